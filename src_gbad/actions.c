@@ -11,45 +11,35 @@
 //
 //******************************************************************************
 
-#include <stdio.h>
-#include <stdlib.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "gbad.h"
-#include "actions.h"
-
-#include "y.tab.h"
-#include "lex.yy.h"
-
-int yyparse(void *arg);
-void yyerror(void *arg, const char *str);
-
-extern int yylineno;
-char *GP_file_name;
-
-#define ERR_STR_LEN 64
-
-char GP_err_str[ERR_STR_LEN];
 
 //******************************************************************************
 // NAME: GP_read_graph
 //
 // INPUTS: (Graph_Info *info)
-//         (char *inputFileName) - specifies the input file to read 
+//         (char *inputFileName) - specifies the input file to read
 // RETURN: (int) - 0 if success, 1 if error
 //
-// PURPOSE: Reads in the graph input file (MDL/FSM format).  The field 
+// PURPOSE: Reads in the graph input file (MDL/FSM format).  The field
 // info->xp_graph specifies the type of input file to be read in.
-// 
+//
 // If info->xp_graph is TRUE, then inputFileName is treated as a graph and read
 // into the info->graph field.  If info->graph already contains a graph (i.e.
 // info->graph is non-NULL) then info->posGraphVertexListSize,
 // info->posGraphEdgeListSize, and info->vertexOffset are used to append the
 // input graph onto info->graph.  Upon return, info->posEgsVertexIndices will
-// contain vertex indices of where positive egs begin.  Also, the values in 
+// contain vertex indices of where positive egs begin.  Also, the values in
 // posGraphVertexListSize, posGraphEdgeListSize, and vertexOffset will have
-// been updated.
+// been updated.  If info->plain_graph is also TRUE, the file holds a single
+// graph without XP headers (as read by the gm tool).
 //
-// If info->xp_graph is FALSE, then inputFileName is treated as containing 
+// If info->xp_graph is FALSE, then inputFileName is treated as containing
 // PS examples, which are read into the info->preSubs field.  If info->preSubs
 // is non-NULL, then numPreSubs is used to append the graphs found in the input
 // file to the end of preSubs.  Upon return, the value in numPreSubs will have
@@ -58,436 +48,1168 @@ char GP_err_str[ERR_STR_LEN];
 // The filed info->labelList is used to store labels found in the input file
 // and is assumed to be non-NULL.  The info->directed field is used to
 // determine if 'e' edges are directed.
+//
+// The file is mapped into memory and scanned in place.  All parsing state
+// is kept in a GraphParser, so several files may be parsed at once, as
+// long as they are read into different Graph_Info's and label lists.
+// Large files of XP examples are split into chunks parsed by
+// info->numThreads threads.
 //******************************************************************************
+
 int GP_read_graph(Graph_Info *info, char *inputFileName)
 {
+   GraphParser parser;
+   struct stat fileStat;
+   void *text = NULL;
+   int input;
    int ret;
-   FILE *tmp = yyin;
-	
-   FILE *input = fopen(inputFileName, "r");
-   if (input == NULL)
+
+   input = open(inputFileName, O_RDONLY);
+   if ((input < 0) || (fstat(input, &fileStat) != 0))
    {
       fprintf(stderr, "Unable to open input file %s.\n", inputFileName);
       exit(1);
    }
-	
-   GP_file_name = inputFileName;
-	
-   yyin = input;
-   yylineno = 1;
-   ret = yyparse((void *)info);
-   yyin = tmp;
-   fclose(input);
-   
+   if (fileStat.st_size > 0)
+   {
+      text = mmap(NULL, fileStat.st_size, PROT_READ, MAP_PRIVATE, input, 0);
+      if (text == MAP_FAILED)
+      {
+         fprintf(stderr, "Unable to map input file %s.\n", inputFileName);
+         exit(1);
+      }
+      madvise(text, fileStat.st_size, MADV_SEQUENTIAL);
+   }
+
+   GP_init_parser(&parser, info, inputFileName, (char *) text,
+                  (ULONG) fileStat.st_size);
+   if (GP_parse_in_parallel(&parser))
+      ret = 0;
+   else
+      ret = GP_parse(&parser);
+   GP_free_parser(&parser);
+
+   if (text != NULL)
+      munmap(text, fileStat.st_size);
+   close(input);
+
    return ret;
 }
 
 //******************************************************************************
-// NAME:    GP_add_xp
+// NAME:    GP_init_parser
 //
-// INPUTS:  input - file pointer to read the input graph from
-//          GP_info - structure used to store the graph read in
+// INPUTS:  parser   - parser to initialize
+//          info     - structure used to store the graph read in
+//          fileName - name of file being parsed, for error messages
+//          text     - contents of file
+//          length   - length of contents
 //
 // RETURN:  none
 //
-// PURPOSE: this function sets up and calls yyparse to parse the input graph
+// PURPOSE: set up a parser to parse the given text
 //
 //******************************************************************************
-void GP_add_xp(void *arg, int num)
+void GP_init_parser(GraphParser *parser, Graph_Info *info, char *fileName,
+                    const char *text, ULONG length)
 {
-   Graph_Info *GP_info = (Graph_Info *)arg;
-	
-   if (!GP_info->xp_graph)
+   ULONG i;
+
+   parser->info = info;
+   parser->fileName = fileName;
+   parser->next = text;
+   parser->end = text + length;
+   parser->lineNo = 1;
+   parser->token = text;
+   parser->tokenLength = 0;
+   parser->tokenLineNo = 1;
+   parser->tokenQuoted = FALSE;
+   parser->numCachedLabels = 0;
+   parser->chunk = FALSE;
+   parser->failed = FALSE;
+   parser->egOffset = 0;
+   parser->labelMap = NULL;
+   parser->vertexBase = 0;
+   parser->edgeBase = 0;
+   parser->labelCacheSize = LABEL_CACHE_SIZE;
+   parser->labelCache = (LabelCacheEntry *)
+      malloc(sizeof(LabelCacheEntry) * LABEL_CACHE_SIZE);
+   if (parser->labelCache == NULL)
+      OutOfMemoryError("GP_init_parser:labelCache");
+   for (i = 0; i < LABEL_CACHE_SIZE; i++)
+      parser->labelCache[i].labelIndex = 0;
+}
+
+//******************************************************************************
+// NAME:    GP_free_parser
+//
+// INPUTS:  parser - parser to free
+//
+// RETURN:  none
+//
+// PURPOSE: free the memory held by a parser (but not the text it parsed)
+//
+//******************************************************************************
+void GP_free_parser(GraphParser *parser)
+{
+   free(parser->labelCache);
+   parser->labelCache = NULL;
+}
+
+//******************************************************************************
+// NAME:    GP_parse
+//
+// INPUTS:  parser - parser set up by GP_init_parser
+//
+// RETURN:  (int) - 0 if success, 1 if syntax error
+//
+// PURPOSE: parse the graphs in the parser's text, which are given by
+//
+//          graph   := example+
+//          example := ("XP" | "PS") "#" number element+
+//          element := "v" number label
+//                   | ("e" | "d" | "u") number number label
+//          label   := number | quoted string | word
+//
+//          where keywords are all lower or all upper case, strings are quoted with
+//          double or single quotes and may contain backslash escapes, and
+//          "//", "/* */" and "%" comments are ignored.  A plain graph has
+//          elements only.  Graph elements are added as they are parsed; on
+//          a syntax error, an error message is printed and the elements
+//          added so far are kept.
+//
+//******************************************************************************
+int GP_parse(GraphParser *parser)
+{
+   Graph_Info *info = parser->info;
+   BOOLEAN inExample = info->plain_graph; // TRUE if elements may follow
+   BOOLEAN emptyExample = FALSE;          // TRUE if example has no elements
+   BOOLEAN directed;
+   BOOLEAN xp;
+   ULONG number;
+   ULONG source;
+   ULONG target;
+   ULONG labelIndex;
+
+   while ((! parser->failed) && GP_next_token(parser))
    {
-      yyerror(NULL, "invalid graph type, found PS, expecting XP.");
-      exit(1);	
+      if ((! info->plain_graph) &&
+          ((xp = GP_token_is(parser, "xp")) || GP_token_is(parser, "ps")))
+      {
+         if (emptyExample)
+            return GP_syntax_error(parser);
+         if ((! GP_next_token(parser)) || (! GP_token_is(parser, "#")) ||
+             (! GP_next_token(parser)) || (! GP_read_number(parser, &number)))
+            return GP_syntax_error(parser);
+         if (xp)
+            GP_add_xp(parser, number);
+         else
+            GP_add_ps(parser, number);
+         inExample = TRUE;
+         emptyExample = TRUE;
+      }
+      else if (inExample && GP_token_is(parser, "v"))
+      {
+         if ((! GP_next_token(parser)) || (! GP_read_number(parser, &number)) ||
+             (! GP_next_label(parser)))
+            return GP_syntax_error(parser);
+         labelIndex = GP_read_label(parser);
+         GP_add_vertex(parser, number, labelIndex);
+         emptyExample = FALSE;
+      }
+      else if (inExample &&
+               (GP_token_is(parser, "e") || GP_token_is(parser, "d") ||
+                GP_token_is(parser, "u")))
+      {
+         if (GP_token_is(parser, "e"))
+            directed = info->directed;
+         else
+            directed = GP_token_is(parser, "d");
+         if ((! GP_next_token(parser)) || (! GP_read_number(parser, &source)) ||
+             (! GP_next_token(parser)) || (! GP_read_number(parser, &target)) ||
+             (! GP_next_label(parser)))
+            return GP_syntax_error(parser);
+         labelIndex = GP_read_label(parser);
+         GP_add_edge(parser, directed, source, target, labelIndex);
+         emptyExample = FALSE;
+      }
+      else
+         return GP_syntax_error(parser);
    }
-	
-   if (num != GP_info->numPosEgs+1)
+   if (parser->failed)
+      return 1;
+   if (emptyExample || (! inExample))
+      return GP_syntax_error(parser);
+
+   return 0;
+}
+
+//******************************************************************************
+// NAME:    GP_parse_in_parallel
+//
+// INPUTS:  parser - parser set up by GP_init_parser for a file of XP
+//                   examples
+//
+// RETURN:  (BOOLEAN) - TRUE if the file was parsed; FALSE if it is not
+//                      worth splitting or a chunk could not be parsed on
+//                      its own, in which case it should be parsed serially
+//
+// PURPOSE: split the parser's text at XP headers into chunks, which
+//          info->numThreads worker threads parse into graphs and label
+//          lists of their own.  The chunks are then merged, in order, into
+//          info->graph, so the result is the same as parsing serially;
+//          once each chunk's place in the graph is known, the workers copy
+//          the chunks there.
+//          A chunk fails if it has a syntax or numbering error, or if it
+//          was split inside a comment or quoted string spanning an XP
+//          header; nothing is then added to the graph, and parsing the
+//          file serially reports any error.
+//
+//******************************************************************************
+BOOLEAN GP_parse_in_parallel(GraphParser *parser)
+{
+   Graph_Info *info = parser->info;
+   GraphParseQueue queue;
+   Graph_Info *chunkInfos;
+   const char *start;
+   const char *split;
+   ULONG length = parser->end - parser->next;
+   ULONG numThreads = info->numThreads;
+   ULONG maxChunks;
+   ULONG numEgs;
+   BOOLEAN parsed;
+   ULONG c, i;
+
+   if ((! info->xp_graph) || (info->plain_graph) || (numThreads < 2))
+      return FALSE;
+   maxChunks = numThreads * LOAD_CHUNKS_PER_THREAD;
+   if (maxChunks > length / LOAD_CHUNK_MIN_SIZE)
+      maxChunks = length / LOAD_CHUNK_MIN_SIZE;
+   if (maxChunks < 2)
+      return FALSE;
+
+   // split text into chunks of about equal length, each starting at an XP
+   // header (except the first, which starts at the start of the text)
+   queue.chunks = (GraphParser *) malloc(sizeof(GraphParser) * maxChunks);
+   chunkInfos = (Graph_Info *) malloc(sizeof(Graph_Info) * maxChunks);
+   if ((queue.chunks == NULL) || (chunkInfos == NULL))
+      OutOfMemoryError("GP_parse_in_parallel:chunks");
+   queue.numChunks = 0;
+   start = parser->next;
+   for (c = 1; c <= maxChunks; c++)
    {
-      snprintf(GP_err_str, ERR_STR_LEN, "invalid XP number, found %d, expecting %lu",
-               num, GP_info->numPosEgs+1);
-      yyerror(NULL, GP_err_str);
-      exit(1);
+      split = parser->end;
+      if (c < maxChunks)
+      {
+         split = parser->next + ((length / maxChunks) * c);
+         if (split <= start)
+            split = start + 1;
+         split = GP_find_example(start, parser->end, split);
+      }
+      if (split > start)
+      {
+         chunkInfos[queue.numChunks].graph = NULL;
+         chunkInfos[queue.numChunks].labelList = AllocateLabelList();
+         chunkInfos[queue.numChunks].preSubs = NULL;
+         chunkInfos[queue.numChunks].numPreSubs = 0;
+         chunkInfos[queue.numChunks].numPosEgs = 0;
+         chunkInfos[queue.numChunks].posEgsVertexIndices = NULL;
+         chunkInfos[queue.numChunks].directed = info->directed;
+         chunkInfos[queue.numChunks].posGraphVertexListSize = 0;
+         chunkInfos[queue.numChunks].posGraphEdgeListSize = 0;
+         chunkInfos[queue.numChunks].vertexOffset = 0;
+         chunkInfos[queue.numChunks].xp_graph = TRUE;
+         chunkInfos[queue.numChunks].plain_graph = FALSE;
+         chunkInfos[queue.numChunks].numThreads = 1;
+         GP_init_parser(& queue.chunks[queue.numChunks],
+                        & chunkInfos[queue.numChunks], parser->fileName,
+                        start, split - start);
+         queue.chunks[queue.numChunks].chunk = TRUE;
+         queue.numChunks++;
+         start = split;
+      }
    }
-	
-   if (GP_info->graph == NULL)
+
+   parsed = FALSE;
+   if (queue.numChunks > 1)
    {
-      GP_info->graph = AllocateGraph(0,0);
+      if (numThreads > queue.numChunks)
+         numThreads = queue.numChunks;
+      queue.graph = NULL;
+      GP_run_workers(&queue, numThreads);
+
+      // chunks must parse, and number their examples on from the last
+      parsed = TRUE;
+      numEgs = info->numPosEgs;
+      for (c = 0; c < queue.numChunks; c++)
+      {
+         if ((queue.chunks[c].failed) || (queue.chunks[c].egOffset != numEgs))
+            parsed = FALSE;
+         numEgs += chunkInfos[c].numPosEgs;
+      }
+      if (parsed)
+      {
+         GP_merge_chunks(parser, queue.chunks, queue.numChunks);
+         queue.graph = info->graph;
+         GP_run_workers(&queue, numThreads);
+      }
    }
-	
-   GP_info->numPosEgs++;
-   GP_info->vertexOffset = GP_info->graph->numVertices;
-   GP_info->posEgsVertexIndices = AddVertexIndex(
-   GP_info->posEgsVertexIndices,
-   GP_info->numPosEgs, GP_info->vertexOffset);
+
+   for (c = 0; c < queue.numChunks; c++)
+   {
+      free(queue.chunks[c].labelMap);
+      FreeGraph(chunkInfos[c].graph);
+      for (i = 0; i < chunkInfos[c].labelList->numLabels; i++)
+         if (chunkInfos[c].labelList->labels[i].labelType == STRING_LABEL)
+            free(chunkInfos[c].labelList->labels[i].labelValue.stringLabel);
+      FreeLabelList(chunkInfos[c].labelList);
+      free(chunkInfos[c].posEgsVertexIndices);
+      GP_free_parser(& queue.chunks[c]);
+   }
+   free(chunkInfos);
+   free(queue.chunks);
+   return parsed;
 }
 
 //******************************************************************************
-// NAME:    GP_add_ps
+// NAME:    GP_parse_worker
+//
+// INPUTS:  arg - GraphParseQueue shared by workers
+//
+// RETURN:  (void *) - NULL
+//
+// PURPOSE: thread function taking chunks from the queue until none are
+//          left, parsing each chunk, or copying it into the queue's graph
+//          if set
+//
+//******************************************************************************
+void *GP_parse_worker(void *arg)
+{
+   GraphParseQueue *queue = (GraphParseQueue *) arg;
+   ULONG c;
+
+   while (TRUE)
+   {
+      pthread_mutex_lock(& queue->mutex);
+      c = queue->nextChunk;
+      if (c < queue->numChunks)
+         queue->nextChunk++;
+      pthread_mutex_unlock(& queue->mutex);
+      if (c >= queue->numChunks)
+         break;
+
+      if (queue->graph != NULL)
+         GP_copy_chunk(queue->graph, & queue->chunks[c]);
+      else if (GP_parse(& queue->chunks[c]) != 0)
+         queue->chunks[c].failed = TRUE;
+   }
+   return NULL;
+}
+
+//******************************************************************************
+// NAME:    GP_run_workers
 //
-// INPUTS:  arg - pointer to the argument passed to yyparse
-//          num - the number of the PS instance
+// INPUTS:  queue      - chunks to parse or copy
+//          numThreads - number of worker threads
 //
 // RETURN:  none
 //
-// PURPOSE: function called by the parser when it finds a new PS instance
+// PURPOSE: run worker threads until all of the queue's chunks are done
+//
+//******************************************************************************
+void GP_run_workers(GraphParseQueue *queue, ULONG numThreads)
+{
+   pthread_t *threads;
+   ULONG t;
+
+   queue->nextChunk = 0;
+   threads = (pthread_t *) malloc(sizeof(pthread_t) * numThreads);
+   if (threads == NULL)
+      OutOfMemoryError("GP_run_workers:threads");
+   pthread_mutex_init(& queue->mutex, NULL);
+   for (t = 0; t < numThreads; t++)
+      if (pthread_create(& threads[t], NULL, GP_parse_worker, queue) != 0)
+      {
+         fprintf(stderr, "GP_run_workers: unable to create thread\n");
+         exit(1);
+      }
+   for (t = 0; t < numThreads; t++)
+      pthread_join(threads[t], NULL);
+   pthread_mutex_destroy(& queue->mutex);
+   free(threads);
+}
+
+//******************************************************************************
+// NAME:    GP_find_example
 //
-// NOTE:    PS graphs are not yet supported by gbad-fsm.  A PS instance will
-//          cause a parse error.
+// INPUTS:  start - start of text
+//          end   - end of text
+//          from  - where in text to start looking
+//
+// RETURN:  (const char *) - start of first XP header at or after from, or
+//                           end if none
+//
+// PURPOSE: find a place to split the text between examples.  Only headers
+//          at the start of a line (after any spaces or tabs) are found.
 //
 //******************************************************************************
-void GP_add_ps(void *arg, int num)
+const char *GP_find_example(const char *start, const char *end,
+                            const char *from)
 {
-   Graph_Info *GP_info = (Graph_Info *)arg;
-	
-   if (GP_info->xp_graph)
+   const char *line;
+   const char *next;
+
+   // back up to start of line
+   line = from;
+   while ((line > start) && (line[-1] != NEWLINE))
+      line--;
+   while (line < end)
    {
-      yyerror(NULL, "invalid graph type, found PS, expecting XP.");
-      exit(1);	
+      next = line;
+      while ((next < end) && ((*next == SPACE) || (*next == TAB)))
+         next++;
+      if ((next >= from) && (next + 2 < end) &&
+          (((next[0] == 'X') && (next[1] == 'P')) ||
+           ((next[0] == 'x') && (next[1] == 'p'))) &&
+          ((next[2] == SPACE) || (next[2] == TAB)))
+         return next;
+      line = memchr(next, NEWLINE, end - next);
+      if (line == NULL)
+         return end;
+      line++;
    }
-	
-   if (num != GP_info->numPreSubs+1)
+   return end;
+}
+
+//******************************************************************************
+// NAME:    GP_merge_chunks
+//
+// INPUTS:  parser    - parser of the whole file
+//          chunks    - parsers of the file's chunks, in order
+//          numChunks - number of chunks
+//
+// RETURN:  none
+//
+// PURPOSE: make room in info->graph for the graphs parsed from the
+//          chunks, and find where each chunk's vertices and edges go.
+//          Each chunk's labels are stored in info->labelList, through the
+//          parser's label cache, in the order the chunk found them, so
+//          labels get the same indices as when parsing serially.  The
+//          chunks' examples are added to info->posEgsVertexIndices.  The
+//          vertices and edges are then copied by GP_copy_chunk.
+//
+//******************************************************************************
+void GP_merge_chunks(GraphParser *parser, GraphParser *chunks,
+                     ULONG numChunks)
+{
+   Graph_Info *info = parser->info;
+   Graph *graph;
+   Graph *chunkGraph;
+   LabelList *chunkLabels;
+   Label label;
+   ULONG numVertices;
+   ULONG numEdges;
+   ULONG c, i;
+
+   if (info->graph == NULL)
+      info->graph = AllocateGraph(0,0);
+   graph = info->graph;
+
+   // make room for all chunks' vertices and edges
+   numVertices = graph->numVertices;
+   numEdges = graph->numEdges;
+   for (c = 0; c < numChunks; c++)
    {
-      snprintf(GP_err_str, ERR_STR_LEN, "invalid PS number, found %d, expecting %lu",
-               num, GP_info->numPreSubs+1);
-      yyerror(NULL, GP_err_str);
-      exit(1);
+      numVertices += chunks[c].info->graph->numVertices;
+      numEdges += chunks[c].info->graph->numEdges;
    }
-	
-   GP_info->numPreSubs++;
-   GP_info->preSubs = (Graph **) realloc(GP_info->preSubs, (sizeof(Graph *) * GP_info->numPreSubs));
-   if (GP_info->preSubs == NULL)
+   if (numVertices > info->posGraphVertexListSize)
    {
-      OutOfMemoryError("ReadSubGraphsFromFile:subGraphs");
+      info->posGraphVertexListSize = numVertices;
+      graph->vertices = (Vertex *)
+         realloc(graph->vertices, sizeof(Vertex) * numVertices);
+      if (graph->vertices == NULL)
+         OutOfMemoryError("GP_merge_chunks:vertices");
    }
-	
-   GP_info->preSubs[GP_info->numPreSubs - 1] = AllocateGraph(0, 0);
-   GP_info->graph = GP_info->preSubs[GP_info->numPreSubs - 1];
-   GP_info->posGraphVertexListSize = 0;
-   GP_info->posGraphEdgeListSize = 0;
+   if (numEdges > info->posGraphEdgeListSize)
+   {
+      info->posGraphEdgeListSize = numEdges;
+      graph->edges = (Edge *) realloc(graph->edges, sizeof(Edge) * numEdges);
+      if (graph->edges == NULL)
+         OutOfMemoryError("GP_merge_chunks:edges");
+   }
+
+   for (c = 0; c < numChunks; c++)
+   {
+      chunkGraph = chunks[c].info->graph;
+      chunkLabels = chunks[c].info->labelList;
+      chunks[c].labelMap =
+         (ULONG *) malloc(sizeof(ULONG) * (chunkLabels->numLabels + 1));
+      if (chunks[c].labelMap == NULL)
+         OutOfMemoryError("GP_merge_chunks:labelMap");
+      for (i = 0; i < chunkLabels->numLabels; i++)
+      {
+         label = chunkLabels->labels[i];
+         if (label.labelType == STRING_LABEL)
+            chunks[c].labelMap[i] =
+               GP_store_label(parser, &label, label.labelValue.stringLabel,
+                              strlen(label.labelValue.stringLabel));
+         else
+            chunks[c].labelMap[i] = GP_store_label(parser, &label, NULL, 0);
+      }
+
+      chunks[c].vertexBase = graph->numVertices;
+      chunks[c].edgeBase = graph->numEdges;
+      for (i = 0; i < chunks[c].info->numPosEgs; i++)
+      {
+         info->numPosEgs++;
+         info->vertexOffset =
+            chunks[c].info->posEgsVertexIndices[i] + chunks[c].vertexBase;
+         info->posEgsVertexIndices = AddVertexIndex(info->posEgsVertexIndices,
+                                                    info->numPosEgs,
+                                                    info->vertexOffset);
+      }
+      graph->numVertices += chunkGraph->numVertices;
+      graph->numEdges += chunkGraph->numEdges;
+   }
+   FreeGraphFingerprint(graph);
+   FreeVertexLabelIndex(graph);
+   FreeEdgeTypeIndex(graph);
 }
 
 //******************************************************************************
-// NAME:    GP_add_vertex_i
+// NAME:    GP_copy_chunk
 //
-// INPUTS:  arg   - pointer to the argument passed to yyparse
-//          v     - the number of the vertex
-//          label - the label of the vertex
+// INPUTS:  graph - graph the chunks are merged into
+//          chunk - parser of chunk, placed by GP_merge_chunks
 //
 // RETURN:  none
 //
-// PURPOSE: function called by the parser when it finds a vertex with an integer
-//          label
+// PURPOSE: copy a chunk's vertices and edges into its place in the graph,
+//          shifting vertex and edge indices and mapping labels.  The
+//          vertices' edge lists are moved, rather than copied, so the
+//          chunk graph is left without vertices.
 //
 //******************************************************************************
-void GP_add_vertex_i(void *arg, int v, int label)
+void GP_copy_chunk(Graph *graph, GraphParser *chunk)
 {
-   Graph_Info *GP_info = (Graph_Info *)arg;
-	
-   ULONG labelIndex;
-   Label graph_label;
-	
-   if (v+GP_info->vertexOffset != (GP_info->graph->numVertices + 1))
+   Graph *chunkGraph = chunk->info->graph;
+   Vertex *vertex;
+   Edge *edge;
+   ULONG i, j;
+
+   for (i = 0; i < chunkGraph->numVertices; i++)
    {
-      snprintf(GP_err_str, ERR_STR_LEN, "invalid vertex number, found %d, expecting %lu",
-               v, (GP_info->graph->numVertices + 1)-GP_info->vertexOffset);
-      yyerror(NULL, GP_err_str);
-      exit(1);
+      vertex = & graph->vertices[chunk->vertexBase + i];
+      *vertex = chunkGraph->vertices[i];
+      vertex->label = chunk->labelMap[vertex->label];
+      vertex->originalVertexIndex += chunk->vertexBase;
+      for (j = 0; j < vertex->numEdges; j++)
+         vertex->edges[j] += chunk->edgeBase;
    }
-	
-   graph_label.labelType = NUMERIC_LABEL;
-   graph_label.labelValue.numericLabel = (double)label;
-	
-   labelIndex = StoreLabel(&graph_label, GP_info->labelList);
-   AddVertex(GP_info->graph, labelIndex, &(GP_info->posGraphVertexListSize), v);
+   for (i = 0; i < chunkGraph->numEdges; i++)
+   {
+      edge = & graph->edges[chunk->edgeBase + i];
+      *edge = chunkGraph->edges[i];
+      edge->vertex1 += chunk->vertexBase;
+      edge->vertex2 += chunk->vertexBase;
+      edge->label = chunk->labelMap[edge->label];
+      edge->originalEdgeIndex += chunk->edgeBase;
+   }
+   chunkGraph->numVertices = 0; // edge lists now belong to graph
+}
+
+//******************************************************************************
+// NAME:    GP_next_token
+//
+// INPUTS:  parser - parser whose next token to scan
+//
+// RETURN:  (BOOLEAN) - FALSE if there are no more tokens
+//
+// PURPOSE: skip whitespace and comments, and scan the next token, which is
+//          either a quoted string (including its quotes) or a word ended by
+//          whitespace or a "%" comment.  The token is left in place in the
+//          parser's text.  The token of an unterminated string is just its
+//          opening quote.
+//
+//******************************************************************************
+BOOLEAN GP_next_token(GraphParser *parser)
+{
+   const char *next = parser->next;
+   const char *end = parser->end;
+   const char *close;
+   const char *escape;
+   char quote;
+
+   // skip whitespace and comments
+   while (next < end)
+   {
+      if ((*next == SPACE) || (*next == TAB) || (*next == CARRIAGERETURN))
+         next++;
+      else if (*next == NEWLINE)
+      {
+         parser->lineNo++;
+         next++;
+      }
+      else if ((*next == COMMENT) ||
+               ((*next == '/') && (next + 1 < end) && (next[1] == '/')))
+      {
+         next = memchr(next, NEWLINE, end - next);
+         if (next == NULL)
+            next = end;
+      }
+      else if ((*next == '/') && (next + 1 < end) && (next[1] == '*'))
+      {
+         close = next + 2;
+         while (((close = memchr(close, '*', end - close)) != NULL) &&
+                ((close + 1 >= end) || (close[1] != '/')))
+            close++;
+         if ((close == NULL) && (parser->chunk))
+            parser->failed = TRUE; // comment may continue in next chunk
+         close = (close == NULL) ? end : close + 2;
+         parser->lineNo += GP_count_lines(next, close);
+         next = close;
+      }
+      else
+         break;
+   }
+   parser->token = next;
+   parser->tokenLineNo = parser->lineNo;
+   parser->tokenQuoted = FALSE;
+   if (next == end)
+   {
+      parser->tokenLength = 0;
+      parser->next = end;
+      return FALSE;
+   }
+
+   if ((*next == DOUBLEQUOTE) || (*next == SINGLEQUOTE))
+   {
+      // find closing quote not escaped by a backslash
+      quote = *next;
+      close = next + 1;
+      while ((close = memchr(close, quote, end - close)) != NULL)
+      {
+         escape = close;
+         while ((escape > next + 1) && (escape[-1] == '\\'))
+            escape--;
+         if (((close - escape) % 2) == 0)
+            break;
+         close++;
+      }
+      if (close == NULL)
+         close = next + 1; // unterminated string, token is just its quote
+      else
+      {
+         close++;
+         parser->lineNo += GP_count_lines(next, close);
+      }
+      parser->tokenQuoted = TRUE;
+   }
+   else
+   {
+      close = next + 1;
+      while ((close < end) && (*close != SPACE) && (*close != TAB) &&
+             (*close != CARRIAGERETURN) && (*close != NEWLINE) &&
+             (*close != COMMENT))
+         close++;
+   }
+   parser->tokenLength = close - next;
+   parser->next = close;
+   return TRUE;
+}
+
+//******************************************************************************
+// NAME:    GP_next_label
+//
+// INPUTS:  parser - parser whose next token to scan
+//
+// RETURN:  (BOOLEAN) - FALSE if there are no more tokens, or the next token
+//                      is an unterminated string
+//
+// PURPOSE: scan the next token, which should be a label
+//
+//******************************************************************************
+BOOLEAN GP_next_label(GraphParser *parser)
+{
+   if (! GP_next_token(parser))
+      return FALSE;
+   return ((! parser->tokenQuoted) || (parser->tokenLength > 1));
+}
+
+//******************************************************************************
+// NAME:    GP_count_lines
+//
+// INPUTS:  start - start of text
+//          end   - end of text
+//
+// RETURN:  (ULONG) - number of newlines in text
+//
+// PURPOSE: count the lines spanned by a comment or quoted string
+//
+//******************************************************************************
+ULONG GP_count_lines(const char *start, const char *end)
+{
+   ULONG numLines = 0;
+
+   while ((start = memchr(start, NEWLINE, end - start)) != NULL)
+   {
+      numLines++;
+      start++;
+   }
+   return numLines;
+}
+
+//******************************************************************************
+// NAME:    GP_token_is
+//
+// INPUTS:  parser  - parser holding latest token
+//          keyword - lower-case keyword
+//
+// RETURN:  (BOOLEAN) - TRUE if the token is the keyword, in lower or upper
+//                      case
+//
+// PURPOSE: check for a keyword
+//
+//******************************************************************************
+BOOLEAN GP_token_is(GraphParser *parser, const char *keyword)
+{
+   ULONG i;
+   BOOLEAN upper;
+
+   if ((parser->tokenQuoted) || (parser->tokenLength != strlen(keyword)))
+      return FALSE;
+   upper = (parser->token[0] == toupper(keyword[0]));
+   for (i = 0; i < parser->tokenLength; i++)
+      if (parser->token[i] != (upper ? toupper(keyword[i]) : keyword[i]))
+         return FALSE;
+   return TRUE;
+}
+
+//******************************************************************************
+// NAME:    GP_read_number
+//
+// INPUTS:  parser - parser holding latest token
+//          number - where to store number
+//
+// RETURN:  (BOOLEAN) - FALSE if the token is not an unsigned integer
+//
+// PURPOSE: convert the latest token to an example or vertex number
+//
+//******************************************************************************
+BOOLEAN GP_read_number(GraphParser *parser, ULONG *number)
+{
+   ULONG i;
+
+   if (parser->tokenQuoted)
+      return FALSE;
+   *number = 0;
+   for (i = 0; i < parser->tokenLength; i++)
+   {
+      if ((parser->token[i] < '0') || (parser->token[i] > '9'))
+         return FALSE;
+      *number = (*number * 10) + (parser->token[i] - '0');
+   }
+   return TRUE;
+}
+
+//******************************************************************************
+// NAME:    GP_read_label
+//
+// INPUTS:  parser - parser holding latest token
+//
+// RETURN:  (ULONG) - index of label in info->labelList
+//
+// PURPOSE: store the label given by the latest token in the label list.
+//          A quoted string is a string label, including its quotes; an
+//          unquoted token is a numeric label if it is a number, else a
+//          string label.
+//
+//******************************************************************************
+ULONG GP_read_label(GraphParser *parser)
+{
+   Label label;
+   char number[TOKEN_LEN];
+   char *endptr;
+   ULONG length = parser->tokenLength;
+
+   label.labelType = STRING_LABEL;
+   if ((! parser->tokenQuoted) && (length < TOKEN_LEN))
+   {
+      memcpy(number, parser->token, length);
+      number[length] = '\0';
+      label.labelValue.numericLabel = strtod(number, &endptr);
+      if (*endptr == '\0')
+         label.labelType = NUMERIC_LABEL;
+   }
+   return GP_store_label(parser, &label, parser->token, length);
+}
+
+//******************************************************************************
+// NAME:    GP_store_label
+//
+// INPUTS:  parser - parser whose label cache to use
+//          label  - label whose type, and value if numeric, is set
+//          string - value of string label, not null-terminated
+//          length - length of string
+//
+// RETURN:  (ULONG) - index of label in info->labelList
+//
+// PURPOSE: store a label in the label list.  The label's index is looked
+//          up in the parser's label cache, by hash, so that the label list
+//          is only searched, and the string copied, the first time a label
+//          is seen.
+//
+//******************************************************************************
+ULONG GP_store_label(GraphParser *parser, Label *label, const char *string,
+                     ULONG length)
+{
+   LabelList *labelList = parser->info->labelList;
+   LabelCacheEntry *entry;
+   Label *cachedLabel;
+   char *stringLabel = NULL;
+   ULONG hash;
+   ULONG i;
+
+   if (label->labelType == NUMERIC_LABEL)
+   {
+      memcpy(&hash, &label->labelValue.numericLabel, sizeof(ULONG));
+      hash = MixHash(hash);
+   }
+   else
+   {
+      hash = length;
+      for (i = 0; i < length; i++)
+         hash = (hash * 31) + (unsigned char) string[i];
+      hash = MixHash(hash);
+   }
+
+   // look for label in cache
+   i = hash & (parser->labelCacheSize - 1);
+   while (parser->labelCache[i].labelIndex != 0)
+   {
+      entry = & parser->labelCache[i];
+      cachedLabel = & labelList->labels[entry->labelIndex - 1];
+      if ((entry->hash == hash) && (cachedLabel->labelType == label->labelType))
+      {
+         if ((label->labelType == NUMERIC_LABEL) &&
+             (cachedLabel->labelValue.numericLabel ==
+              label->labelValue.numericLabel))
+            return entry->labelIndex - 1;
+         if ((label->labelType == STRING_LABEL) &&
+             (strncmp(cachedLabel->labelValue.stringLabel, string,
+                      length) == 0) &&
+             (cachedLabel->labelValue.stringLabel[length] == '\0'))
+            return entry->labelIndex - 1;
+      }
+      i = (i + 1) & (parser->labelCacheSize - 1);
+   }
+
+   // first time label seen by this parser, so store it and cache it
+   if (label->labelType == STRING_LABEL)
+   {
+      stringLabel = (char *) malloc(sizeof(char) * (length + 1));
+      if (stringLabel == NULL)
+         OutOfMemoryError("GP_store_label:stringLabel");
+      memcpy(stringLabel, string, length);
+      stringLabel[length] = '\0';
+      label->labelValue.stringLabel = stringLabel;
+   }
+   entry = & parser->labelCache[i];
+   entry->hash = hash;
+   entry->labelIndex = StoreLabel(label, labelList) + 1;
+   i = entry->labelIndex - 1;
+   free(stringLabel);
+   parser->numCachedLabels++;
+   if ((parser->numCachedLabels * 2) > parser->labelCacheSize)
+      GP_grow_label_cache(parser);
+
+   return i;
 }
 
 //******************************************************************************
-// NAME:    GP_add_vertex_f
+// NAME:    GP_grow_label_cache
 //
-// INPUTS:  arg   - pointer to the argument passed to yyparse
-//          v     - the number of the vertex
-//          label - the label of the vertex
+// INPUTS:  parser - parser whose label cache is getting full
 //
 // RETURN:  none
 //
-// PURPOSE: function called by the parser when it finds a vertex with a floating
-//          point label
+// PURPOSE: double the size of the parser's label cache
 //
 //******************************************************************************
-void GP_add_vertex_f(void *arg, int v, double label)
+void GP_grow_label_cache(GraphParser *parser)
 {
-   Graph_Info *GP_info = (Graph_Info *)arg;
-	
-   ULONG labelIndex;
-   Label graph_label;
-	
-   if (v+GP_info->vertexOffset !=
-   	(GP_info->graph->numVertices + 1)) 
+   LabelCacheEntry *oldCache = parser->labelCache;
+   ULONG oldSize = parser->labelCacheSize;
+   ULONG i;
+   ULONG j;
+
+   parser->labelCacheSize = oldSize * 2;
+   parser->labelCache = (LabelCacheEntry *)
+      malloc(sizeof(LabelCacheEntry) * parser->labelCacheSize);
+   if (parser->labelCache == NULL)
+      OutOfMemoryError("GP_grow_label_cache:labelCache");
+   for (i = 0; i < parser->labelCacheSize; i++)
+      parser->labelCache[i].labelIndex = 0;
+   for (i = 0; i < oldSize; i++)
    {
-      snprintf(GP_err_str, ERR_STR_LEN, "invalid vertex number, found %d, expecting %lu",
-               v, (GP_info->graph->numVertices + 1)-GP_info->vertexOffset);
-      yyerror(NULL, GP_err_str);
-      exit(1);
+      if (oldCache[i].labelIndex != 0)
+      {
+         j = oldCache[i].hash & (parser->labelCacheSize - 1);
+         while (parser->labelCache[j].labelIndex != 0)
+            j = (j + 1) & (parser->labelCacheSize - 1);
+         parser->labelCache[j] = oldCache[i];
+      }
    }
-	
-   graph_label.labelType = NUMERIC_LABEL;
-   graph_label.labelValue.numericLabel = label;
-   
-   labelIndex = StoreLabel(&graph_label, GP_info->labelList);
-   AddVertex(GP_info->graph, labelIndex, &(GP_info->posGraphVertexListSize), v);
+   free(oldCache);
+}
+
+//******************************************************************************
+// NAME:    GP_syntax_error
+//
+// INPUTS:  parser - parser holding the unexpected token
+//
+// RETURN:  (int) - 1, the error return of GP_parse
+//
+// PURPOSE: report a syntax error at the latest token
+//
+//******************************************************************************
+int GP_syntax_error(GraphParser *parser)
+{
+   if (parser->chunk)
+      parser->failed = TRUE;
+   else if (parser->tokenLength == 0)
+      GP_error(parser, "syntax error, unexpected end of file");
+   else
+   {
+      fprintf(stderr, "%s:%lu: error: syntax error, unexpected %.*s\n",
+              parser->fileName, parser->tokenLineNo,
+              (int) ((parser->tokenLength < TOKEN_LEN) ?
+                     parser->tokenLength : TOKEN_LEN), parser->token);
+   }
+   return 1;
 }
 
 //******************************************************************************
-// NAME:    GP_add_vertex_s
+// NAME:    GP_error
 //
-// INPUTS:  arg   - pointer to the argument passed to yyparse
-//          v     - the number of the vertex
-//          label - the label of the vertex
+// INPUTS:  parser  - parser finding the error
+//          message - error message
 //
 // RETURN:  none
 //
-// PURPOSE: function called by the parser when it finds a vertex with a string
-//          label
+// PURPOSE: print an error message with the file name and line number
 //
 //******************************************************************************
-void GP_add_vertex_s(void *arg, int v, char *label)
+void GP_error(GraphParser *parser, char *message)
 {
-   Graph_Info *GP_info = (Graph_Info *)arg;
-	
-   ULONG labelIndex;
-   Label graph_label;
-	
-   if (v+GP_info->vertexOffset !=
-   	(GP_info->graph->numVertices + 1)) 
-   {
-      snprintf(GP_err_str, ERR_STR_LEN, "invalid vertex number, found %d, expecting %lu",
-      	       v, (GP_info->graph->numVertices + 1)-GP_info->vertexOffset);
-      yyerror(NULL, GP_err_str);
-      exit(1);
+   fprintf(stderr, "%s:%lu: error: %s\n", parser->fileName,
+           parser->tokenLineNo, message);
+}
+
+//******************************************************************************
+// NAME:    GP_fatal_error
+//
+// INPUTS:  parser  - parser finding the error
+//          message - error message
+//
+// RETURN:  none
+//
+// PURPOSE: print an error message and exit, unless parsing a chunk of the
+//          file, in which case the chunk is marked as failed so that the
+//          file is parsed again serially, reporting the error then
+//
+//******************************************************************************
+void GP_fatal_error(GraphParser *parser, char *message)
+{
+   if (parser->chunk)
+   {
+      parser->failed = TRUE;
+      return;
    }
-   
-   graph_label.labelType = STRING_LABEL;
-   graph_label.labelValue.stringLabel = label;
-   
-   labelIndex = StoreLabel(&graph_label, GP_info->labelList);
-   AddVertex(GP_info->graph, labelIndex, &(GP_info->posGraphVertexListSize), v);
-   
-   free(label);
+   GP_error(parser, message);
+   exit(1);
 }
 
 //******************************************************************************
-// NAME:    GP_add_edge_i
+// NAME:    GP_add_xp
+//
+// INPUTS:  parser - parser finding the XP example
+//          num    - the number of the XP example
 //
-// INPUTS:  arg   - pointer to the argument passed to yyparse
-//          type  - integer value representing the type of edge
-//                  this will be one of the following defined in y.tab.h:
-//                       D_EDGE E_EDGE U_EDGE
-//          src   - the source vertex
-//          dst   - the target vertex
-//          label - the edge label
 // RETURN:  none
 //
-// PURPOSE: function called by the parser when it finds an edge with an integer
-//          label
+// PURPOSE: function called by the parser when it finds a new XP example
 //
 //******************************************************************************
-void GP_add_edge_i(void *arg, int type, int src, int dst, int label)
+void GP_add_xp(GraphParser *parser, ULONG num)
 {
-   ULONG labelIndex;
-   Label graph_label;
-	
-   Graph_Info *GP_info = (Graph_Info *)arg;
-	
-   if (src+GP_info->vertexOffset > GP_info->graph->numVertices) 
-   {
-      snprintf(GP_err_str, ERR_STR_LEN, "undefined source vertex number, found %d",
-      	       src);
-      yyerror(NULL, GP_err_str);
-      exit(1);
+   Graph_Info *GP_info = parser->info;
+   char errStr[ERR_STR_LEN];
+
+   if (!GP_info->xp_graph)
+   {
+      GP_fatal_error(parser, "invalid graph type, found XP, expecting PS.");
+      return;
    }
-	
-   if (dst+GP_info->vertexOffset > GP_info->graph->numVertices) 
+
+   // a chunk's examples are numbered from its first example
+   if ((parser->chunk) && (GP_info->numPosEgs == 0) && (num > 0))
+      parser->egOffset = num - 1;
+
+   if (num != parser->egOffset+GP_info->numPosEgs+1)
    {
-      snprintf(GP_err_str, ERR_STR_LEN, "undefined target vertex number, found %d",
-      	       src);
-      yyerror(NULL, GP_err_str);
-      exit(1);
+      snprintf(errStr, ERR_STR_LEN, "invalid XP number, found %lu, expecting %lu",
+               num, parser->egOffset+GP_info->numPosEgs+1);
+      GP_fatal_error(parser, errStr);
+      return;
    }
-   
-   graph_label.labelType = NUMERIC_LABEL;
-   graph_label.labelValue.numericLabel = (double)label;
-   
-   labelIndex = StoreLabel(&graph_label, GP_info->labelList);
-   
-   if (type == E_EDGE)
-   {
-      //printf("e %d %d %d\n", src, dst, label);
-   	
-      AddEdge(GP_info->graph, src-1+GP_info->vertexOffset,
-      	       dst-1+GP_info->vertexOffset, GP_info->directed,
-      	       labelIndex, &(GP_info->posGraphEdgeListSize), FALSE);
-   }
-   else if (type == D_EDGE)
-   {
-      //printf("d %d %d %d\n", src, dst, label);
-   	
-      AddEdge(GP_info->graph, src-1+GP_info->vertexOffset,
-      	       dst-1+GP_info->vertexOffset, TRUE, labelIndex,
-             	&(GP_info->posGraphEdgeListSize), FALSE);
-   
-   }
-   else if (type == U_EDGE)
-   {
-      //printf("u %d %d %d\n", src, dst, label);
-   	
-      AddEdge(GP_info->graph, src-1+GP_info->vertexOffset,
-             	dst-1+GP_info->vertexOffset, FALSE, labelIndex,
-             	&(GP_info->posGraphEdgeListSize), FALSE);
+
+   if (GP_info->graph == NULL)
+   {
+      GP_info->graph = AllocateGraph(0,0);
    }
+
+   GP_info->numPosEgs++;
+   GP_info->vertexOffset = GP_info->graph->numVertices;
+   GP_info->posEgsVertexIndices = AddVertexIndex(
+   GP_info->posEgsVertexIndices,
+   GP_info->numPosEgs, GP_info->vertexOffset);
 }
 
 //******************************************************************************
-// NAME:    GP_add_edge_f
+// NAME:    GP_add_ps
+//
+// INPUTS:  parser - parser finding the PS instance
+//          num    - the number of the PS instance
 //
-// INPUTS:  arg   - pointer to the argument passed to yyparse
-//          type  - integer value representing the type of edge
-//                  this will be one of the following defined in y.tab.h:
-//                       D_EDGE E_EDGE U_EDGE
-//          src   - the source vertex
-//          dst   - the target vertex
-//          label - the edge label
 // RETURN:  none
 //
-// PURPOSE: function called by the parser when it finds an edge with an floating
-//          point label
+// PURPOSE: function called by the parser when it finds a new PS instance
 //
 //******************************************************************************
-void GP_add_edge_f(void *arg, int type, int src, int dst, double label)
+void GP_add_ps(GraphParser *parser, ULONG num)
 {
-   ULONG labelIndex;
-   Label graph_label;
-	
-   Graph_Info *GP_info = (Graph_Info *)arg;
-	
-   if (src+GP_info->vertexOffset > GP_info->graph->numVertices) 
-   {
-      snprintf(GP_err_str, ERR_STR_LEN, "undefined target vertex number, found %d",
-      	src);
-      yyerror(NULL, GP_err_str);
-      exit(1);
+   Graph_Info *GP_info = parser->info;
+   char errStr[ERR_STR_LEN];
+
+   if (GP_info->xp_graph)
+   {
+      GP_fatal_error(parser, "invalid graph type, found PS, expecting XP.");
+      return;
    }
-   
-   if (dst+GP_info->vertexOffset > GP_info->graph->numVertices) 
+
+   if (num != GP_info->numPreSubs+1)
    {
-      snprintf(GP_err_str, ERR_STR_LEN, "undefined target vertex number, found %d",
-      	src);
-      yyerror(NULL, GP_err_str);
-      exit(1);
+      snprintf(errStr, ERR_STR_LEN, "invalid PS number, found %lu, expecting %lu",
+               num, GP_info->numPreSubs+1);
+      GP_fatal_error(parser, errStr);
+      return;
+   }
+
+   GP_info->numPreSubs++;
+   GP_info->preSubs = (Graph **) realloc(GP_info->preSubs, (sizeof(Graph *) * GP_info->numPreSubs));
+   if (GP_info->preSubs == NULL)
+   {
+      OutOfMemoryError("ReadSubGraphsFromFile:subGraphs");
    }
-   
-   graph_label.labelType = NUMERIC_LABEL;
-   graph_label.labelValue.numericLabel = label;
-   
-   labelIndex = StoreLabel(&graph_label, GP_info->labelList);
-   
-   if (type == E_EDGE)
-   {
-      //printf("e %d %d %f\n", src, dst, label);
-   	
-      AddEdge(GP_info->graph, src-1+GP_info->vertexOffset,
-   		dst-1+GP_info->vertexOffset, GP_info->directed,
-   		labelIndex, &(GP_info->posGraphEdgeListSize), FALSE);
-   }
-   else if (type == D_EDGE)
-   {
-      //printf("d %d %d %f\n", src, dst, label);
-      
-      AddEdge(GP_info->graph, src-1+GP_info->vertexOffset,
-   		dst-1+GP_info->vertexOffset, TRUE, labelIndex,
-   		&(GP_info->posGraphEdgeListSize), FALSE);
-   
-   }
-   else if (type == U_EDGE)
-   {
-      //printf("u %d %d %f\n", src, dst, label);
-   	
-      AddEdge(GP_info->graph, src-1+GP_info->vertexOffset,
-   		dst-1+GP_info->vertexOffset, FALSE, labelIndex,
-   		&(GP_info->posGraphEdgeListSize), FALSE);
+
+   GP_info->preSubs[GP_info->numPreSubs - 1] = AllocateGraph(0, 0);
+   GP_info->graph = GP_info->preSubs[GP_info->numPreSubs - 1];
+   GP_info->posGraphVertexListSize = 0;
+   GP_info->posGraphEdgeListSize = 0;
+}
+
+//******************************************************************************
+// NAME:    GP_add_vertex
+//
+// INPUTS:  parser     - parser finding the vertex
+//          v          - the number of the vertex
+//          labelIndex - index of the vertex's label in the label list
+//
+// RETURN:  none
+//
+// PURPOSE: function called by the parser when it finds a vertex
+//
+//******************************************************************************
+void GP_add_vertex(GraphParser *parser, ULONG v, ULONG labelIndex)
+{
+   Graph_Info *GP_info = parser->info;
+   char errStr[ERR_STR_LEN];
+
+   if (v+GP_info->vertexOffset != (GP_info->graph->numVertices + 1))
+   {
+      snprintf(errStr, ERR_STR_LEN, "invalid vertex number, found %lu, expecting %lu",
+               v, (GP_info->graph->numVertices + 1)-GP_info->vertexOffset);
+      GP_fatal_error(parser, errStr);
+      return;
+   }
+
+   // grow vertex list geometrically, rather than by LIST_SIZE_INC, since
+   // large input graphs are read a vertex at a time
+   if (GP_info->posGraphVertexListSize == GP_info->graph->numVertices)
+   {
+      GP_info->posGraphVertexListSize += GP_info->posGraphVertexListSize;
+      if (GP_info->posGraphVertexListSize < LIST_SIZE_INC)
+         GP_info->posGraphVertexListSize = LIST_SIZE_INC;
+      GP_info->graph->vertices = (Vertex *) realloc(GP_info->graph->vertices,
+         (sizeof(Vertex) * GP_info->posGraphVertexListSize));
+      if (GP_info->graph->vertices == NULL)
+         OutOfMemoryError("GP_add_vertex:vertices");
    }
+
+   AddVertex(GP_info->graph, labelIndex, &(GP_info->posGraphVertexListSize), v);
 }
 
 //******************************************************************************
-// NAME:    GP_add_edge_s
+// NAME:    GP_add_edge
+//
+// INPUTS:  parser     - parser finding the edge
+//          directed   - TRUE if the edge is directed
+//          src        - the source vertex
+//          dst        - the target vertex
+//          labelIndex - index of the edge's label in the label list
 //
-// INPUTS:  arg   - pointer to the argument passed to yyparse
-//          type  - integer value representing the type of edge
-//                  this will be one of the following defined in y.tab.h:
-//                       D_EDGE E_EDGE U_EDGE
-//          src   - the source vertex
-//          dst   - the target vertex
-//          label - the edge label
 // RETURN:  none
 //
-// PURPOSE: function called by the parser when it finds an edge with a string
-//          label
+// PURPOSE: function called by the parser when it finds an edge
 //
 //******************************************************************************
-void GP_add_edge_s(void *arg, int type, int src, int dst, char *label)
+void GP_add_edge(GraphParser *parser, BOOLEAN directed, ULONG src, ULONG dst,
+                 ULONG labelIndex)
 {
-   ULONG labelIndex;
-   Label graph_label;
-	
-   Graph_Info *GP_info = (Graph_Info *)arg;
-	
-   if (src+GP_info->vertexOffset > GP_info->graph->numVertices) 
-   {
-      snprintf(GP_err_str, ERR_STR_LEN, "undefined target vertex number, found %d",
-   		src);
-      yyerror(NULL, GP_err_str);
-      exit(1);
+   Graph_Info *GP_info = parser->info;
+   char errStr[ERR_STR_LEN];
+
+   if ((src == 0) || (src+GP_info->vertexOffset > GP_info->graph->numVertices))
+   {
+      snprintf(errStr, ERR_STR_LEN, "undefined source vertex number, found %lu",
+               src);
+      GP_fatal_error(parser, errStr);
+      return;
+   }
+
+   if ((dst == 0) || (dst+GP_info->vertexOffset > GP_info->graph->numVertices))
+   {
+      snprintf(errStr, ERR_STR_LEN, "undefined target vertex number, found %lu",
+               dst);
+      GP_fatal_error(parser, errStr);
+      return;
    }
-   
-   if (dst+GP_info->vertexOffset > GP_info->graph->numVertices) 
+
+   // grow edge list geometrically, as for vertices
+   if (GP_info->posGraphEdgeListSize == GP_info->graph->numEdges)
    {
-      snprintf(GP_err_str, ERR_STR_LEN, "undefined target vertex number, found %d",
-   		src);
-      yyerror(NULL, GP_err_str);
-      exit(1);
+      GP_info->posGraphEdgeListSize += GP_info->posGraphEdgeListSize;
+      if (GP_info->posGraphEdgeListSize < LIST_SIZE_INC)
+         GP_info->posGraphEdgeListSize = LIST_SIZE_INC;
+      GP_info->graph->edges = (Edge *) realloc(GP_info->graph->edges,
+         (sizeof(Edge) * GP_info->posGraphEdgeListSize));
+      if (GP_info->graph->edges == NULL)
+         OutOfMemoryError("GP_add_edge:edges");
    }
-   
-   graph_label.labelType = STRING_LABEL;
-   graph_label.labelValue.stringLabel = label;
-   
-   labelIndex = StoreLabel(&graph_label, GP_info->labelList);
-   
-   if (type == E_EDGE)
-   {
-      //printf("e %d %d %s\n", src, dst, label);
-   	
-      AddEdge(GP_info->graph, src-1+GP_info->vertexOffset,
-   		dst-1+GP_info->vertexOffset, GP_info->directed,
-   		labelIndex, &(GP_info->posGraphEdgeListSize), FALSE);
-   }
-   else if (type == D_EDGE)
-   {
-      //printf("d %d %d %s\n", src, dst, label);
-   	
-      AddEdge(GP_info->graph, src-1+GP_info->vertexOffset,
-   		dst-1+GP_info->vertexOffset, TRUE, labelIndex,
-   		&(GP_info->posGraphEdgeListSize), FALSE);
-   
-   }
-   else if (type == U_EDGE)
-   {
-      //printf("u %d %d %s\n", src, dst, label);
-   	
-      AddEdge(GP_info->graph, src-1+GP_info->vertexOffset,
-   		dst-1+GP_info->vertexOffset, FALSE, labelIndex,
-   		&(GP_info->posGraphEdgeListSize), FALSE);
-   }
-   
-   free(label);
+
+   AddEdge(GP_info->graph, src-1+GP_info->vertexOffset,
+           dst-1+GP_info->vertexOffset, directed, labelIndex,
+           &(GP_info->posGraphEdgeListSize), FALSE);
 }
@@ -57,6 +57,7 @@ Graph *CompressGraph(Graph *graph, InstanceList *instanceList,
    // parameters used
    LabelList *labelList = parameters->labelList;
    BOOLEAN allowInstanceOverlap = parameters->allowInstanceOverlap;
+   Workspace *workspace = parameters->workspace;
 
    // assign "SUB" and "OVERLAP" labels an index of where they would be
    // in the label list if actually added
@@ -64,6 +65,7 @@ Graph *CompressGraph(Graph *graph, InstanceList *instanceList,
    overlapLabelIndex = labelList->numLabels + 1;
 
    // mark and count unique vertices and edges in graph from instances
+   NewWorkspaceEpoch(workspace, graph);
    numInstanceVertices = 0;
    numInstanceEdges = 0;
    instanceNo = 1;
@@ -75,21 +77,21 @@ Graph *CompressGraph(Graph *graph, InstanceList *instanceList,
       instance = instanceListNode->instance;
       for (v = 0; v < instance->numVertices; v++)      // add in unique vertices
       {
-         if ((!graph->vertices[instance->vertices[v]].used) &&
+         if ((! VERTEX_MARKED(workspace, instance->vertices[v])) &&
              ((instance->vertices[v] >= startVertex)))
          {
             numInstanceVertices++;
-            graph->vertices[instance->vertices[v]].used = TRUE;
+            MARK_VERTEX(workspace, instance->vertices[v]);
             // assign vertex to first instance it occurs in
             graph->vertices[instance->vertices[v]].map = instanceNo - 1;
          }
       }
       for (e = 0; e < instance->numEdges; e++) // add in unique edges
-         if ((!graph->edges[instance->edges[e]].used) &&
+         if ((! EDGE_MARKED(workspace, instance->edges[e])) &&
              ((instance->edges[e] >= startEdge)))
          {
             numInstanceEdges++;
-            graph->edges[instance->edges[e]].used = TRUE;
+            MARK_EDGE(workspace, instance->edges[e]);
          }
       instanceNo++;
       instanceListNode = instanceListNode->next;
@@ -109,7 +111,6 @@ Graph *CompressGraph(Graph *graph, InstanceList *instanceList,
       compressedGraph->vertices[vertexIndex].numEdges = 0;
       compressedGraph->vertices[vertexIndex].edges = NULL;
       compressedGraph->vertices[vertexIndex].map = VERTEX_UNMAPPED;
-      compressedGraph->vertices[vertexIndex].used = FALSE;
       compressedGraph->vertices[vertexIndex].originalVertexIndex = -1;
       compressedGraph->vertices[vertexIndex].color = NO_COLOR;
       vertexIndex++;
@@ -124,17 +125,188 @@ Graph *CompressGraph(Graph *graph, InstanceList *instanceList,
       AddOverlapEdges(compressedGraph, graph, instanceList, overlapLabelIndex,
                       startVertex, startEdge, parameters);
 
-   // reset used flag of instances' vertices and edges
+   return compressedGraph;
+}
+
+
+//******************************************************************************
+// NAME: CompressGraphInPlace
+//
+// INPUTS: (Graph *graph) - graph to be compressed
+//         (InstanceList *instanceList) - non-overlapping substructure
+//                                        instances used to compress graph
+//         (Parameters *parameters)
+//
+// RETURN: (void)
+//
+// PURPOSE: Compress the given graph with the given substructure instances
+// in its own vertex and edge arrays, instead of building a new graph.
+// The result is the graph CompressGraph would return: "SUB" vertices for
+// the instances come first, followed by the remaining vertices, and the
+// remaining edges in their original order.  Overlapping instances are
+// not supported, since the overlap edges added by AddOverlapEdges are
+// found from the uncompressed graph.
+//******************************************************************************
+
+void CompressGraphInPlace(Graph *graph, InstanceList *instanceList,
+                          Parameters *parameters)
+{
+   InstanceListNode *instanceListNode;
+   Instance *instance;
+   ULONG numInstances;
+   ULONG v, e;
+   ULONG nv, ne;
+   ULONG subLabelIndex;
+   ULONG *vertexMap;
+   Vertex *vertices;
+   Edge *edges;
+   char outFileName[FILE_NAME_LEN];
+   FILE *outputFile = NULL;
+
+   // parameters used
+   LabelList *labelList = parameters->labelList;
+   Workspace *workspace = parameters->workspace;
+
+   // assign "SUB" label the index of where it would be in the label list
+   subLabelIndex = labelList->numLabels;
+
+   // mark vertices and edges of instances, mapping each vertex to the
+   // SUB vertex of the first instance it occurs in
+   NewWorkspaceEpoch(workspace, graph);
+   vertexMap = workspace->vertexMap;
+   numInstances = 0;
    instanceListNode = instanceList->head;
-   while (instanceListNode != NULL) 
+   while (instanceListNode != NULL)
    {
       instance = instanceListNode->instance;
-      MarkInstanceVertices(instance, graph, FALSE);
-      MarkInstanceEdges(instance, graph, FALSE);
+      for (v = 0; v < instance->numVertices; v++)
+      {
+         if (! VERTEX_MARKED(workspace, instance->vertices[v]))
+         {
+            MARK_VERTEX(workspace, instance->vertices[v]);
+            vertexMap[instance->vertices[v]] = numInstances;
+         }
+      }
+      for (e = 0; e < instance->numEdges; e++)
+         MARK_EDGE(workspace, instance->edges[e]);
+      numInstances++;
       instanceListNode = instanceListNode->next;
    }
 
-   return compressedGraph;
+   if (parameters->prob)
+   {
+      // write this mapping to the appropriate file
+      if ((snprintf(outFileName, FILE_NAME_LEN, "%s.anom%lu",
+                    parameters->inputFileName, parameters->currentIteration)
+           >= FILE_NAME_LEN) ||
+          (!(outputFile = fopen(outFileName, "w"))))
+      {
+         printf("ERROR (CompressGraph):  Unable to create/open file %s\n",outFileName);
+         exit(1);
+      }
+   }
+   // remaining vertices follow the SUB vertices, in order; instance
+   // vertices are dropped
+   nv = numInstances;
+   for (v = 0; v < graph->numVertices; v++)
+   {
+      if (! VERTEX_MARKED(workspace, v))
+      {
+         if (parameters->prob)
+            fprintf(outputFile,"%lu -> %lu\n",v+1,nv+1);
+         vertexMap[v] = nv;
+         nv++;
+      }
+      else
+         free(graph->vertices[v].edges);
+   }
+   if (parameters->prob)
+      fclose(outputFile);
+
+   // move remaining edges down, pointing them to the new vertices
+   edges = graph->edges;
+   ne = 0;
+   for (e = 0; e < graph->numEdges; e++)
+   {
+      if (! EDGE_MARKED(workspace, e))
+      {
+         if (ne != e)
+            edges[ne] = edges[e];
+         edges[ne].vertex1 = vertexMap[edges[e].vertex1];
+         edges[ne].vertex2 = vertexMap[edges[e].vertex2];
+         ne++;
+      }
+   }
+
+   //
+   // Move remaining vertices to their new places.  New indices grow
+   // more slowly than old ones, so vertices moving up (near the start,
+   // where fewer instance vertices precede them than there are SUB
+   // vertices) are moved last first, and those moving down first
+   // first; neither overwrites a vertex that has not moved yet.  Edge
+   // arrays are kept, to be refilled below.  The vertex array only grows
+   // if some instance has no vertices of its own.
+   //
+   vertices = graph->vertices;
+   if (nv > graph->numVertices)
+   {
+      vertices = (Vertex *) realloc(vertices, sizeof(Vertex) * nv);
+      if (vertices == NULL)
+         OutOfMemoryError("CompressGraphInPlace:vertices");
+   }
+   v = graph->numVertices;
+   while (v > 0)
+   {
+      v--;
+      if ((! VERTEX_MARKED(workspace, v)) && (vertexMap[v] > v))
+         vertices[vertexMap[v]] = vertices[v];
+   }
+   for (v = 0; v < graph->numVertices; v++)
+      if ((! VERTEX_MARKED(workspace, v)) && (vertexMap[v] < v))
+         vertices[vertexMap[v]] = vertices[v];
+   for (v = numInstances; v < nv; v++)
+   {
+      vertices[v].numEdges = 0;
+      vertices[v].map = VERTEX_UNMAPPED;
+   }
+
+   // insert SUB vertices for each instance
+   for (v = 0; v < numInstances; v++)
+   {
+      vertices[v].label = subLabelIndex;
+      vertices[v].numEdges = 0;
+      vertices[v].edges = NULL;
+      vertices[v].map = VERTEX_UNMAPPED;
+      vertices[v].anomalous = FALSE;
+      vertices[v].sourceVertex = 0;
+      vertices[v].sourceExample = 0;
+      vertices[v].originalVertexIndex = -1;
+      vertices[v].color = NO_COLOR;
+      vertices[v].anomalousValue = 2.0;
+   }
+
+   // release unused memory and add edges to their vertices
+   graph->numVertices = nv;
+   graph->numEdges = ne;
+   graph->vertices = (Vertex *) realloc(vertices, sizeof(Vertex) * nv);
+   if (graph->vertices == NULL)
+      OutOfMemoryError("CompressGraphInPlace:graph->vertices");
+   if (ne > 0)
+   {
+      graph->edges = (Edge *) realloc(edges, sizeof(Edge) * ne);
+      if (graph->edges == NULL)
+         OutOfMemoryError("CompressGraphInPlace:graph->edges");
+   }
+   else
+   {
+      free(edges);
+      graph->edges = NULL;
+   }
+   for (e = 0; e < ne; e++)
+      AddEdgeToVertices(graph, e);
+   FreeGraphFingerprint(graph);
+   FreeVertexLabelIndex(graph);
+   FreeEdgeTypeIndex(graph);
 }
 
 
@@ -168,8 +340,8 @@ Graph *CompressGraph(Graph *graph, InstanceList *instanceList,
 // the instance list's order.  I.e., the ith instance in the instance
 // list corresponds to compressedGraph->vertices[i-1].
 //
-// 2. All vertices and edges in the instances are marked (used=TRUE)
-// in the graph.  Instance vertices will be unmarked as processed.
+// 2. All vertices and edges in the instances are marked in the
+// workspace.  Instance vertices will be unmarked as processed.
 //
 // 3. The vertices in the given graph are all mapped to their appropriate
 // vertices in the compressedGraph.
@@ -200,6 +372,7 @@ void AddOverlapEdges(Graph *compressedGraph, Graph *graph,
    ULONG numOverlapEdges;
    ULONG totalEdges;
    ULONG edgeIndex;
+   Workspace *workspace = parameters->workspace;
 
    overlapEdges = NULL;
    numOverlapEdges = 0;
@@ -213,8 +386,8 @@ void AddOverlapEdges(Graph *compressedGraph, Graph *graph,
       for (v1 = 0; v1 < instance1->numVertices; v1++) 
       {
          vertex1 = &graph->vertices[instance1->vertices[v1]];
-         if (vertex1->used) 
-         {  // (used==TRUE) indicates unchecked for sharing
+         if (VERTEX_MARKED(workspace, instance1->vertices[v1])) 
+         {  // marked indicates unchecked for sharing
             // for each instance2 after instance1
             instanceListNode2 = instanceListNode1->next;
             instanceNo2 = instanceNo1 + 1;
@@ -239,7 +412,7 @@ void AddOverlapEdges(Graph *compressedGraph, Graph *graph,
                      for (e = 0; e < vertex1->numEdges; e++) 
                      {
                         edge1 = &graph->edges[vertex1->edges[e]];
-                        if ((!edge1->used) &&
+                        if ((! EDGE_MARKED(workspace, vertex1->edges[e])) &&
                             (vertex1->edges[e] >= startEdge))
                         { // edge external to instance
                            overlapEdges =
@@ -253,7 +426,8 @@ void AddOverlapEdges(Graph *compressedGraph, Graph *graph,
                instanceListNode2 = instanceListNode2->next;
                instanceNo2++;
             }
-            vertex1->used = FALSE; // i.e., done processing vertex1 for overlap
+            // i.e., done processing vertex1 for overlap
+            UNMARK_VERTEX(workspace, instance1->vertices[v1]);
          }
       }
       instanceListNode1 = instanceListNode1->next;
@@ -439,8 +613,8 @@ Edge *AddDuplicateEdges(Edge *overlapEdges, ULONG *numOverlapEdgesPtr,
       numOverlapEdges++;
       // if other vertex unmarked (i.e., overlapping and already processed)
       // then duplicate edge connecting Sub2 to Sub2
-      if ((! graph->vertices[edge->vertex1].used) ||
-          (! graph->vertices[edge->vertex2].used)) 
+      if ((! VERTEX_MARKED(parameters->workspace, edge->vertex1)) ||
+          (! VERTEX_MARKED(parameters->workspace, edge->vertex2))) 
       {
          overlapEdges = (Edge *) realloc(overlapEdges,
                                  ((numOverlapEdges + 1) * sizeof(Edge)));
@@ -617,8 +791,19 @@ void CompressFinalGraphs(Substructure *sub, Parameters *parameters,
    }
    // DEBUG
 
+   //
+   // Without overlap, the graph is compressed in place, so that only one
+   // copy of it is ever held; overlap edges are found from the
+   // uncompressed graph, so need a new graph.
+   //
    if (sub->numInstances > 0)
-      compressedPosGraph = CompressGraph(posGraph, sub->instances, parameters);
+   {
+      if (allowInstanceOverlap)
+         compressedPosGraph = CompressGraph(posGraph, sub->instances,
+                                            parameters);
+      else
+         CompressGraphInPlace(posGraph, sub->instances, parameters);
+   }
 
    // add "SUB" and "OVERLAP" (if used) labels to label list
    if (predefinedSub)
@@ -645,8 +830,11 @@ void CompressFinalGraphs(Substructure *sub, Parameters *parameters,
    // reset graphs with compressed graphs
    if (sub->numInstances > 0) 
    {
-      FreeGraph(parameters->posGraph);
+      if (compressedPosGraph != posGraph)
+         FreeGraph(parameters->posGraph);
       parameters->posGraph = compressedPosGraph;
+      FreeGraphStats(parameters->posGraphStats);
+      parameters->posGraphStats = NULL;
    }
 
    // Recompute label list and MDL for positive graphs.
@@ -673,6 +861,8 @@ void CompressFinalGraphs(Substructure *sub, Parameters *parameters,
                                       newLabelList->numLabels, parameters);
       }
    }
+   IndexVertexLabels(parameters->posGraph);
+   IndexPosExamples(parameters);
 }
 
 
@@ -687,27 +877,49 @@ void CompressFinalGraphs(Substructure *sub, Parameters *parameters,
 //
 // PURPOSE: Adds to newLabelList only the labels present in the given
 // graph.  The graph's labels are replaced with indices to the new
-// label list.
+// label list.  Labels are added in order of first use, vertices before
+// edges, each one only once through a map from old to new indices.
 //******************************************************************************
 
 void CompressLabelListWithGraph(LabelList *newLabelList, Graph *graph,
                                 Parameters *parameters)
 {
    ULONG v, e;
+   ULONG i;
+   ULONG *labelMap;
 
    // parameters used
    LabelList *labelList = parameters->labelList;
 
+   labelMap = (ULONG *) malloc(sizeof(ULONG) * (labelList->numLabels + 1));
+   if (labelMap == NULL)
+      OutOfMemoryError("CompressLabelListWithGraph:labelMap");
+   for (i = 0; i < labelList->numLabels; i++)
+      labelMap[i] = VERTEX_UNMAPPED;
+
    // add graph's vertex labels to new label list
    for (v = 0; v < graph->numVertices; v++)
-      graph->vertices[v].label =
-         StoreLabel(& labelList->labels[graph->vertices[v].label],
-                    newLabelList);
+   {
+      i = graph->vertices[v].label;
+      if (labelMap[i] == VERTEX_UNMAPPED)
+         labelMap[i] = StoreLabel(& labelList->labels[i], newLabelList);
+      graph->vertices[v].label = labelMap[i];
+   }
 
    // add graph's edge labels to new label list
    for (e = 0; e < graph->numEdges; e++)
-      graph->edges[e].label =
-           StoreLabel(& labelList->labels[graph->edges[e].label], newLabelList);
+   {
+      i = graph->edges[e].label;
+      if (labelMap[i] == VERTEX_UNMAPPED)
+         labelMap[i] = StoreLabel(& labelList->labels[i], newLabelList);
+      graph->edges[e].label = labelMap[i];
+   }
+   free(labelMap);
+
+   // labels have been renumbered
+   FreeGraphFingerprint(graph);
+   FreeVertexLabelIndex(graph);
+   FreeEdgeTypeIndex(graph);
 }
 
 
@@ -739,6 +951,7 @@ ULONG SizeOfCompressedGraph(Graph *graph, InstanceList *instanceList,
    Instance *instance;
    ULONG v, e;
    BOOLEAN allowInstanceOverlap = parameters->allowInstanceOverlap;
+   Workspace *workspace = parameters->workspace;
 
    size = GraphSize(graph);
 
@@ -748,36 +961,28 @@ ULONG SizeOfCompressedGraph(Graph *graph, InstanceList *instanceList,
       if (allowInstanceOverlap) 
       {
          // reduce size by amount of unique structure, which is marked
+         NewWorkspaceEpoch(workspace, graph);
          while (instanceListNode != NULL) 
          {
             size++; // new "SUB" vertex of instance
             instance = instanceListNode->instance;
             // subtract unique vertices
             for (v = 0; v < instance->numVertices; v++)
-               if (!graph->vertices[instance->vertices[v]].used) 
+               if (! VERTEX_MARKED(workspace, instance->vertices[v])) 
                {
                   size--;
-                  graph->vertices[instance->vertices[v]].used = TRUE;
+                  MARK_VERTEX(workspace, instance->vertices[v]);
                }
             for (e = 0; e < instance->numEdges; e++)   // subtract unique edges
-               if (!graph->edges[instance->edges[e]].used) 
+               if (! EDGE_MARKED(workspace, instance->edges[e])) 
                {
                   size--;
-                  graph->edges[instance->edges[e]].used = TRUE;
+                  MARK_EDGE(workspace, instance->edges[e]);
                }
             instanceListNode = instanceListNode->next;
          }
          // increase size by number of overlap edges (assumes marked instances)
          size += NumOverlapEdges(graph, instanceList, parameters);
-         // reset used flag of instances' vertices and edges
-         instanceListNode = instanceList->head;
-         while (instanceListNode != NULL) 
-         {
-            instance = instanceListNode->instance;
-            MarkInstanceVertices(instance, graph, FALSE);
-            MarkInstanceEdges(instance, graph, FALSE);
-            instanceListNode = instanceListNode->next;
-         }
       }
       else
       {
@@ -812,8 +1017,8 @@ ULONG SizeOfCompressedGraph(Graph *graph, InstanceList *instanceList,
 // are added to all instances sharing the vertex.
 //
 // This procedure assumes all vertices and edges in the instances are
-// marked (used=TRUE) in the graph.  Instance vertices will be
-// unmarked as processed.
+// marked in the workspace.  Instance vertices will be unmarked as
+// processed.
 //******************************************************************************
 
 ULONG NumOverlapEdges(Graph *graph, InstanceList *instanceList, 
@@ -834,6 +1039,7 @@ ULONG NumOverlapEdges(Graph *graph, InstanceList *instanceList,
    Edge *overlapEdges;
    ULONG numOverlapEdges;
    ULONG overlapLabelIndex;
+   Workspace *workspace = parameters->workspace;
 
    overlapLabelIndex = 0; // bogus value never used since graph not compressed
    overlapEdges = NULL;
@@ -848,8 +1054,8 @@ ULONG NumOverlapEdges(Graph *graph, InstanceList *instanceList,
       for (v1 = 0; v1 < instance1->numVertices; v1++) 
       {
          vertex1 = & graph->vertices[instance1->vertices[v1]];
-         if (vertex1->used) 
-         { // (used==TRUE) indicates unchecked for sharing
+         if (VERTEX_MARKED(workspace, instance1->vertices[v1])) 
+         { // marked indicates unchecked for sharing
             // for each instance2 after instance1
             instanceListNode2 = instanceListNode1->next;
             instanceNo2 = instanceNo1 + 1;
@@ -873,7 +1079,7 @@ ULONG NumOverlapEdges(Graph *graph, InstanceList *instanceList,
                      for (e = 0; e < vertex1->numEdges; e++) 
                      {
                         edge1 = & graph->edges[vertex1->edges[e]];
-                        if (! edge1->used) 
+                        if (! EDGE_MARKED(workspace, vertex1->edges[e])) 
                         { // edge external to instance
                            overlapEdges =
                               AddDuplicateEdges(overlapEdges, & numOverlapEdges,
@@ -887,7 +1093,8 @@ ULONG NumOverlapEdges(Graph *graph, InstanceList *instanceList,
                instanceListNode2 = instanceListNode2->next;
                instanceNo2++;
             }
-            vertex1->used = FALSE; // i.e., done processing vertex1 for overlap
+            // i.e., done processing vertex1 for overlap
+            UNMARK_VERTEX(workspace, instance1->vertices[v1]);
          }
       }
       instanceListNode1 = instanceListNode1->next;
@@ -935,6 +1142,7 @@ void RemovePosEgsCovered(Substructure *sub, Parameters *parameters)
    Graph *posGraph            = parameters->posGraph;
    ULONG numPosEgs            = parameters->numPosEgs;
    ULONG *posEgsVertexIndices = parameters->posEgsVertexIndices;
+   Workspace *workspace       = parameters->workspace;
  
    // if no instances, then no changes to positive graph
    if (sub->instances == NULL)
@@ -944,6 +1152,7 @@ void RemovePosEgsCovered(Substructure *sub, Parameters *parameters)
    newNumVertices = 0;
    newNumEdges = 0;
    newPosEgsVertexIndices = NULL;
+   NewWorkspaceEpoch(workspace, posGraph);
    instanceList = sub->instances;
    // for each example, look for a covering instance
    for (posEg = 0; posEg < numPosEgs; posEg++) 
@@ -971,10 +1180,10 @@ void RemovePosEgsCovered(Substructure *sub, Parameters *parameters)
       }
       if (found) 
       {
-         // mark vertices and edges of example (note: these will not be
-         // unmarked, because this posGraph will soon be de-allocated)
+         // mark vertices and edges of example, which are left out of
+         // the new positive graph
          MarkExample(posEgStartVertexIndex, posEgEndVertexIndex,
-                     posGraph, TRUE);
+                     posGraph, workspace);
       } 
       else 
       {
@@ -987,7 +1196,7 @@ void RemovePosEgsCovered(Substructure *sub, Parameters *parameters)
    }
    // count number of edges in examples left uncovered
    for (e = 0; e < posGraph->numEdges; e++)
-      if (! posGraph->edges[e].used)
+      if (! EDGE_MARKED(workspace, e))
          newNumEdges++;
 
    // create new positive graph and copy unmarked part of old
@@ -1003,9 +1212,12 @@ void RemovePosEgsCovered(Substructure *sub, Parameters *parameters)
    // reset positive graph stats and recompute MDL (only needed for printing)
    FreeGraph(parameters->posGraph);
    parameters->posGraph = newPosGraph;
+   FreeGraphStats(parameters->posGraphStats);
+   parameters->posGraphStats = NULL;
    free(parameters->posEgsVertexIndices);
    parameters->posEgsVertexIndices = newPosEgsVertexIndices;
    parameters->numPosEgs = newNumPosEgs;
+   IndexPosExamples(parameters);
    if (parameters->evalMethod == EVAL_MDL)
       parameters->posGraphDL = MDL(newPosGraph, newLabelList->numLabels,
                                    parameters);
@@ -1039,11 +1251,13 @@ void MarkPosEgsCovered(Substructure *sub, Parameters *parameters)
    Graph *posGraph            = parameters->posGraph;
    ULONG numPosEgs            = parameters->numPosEgs;
    ULONG *posEgsVertexIndices = parameters->posEgsVertexIndices;
+   Workspace *workspace       = parameters->workspace;
  
    // if no instances, then no changes to positive graph
    if (sub->instances == NULL)
       return;
 
+   NewWorkspaceEpoch(workspace, posGraph);
    instanceList = sub->instances;
    // for each example, look for a covering instance
    for (posEg = 0; posEg < numPosEgs; posEg++) 
@@ -1071,10 +1285,10 @@ void MarkPosEgsCovered(Substructure *sub, Parameters *parameters)
       }
       if (found) 
       {
-         // mark vertices and edges of example (note: these will not be
-         // unmarked, because this posGraph will soon be de-allocated)
+         // mark vertices and edges of example (note: these stay marked
+         // until the workspace's next epoch)
          MarkExample(posEgStartVertexIndex, posEgEndVertexIndex,
-                     posGraph, TRUE);
+                     posGraph, workspace);
       } 
    }
 }
@@ -1132,16 +1346,16 @@ void WriteUpdatedGraphToFile(Substructure *sub, Parameters *parameters)
 // INPUTS: (ULONG egStartVertexIndex) - starting vertex of example
 //         (ULONG egEndVertexIndex) - ending vertex of example
 //         (Graph *graph) - graph containing example
-//         (BOOLEAN value) - value for used flag of example vertices/edges
+//         (Workspace *workspace) - marks on graph
 //
 // RETURN: (void)
 //
-// PURPOSE: Sets the used flag to value for all vertices and edges
-// comprising the example whose range of vertices is given.
+// PURPOSE: Marks all vertices and edges comprising the example whose
+// range of vertices is given in the workspace's current epoch.
 //******************************************************************************
 
 void MarkExample(ULONG egStartVertexIndex, ULONG egEndVertexIndex,
-                 Graph *graph, BOOLEAN value)
+                 Graph *graph, Workspace *workspace)
 {
    ULONG v;
    ULONG e;
@@ -1150,9 +1364,9 @@ void MarkExample(ULONG egStartVertexIndex, ULONG egEndVertexIndex,
    for (v = egStartVertexIndex; v <= egEndVertexIndex; v++) 
    {
       vertex = & graph->vertices[v];
-      vertex->used = value;
+      MARK_VERTEX(workspace, v);
       for (e = 0; e < vertex->numEdges; e++)
-         graph->edges[vertex->edges[e]].used = value;
+         MARK_EDGE(workspace, vertex->edges[e]);
    }
 }
 
@@ -1160,17 +1374,17 @@ void MarkExample(ULONG egStartVertexIndex, ULONG egEndVertexIndex,
 //******************************************************************************
 // NAME: CopyUnmarkedGraph
 //
-// INPUTS: (Graph *g1) - graph to copy unused structure from
+// INPUTS: (Graph *g1) - graph to copy unmarked structure from
 //         (Graph *g2) - graph to copy to
 //         (ULONG vertexIndex) - index into g2's vertex array where to
-//           start copying unused vertices from g1
+//           start copying unmarked vertices from g1
 //         (Parameters *parameters)
 //
 // RETURN: (void)
 //
-// PURPOSE: Copy unused vertices and edges from g1 to g2, starting at
-// vertexIndex of g2's vertex array.  Ensures that copied edges map to
-// correct vertices in g2.
+// PURPOSE: Copy vertices and edges of g1 not marked in the workspace to g2,
+// starting at vertexIndex of g2's vertex array.  Ensures that copied edges
+// map to correct vertices in g2.
 //******************************************************************************
 
 void CopyUnmarkedGraph(Graph *g1, Graph *g2, ULONG vertexIndex,
@@ -1181,29 +1395,29 @@ void CopyUnmarkedGraph(Graph *g1, Graph *g2, ULONG vertexIndex,
    ULONG edgeIndex;
    char outFileName[FILE_NAME_LEN];
    FILE *outputFile = NULL;
+   Workspace *workspace = parameters->workspace;
 
    if (parameters->prob)
    {
       // write this mapping to the appropriate file
-      strcpy(outFileName,parameters->inputFileName);
-      sprintf(outFileName,"%s.anom%lu",outFileName,
-              parameters->currentIteration);
-      if (!(outputFile = fopen(outFileName, "w")))
+      if ((snprintf(outFileName, FILE_NAME_LEN, "%s.anom%lu",
+                    parameters->inputFileName, parameters->currentIteration)
+           >= FILE_NAME_LEN) ||
+          (!(outputFile = fopen(outFileName, "w"))))
       {
          printf("ERROR (CompressGraph):  Unable to create/open file %s\n",outFileName);
          exit(1);
       }
    }
    //
-   // copy unused vertices from g1 to g2
+   // copy unmarked vertices from g1 to g2
    for (v = 0; v < g1->numVertices; v++)
-      if (! g1->vertices[v].used) 
+      if (! VERTEX_MARKED(workspace, v)) 
       {
          g2->vertices[vertexIndex].label = g1->vertices[v].label;
          g2->vertices[vertexIndex].numEdges = 0;
          g2->vertices[vertexIndex].edges = NULL;
          g2->vertices[vertexIndex].map = VERTEX_UNMAPPED;
-         g2->vertices[vertexIndex].used = FALSE;
          if (parameters->prob)
             fprintf(outputFile,"%lu -> %lu\n",v+1,vertexIndex+1);
          g2->vertices[vertexIndex].anomalous = g1->vertices[v].anomalous;
@@ -1219,10 +1433,10 @@ void CopyUnmarkedGraph(Graph *g1, Graph *g2, ULONG vertexIndex,
    if (parameters->prob)
       fclose(outputFile);
 
-   // copy unused edges from g1 to g2
+   // copy unmarked edges from g1 to g2
    edgeIndex = 0;
    for (e = 0; e < g1->numEdges; e++)
-      if (! g1->edges[e].used) 
+      if (! EDGE_MARKED(workspace, e)) 
       {
          v1 = g1->vertices[g1->edges[e].vertex1].map;
          v2 = g1->vertices[g1->edges[e].vertex2].map;
@@ -1318,4 +1532,5 @@ void CompressWithPredefinedSubs(Parameters *parameters)
       parameters->posGraphDL =
          MDL(posGraph, newLabelList->numLabels, parameters);
    }
+   IndexVertexLabels(posGraph);
 }
@@ -36,7 +36,7 @@ void color_subs(Parameters *parameters, SubList *discoveredSubList)
    COLOR posVertexColor = POSITIVE_NORM_VERTEX;
    COLOR posEdgeColor = POSITIVE_NORM_VERTEX;
    
-   if (currentIteration > 1)
+   if ((currentIteration > 1) || (parameters->originalPosGraph == NULL))
       return;
    
    SubListNode *listNode = discoveredSubList->head;
@@ -96,13 +96,22 @@ void color_subs(Parameters *parameters, SubList *discoveredSubList)
 SubList *DiscoverSubs(Parameters *parameters, ULONG currentIteration)
 {
    SubList *parentSubList;
-   SubList *childSubList;
+   SubBeam *childSubs;
    SubList *extendedSubList;
+   SubBeam *discoveredSubs;
+   SubBeam *sampledSubs;
    SubList *discoveredSubList;
    SubListNode *parentSubListNode;
    SubListNode *extendedSubListNode;
    Substructure *parentSub;
    Substructure *extendedSub;
+   BeamTask *tasks;
+   ULONG numTasks;
+   ULONG nextTask;
+   ULONG taskLimit;
+   BOOLEAN subsEvaluated;
+   InstanceList *allInstances;
+   ULONG level = 0;
 
    //
    // get initial one-vertex substructures
@@ -119,13 +128,83 @@ SubList *DiscoverSubs(Parameters *parameters, ULONG currentIteration)
    ULONG maxVertices    = parameters->maxVertices;
    ULONG minVertices    = parameters->minVertices;
    ULONG outputLevel    = parameters->outputLevel;
-   ULONG evalMethod     = parameters->evalMethod;
+   ULONG numThreads     = parameters->numThreads;
 
-   discoveredSubList = AllocateSubList();
+   //
+   // The discovered substructures and the substructures for the next
+   // level are kept in beams; GBAD-P needs to look at all extensions
+   // after the first iteration, so ignores the beam width (i.e., max
+   // number of substructures being kept).
+   //
+   if (parameters->prob)
+      discoveredSubs = AllocateSubBeam(0, FALSE);
+   else
+      discoveredSubs = AllocateSubBeam(numBestSubs, FALSE);
+   //
+   // With -maxmem, substructures extended from a sample of instances are
+   // valued by estimates, so they are kept apart, without a limit, until
+   // FindSampledSubInstances values them exactly; otherwise, an estimate
+   // could drop an exactly valued substructure from discoveredSubs.
+   //
+   sampledSubs = AllocateSubBeam(0, FALSE);
+   if ((parameters->maxMemory > 0) && (parameters->currentIteration == 1))
+      SetGraphExampleNumbers(parameters);
    while ((limit > 0) && (parentSubList->head != NULL)) 
    {
+      level++;
+      if (parameters->maxMemory > 0)
+         SetSampleFraction(parentSubList, discoveredSubs, sampledSubs, limit,
+                           level, parameters);
       parentSubListNode = parentSubList->head;
-      childSubList = AllocateSubList();
+      if ((parameters->prob) && (parameters->currentIteration > 1))
+         childSubs = AllocateSubBeam(0, TRUE);
+      else
+         childSubs = AllocateSubBeam(beamWidth, valueBased);
+      //
+      // With several threads, the parents to be extended at this level
+      // are extended (and evaluated, if possible) concurrently first.  The
+      // results are then used below in parent order, exactly as if they
+      // were computed serially, so the output does not change.
+      //
+      tasks = NULL;
+      nextTask = 0;
+      if (numThreads > 1)
+      {
+         numTasks = 0;
+         while (parentSubListNode != NULL)
+         {
+            numTasks++;
+            parentSubListNode = parentSubListNode->next;
+         }
+         tasks = (BeamTask *) malloc(sizeof(BeamTask) * (numTasks + 1));
+         if (tasks == NULL)
+            OutOfMemoryError("DiscoverSubs:tasks");
+         numTasks = 0;
+         taskLimit = limit;
+         parentSubListNode = parentSubList->head;
+         while (parentSubListNode != NULL)
+         {
+            if (SubToBeExtended(parentSubListNode->sub, parameters) &&
+                (taskLimit > 0))
+            {
+               taskLimit--;
+               tasks[numTasks].parentSub = parentSubListNode->sub;
+               tasks[numTasks].allInstances = NULL;
+               if (parameters->maxMemory > 0)
+                  tasks[numTasks].allInstances =
+                     SampleSubInstances(parentSubListNode->sub, parameters);
+               numTasks++;
+            }
+            parentSubListNode = parentSubListNode->next;
+         }
+         ExtendBeamLevel(tasks, numTasks, parameters);
+         for (nextTask = 0; nextTask < numTasks; nextTask++)
+            if (tasks[nextTask].allInstances != NULL)
+               RestoreSubInstances(tasks[nextTask].parentSub,
+                                   tasks[nextTask].allInstances);
+         nextTask = 0;
+         parentSubListNode = parentSubList->head;
+      }
       // extend each substructure in parent list
       while (parentSubListNode != NULL)
       {
@@ -139,24 +218,38 @@ SubList *DiscoverSubs(Parameters *parameters, ULONG currentIteration)
             printf("\n");
             parameters->outputLevel = outputLevel;
          }
-         if ((((parentSub->numInstances > 1) && (evalMethod != EVAL_SETCOVER) &&
-               (parameters->noAnomalyDetection)) ||
-              ((parentSub->numInstances > 1) &&
-               (!parameters->noAnomalyDetection))) &&
-             (limit > 0))
+         if (SubToBeExtended(parentSub, parameters) && (limit > 0))
          {
             limit--;
             if (outputLevel > 3)
                printf("%lu substructures left to be considered\n", limit);
             fflush(stdout);
-            extendedSubList = ExtendSub(parentSub, parameters);
+            if (tasks != NULL)
+            {
+               // already extended by ExtendBeamLevel
+               extendedSubList = tasks[nextTask].extendedSubList;
+               subsEvaluated = tasks[nextTask].evaluated;
+               nextTask++;
+            }
+            else
+            {
+               allInstances = NULL;
+               if (parameters->maxMemory > 0)
+                  allInstances = SampleSubInstances(parentSub, parameters);
+               extendedSubList = ExtendSub(parentSub, parameters);
+               if (allInstances != NULL)
+                  RestoreSubInstances(parentSub, allInstances);
+               subsEvaluated = FALSE;
+            }
             //
             // If this is the first iteration, call SetExampleNumber
             // so that the edges in each of the possible instances
             // has the associated original example number.  This will make
-            // it easier for tracking the anomalies later.
+            // it easier for tracking the anomalies later.  (With -maxmem,
+            // SetGraphExampleNumbers has already set them all.)
             //
-            if (parameters->currentIteration == 1)
+            if ((parameters->currentIteration == 1) &&
+                (parameters->maxMemory == 0))
                SetExampleNumber(extendedSubList,parameters);
 	    //
             extendedSubListNode = extendedSubList->head;
@@ -167,25 +260,14 @@ SubList *DiscoverSubs(Parameters *parameters, ULONG currentIteration)
                if (extendedSub->definition->numVertices <= maxVertices) 
                {
                   // evaluate each extension and add to child list
-                  EvaluateSub(extendedSub, parameters);
+                  if (! subsEvaluated)
+                     EvaluateSub(extendedSub, parameters);
                   if (prune && (extendedSub->value < parentSub->value)) 
                   {
                      FreeSub(extendedSub);
                   } 
                   else 
-                  {
-                     //
-                     // Need to look at all extensions, so
-                     // ignore the beam width (i.e., max number of
-                     // substructures being kept on the list).
-                     //
-                     if ((parameters->prob) && (parameters->currentIteration > 1))
-                        SubListInsert(extendedSub, childSubList, 0,
-                                      TRUE, labelList);
-                     else
-                        SubListInsert(extendedSub, childSubList, beamWidth,
-                                      valueBased, labelList);
-                  }
+                     SubBeamInsert(extendedSub, childSubs, labelList);
                } 
                else 
                {
@@ -201,13 +283,11 @@ SubList *DiscoverSubs(Parameters *parameters, ULONG currentIteration)
             if ((! SinglePreviousSub(parentSub, parameters)) || (parameters->prob))
             {
                if (outputLevel > 3)
-                  PrintNewBestSub(parentSub, discoveredSubList, parameters);
-               if (parameters->prob)
-                  SubListInsert(parentSub, discoveredSubList, 0, FALSE, 
-                                labelList);
+                  PrintNewBestSub(parentSub, discoveredSubs, parameters);
+               if (parentSub->instanceScale > 1.0)
+                  SubBeamInsert(parentSub, sampledSubs, labelList);
                else
-                  SubListInsert(parentSub, discoveredSubList, numBestSubs, FALSE,
-                                labelList);
+                  SubBeamInsert(parentSub, discoveredSubs, labelList);
             }
          } 
          else 
@@ -216,8 +296,9 @@ SubList *DiscoverSubs(Parameters *parameters, ULONG currentIteration)
          }
          parentSubListNode = parentSubListNode->next;
       }
+      free(tasks);
       FreeSubList(parentSubList);
-      parentSubList = childSubList;
+      parentSubList = SubBeamToList(childSubs);
       //
       // GBAD-P:  This allows us to create only single extensions after the
       //          first iteration (and the normative pattern has been found)
@@ -240,12 +321,11 @@ SubList *DiscoverSubs(Parameters *parameters, ULONG currentIteration)
          if ((! SinglePreviousSub(parentSub, parameters)) || (parameters->prob))
 	 {
             if (outputLevel > 3)
-               PrintNewBestSub(parentSub, discoveredSubList, parameters);
-            if (parameters->prob)
-               SubListInsert(parentSub, discoveredSubList, 0, FALSE, labelList);
+               PrintNewBestSub(parentSub, discoveredSubs, parameters);
+            if (parentSub->instanceScale > 1.0)
+               SubBeamInsert(parentSub, sampledSubs, labelList);
             else
-               SubListInsert(parentSub, discoveredSubList, numBestSubs, FALSE,
-                             labelList);
+               SubBeamInsert(parentSub, discoveredSubs, labelList);
          }
       } 
       else 
@@ -255,6 +335,8 @@ SubList *DiscoverSubs(Parameters *parameters, ULONG currentIteration)
       parentSubListNode = parentSubListNode->next;
    }
    FreeSubList(parentSubList);
+   FindSampledSubInstances(sampledSubs, discoveredSubs, parameters);
+   discoveredSubList = SubBeamToList(discoveredSubs);
    
    // GUI coloring
    color_subs(parameters, discoveredSubList);
@@ -263,6 +345,279 @@ SubList *DiscoverSubs(Parameters *parameters, ULONG currentIteration)
 }
 
 
+//******************************************************************************
+// NAME: SubToBeExtended
+//
+// INPUTS: (Substructure *sub) - substructure from parent list
+//         (Parameters *parameters)
+//
+// RETURN: (BOOLEAN) - TRUE if sub is to be extended (limit permitting)
+//
+// PURPOSE: Decide whether DiscoverSubs extends a substructure; only
+// substructures with more than one instance are extended, and, without
+// anomaly detection, none when evaluating by set cover.
+//******************************************************************************
+
+BOOLEAN SubToBeExtended(Substructure *sub, Parameters *parameters)
+{
+   return (((sub->numInstances > 1) &&
+            (parameters->evalMethod != EVAL_SETCOVER) &&
+            (parameters->noAnomalyDetection)) ||
+           ((sub->numInstances > 1) && (! parameters->noAnomalyDetection)));
+}
+
+
+//******************************************************************************
+// NAME: SetSampleFraction
+//
+// INPUTS: (SubList *parentSubList) - substructures to be extended next
+//         (SubBeam *discoveredSubs) - substructures discovered so far
+//         (SubBeam *sampledSubs) - those of them extended from samples
+//         (ULONG limit) - number of substructures left to be extended
+//         (ULONG level) - beam level about to be extended
+//         (Parameters *parameters)
+//
+// RETURN: (void)
+//
+// PURPOSE: Report the memory held in instance lists at the start of a beam
+// level, and, if extending the instances of all the parents to be extended
+// at this level would take more memory than parameters->maxMemory leaves,
+// set parameters->sampleFraction to the fraction of their instances that
+// fits (see SampleSubInstances), and report how many instances are then
+// extended.  The fraction depends only on the beam, so results do not
+// depend on the number of threads.
+//******************************************************************************
+
+void SetSampleFraction(SubList *parentSubList, SubBeam *discoveredSubs,
+                       SubBeam *sampledSubs, ULONG limit, ULONG level,
+                       Parameters *parameters)
+{
+   SubListNode *subListNode;
+   Substructure *sub;
+   double heldBytes = 0.0;
+   double extensionBytes = 0.0;
+   double freeBytes;
+   ULONG numParents = 0;
+   ULONG numInstances = 0;
+   ULONG numSampled = 0;
+   ULONG i;
+
+   subListNode = parentSubList->head;
+   while (subListNode != NULL)
+   {
+      sub = subListNode->sub;
+      heldBytes += (double) InstanceListBytes(sub->instances);
+      if (SubToBeExtended(sub, parameters) && (numParents < limit))
+      {
+         numParents++;
+         numInstances += sub->instances->numNodes;
+         extensionBytes += ExtensionBytes(sub->instances, parameters->posGraph);
+      }
+      subListNode = subListNode->next;
+   }
+   for (i = 0; i < discoveredSubs->numEntries; i++)
+      heldBytes +=
+         (double) InstanceListBytes(discoveredSubs->heap[i]->sub->instances);
+   for (i = 0; i < sampledSubs->numEntries; i++)
+      heldBytes +=
+         (double) InstanceListBytes(sampledSubs->heap[i]->sub->instances);
+
+   freeBytes = (double) parameters->maxMemory - heldBytes;
+   parameters->sampleFraction = 1.0;
+   if (extensionBytes > freeBytes)
+      parameters->sampleFraction =
+         (freeBytes > 0.0) ? (freeBytes / extensionBytes) : 0.0;
+   printf("Beam level %lu: %.1f MB held in instance lists, ", level,
+          heldBytes / (1024.0 * 1024.0));
+   printf("%lu substructures to extend", numParents);
+   if (parameters->sampleFraction < 1.0)
+   {
+      // report the instances actually extended, since each substructure
+      // extends at least MIN_SAMPLE_INSTANCES of them
+      numParents = 0;
+      subListNode = parentSubList->head;
+      while (subListNode != NULL)
+      {
+         sub = subListNode->sub;
+         if (SubToBeExtended(sub, parameters) && (numParents < limit))
+         {
+            numParents++;
+            numSampled += SampleSize(sub->instances->numNodes, parameters);
+         }
+         subListNode = subListNode->next;
+      }
+      if (freeBytes <= 0.0)
+         printf(", memory limit exceeded");
+      printf(", sampling %lu of %lu instances (%.1f%%)", numSampled,
+             numInstances, (100.0 * numSampled) / numInstances);
+   }
+   printf("\n");
+   fflush(stdout);
+}
+
+
+//******************************************************************************
+// NAME: FindSampledSubInstances
+//
+// INPUTS: (SubBeam *sampledSubs) - substructures discovered that were
+//                                  extended from a sample of instances
+//         (SubBeam *discoveredSubs) - other substructures discovered
+//         (Parameters *parameters)
+//
+// RETURN: (void)
+//
+// PURPOSE: With -maxmem, the discovered substructures that were extended
+// from a sample of instances hold only some of their instances, and were
+// evaluated with scaled estimates.  Find all of their instances in the
+// positive graph, as for predefined substructures, evaluate them again,
+// and insert them in discoveredSubs, which then keeps the best of all
+// substructures by their exact values.  Samples of the same substructure
+// then have the same value, so only one of them is kept.  sampledSubs is
+// freed.
+//******************************************************************************
+
+void FindSampledSubInstances(SubBeam *sampledSubs, SubBeam *discoveredSubs,
+                             Parameters *parameters)
+{
+   SubList *subList;
+   SubListNode *subListNode;
+   Substructure *sub;
+
+   subList = SubBeamToList(sampledSubs);
+   subListNode = subList->head;
+   while (subListNode != NULL)
+   {
+      sub = subListNode->sub;
+      subListNode->sub = NULL;
+      FreeInstanceList(sub->instances);
+      sub->instances = FindInstances(sub->definition, parameters->posGraph,
+                                     parameters);
+      sub->numInstances = sub->instances->numNodes;
+      sub->instanceScale = 1.0;
+      EvaluateSub(sub, parameters);
+      SubBeamInsert(sub, discoveredSubs, parameters->labelList);
+      subListNode = subListNode->next;
+   }
+   FreeSubList(subList);
+}
+
+
+//******************************************************************************
+// NAME: ExtendBeamLevel
+//
+// INPUTS: (BeamTask *tasks) - parent substructures to be extended
+//         (ULONG numTasks) - number of tasks
+//         (Parameters *parameters)
+//
+// RETURN: (void)
+//
+// PURPOSE: Extend the parent substructures of the tasks using
+// parameters->numThreads worker threads, storing each parent's extensions
+// in its task.  The workers also evaluate the extensions, unless instances
+// may overlap, in which case evaluation compresses (and so marks) the
+// shared positive graph and is left to the caller.
+//******************************************************************************
+
+void ExtendBeamLevel(BeamTask *tasks, ULONG numTasks, Parameters *parameters)
+{
+   BeamTaskQueue queue;
+   pthread_t *threads;
+   ULONG numThreads = parameters->numThreads;
+   ULONG t;
+
+   queue.tasks = tasks;
+   queue.numTasks = numTasks;
+   queue.nextTask = 0;
+   queue.evaluate = (! parameters->allowInstanceOverlap);
+   queue.parameters = parameters;
+   for (t = 0; t < numTasks; t++)
+   {
+      tasks[t].extendedSubList = NULL;
+      tasks[t].evaluated = queue.evaluate;
+   }
+
+   // set up shared state that evaluation would otherwise create on demand,
+   // so that workers only read it
+   Log2Factorial(parameters->posGraph->numVertices, parameters);
+   if ((queue.evaluate) && (parameters->evalMethod == EVAL_MDL) &&
+       (parameters->posGraphStats == NULL))
+      parameters->posGraphStats = ComputeGraphStats(parameters->posGraph);
+
+   if (numThreads > numTasks)
+      numThreads = numTasks;
+   threads = (pthread_t *) malloc(sizeof(pthread_t) * (numThreads + 1));
+   if (threads == NULL)
+      OutOfMemoryError("ExtendBeamLevel:threads");
+   pthread_mutex_init(& queue.mutex, NULL);
+   for (t = 0; t < numThreads; t++)
+      if (pthread_create(& threads[t], NULL, BeamWorker, & queue) != 0)
+      {
+         fprintf(stderr, "ExtendBeamLevel: unable to create thread\n");
+         exit(1);
+      }
+   for (t = 0; t < numThreads; t++)
+      pthread_join(threads[t], NULL);
+   pthread_mutex_destroy(& queue.mutex);
+   free(threads);
+}
+
+
+//******************************************************************************
+// NAME: BeamWorker
+//
+// INPUTS: (void *arg) - BeamTaskQueue shared by workers
+//
+// RETURN: (void *) - NULL
+//
+// PURPOSE: Thread function taking tasks from the queue until none are
+// left.  Each worker uses a private copy of the parameters with its own
+// workspace and match context, so nothing shared is written while extending and evaluating.
+// Workers match candidate instances serially rather than start threads of
+// their own.
+//******************************************************************************
+
+void *BeamWorker(void *arg)
+{
+   BeamTaskQueue *queue = (BeamTaskQueue *) arg;
+   Parameters threadParameters = *(queue->parameters);
+   BeamTask *task;
+   SubListNode *subListNode;
+   Substructure *sub;
+   ULONG t;
+
+   threadParameters.workspace = AllocateWorkspace();
+   threadParameters.matchContext = AllocateMatchContext();
+   threadParameters.numThreads = 1; // workers match instances themselves
+   while (TRUE)
+   {
+      pthread_mutex_lock(& queue->mutex);
+      t = queue->nextTask;
+      if (t < queue->numTasks)
+         queue->nextTask++;
+      pthread_mutex_unlock(& queue->mutex);
+      if (t >= queue->numTasks)
+         break;
+
+      task = & queue->tasks[t];
+      task->extendedSubList = ExtendSub(task->parentSub, & threadParameters);
+      if (queue->evaluate)
+      {
+         subListNode = task->extendedSubList->head;
+         while (subListNode != NULL)
+         {
+            sub = subListNode->sub;
+            if (sub->definition->numVertices <= threadParameters.maxVertices)
+               EvaluateSub(sub, & threadParameters);
+            subListNode = subListNode->next;
+         }
+      }
+   }
+   FreeWorkspace(threadParameters.workspace);
+   FreeMatchContext(threadParameters.matchContext);
+   return NULL;
+}
+
+
 //******************************************************************************
 // NAME: GetInitialSubs
 //
@@ -276,13 +631,16 @@ SubList *DiscoverSubs(Parameters *parameters, ULONG currentIteration)
 
 SubList *GetInitialSubs(Parameters *parameters)
 {
-   SubList *initialSubs;
+   SubBeam *initialSubs;
    ULONG i, j;
    ULONG vertexLabelIndex;
+   ULONG *vertices;
+   ULONG numVertices;
    ULONG numInitialSubs;
    Graph *g;
    Substructure *sub;
    Instance *instance;
+   BOOLEAN *labelSeen;
 
    // parameters used
    Graph *posGraph      = parameters->posGraph;
@@ -292,18 +650,21 @@ SubList *GetInitialSubs(Parameters *parameters)
 
    startVertexIndex = 0;
 
-   // reset labels' used flag
+   // labels whose substructure has already been created
+   labelSeen = (BOOLEAN *) malloc(sizeof(BOOLEAN) * labelList->numLabels);
+   if (labelSeen == NULL)
+      OutOfMemoryError("GetInitialSubs:labelSeen");
    for (i = 0; i < labelList->numLabels; i++)
-      labelList->labels[i].used = FALSE;
+      labelSeen[i] = FALSE;
   
    numInitialSubs = 0;
-   initialSubs = AllocateSubList();
+   initialSubs = AllocateSubBeam(0, FALSE);
    for (i = startVertexIndex; i < posGraph->numVertices; i++)
    {
       vertexLabelIndex = posGraph->vertices[i].label;
-      if (labelList->labels[vertexLabelIndex].used == FALSE) 
+      if (labelSeen[vertexLabelIndex] == FALSE) 
       {
-         labelList->labels[vertexLabelIndex].used = TRUE;
+         labelSeen[vertexLabelIndex] = TRUE;
 
          // create one-vertex substructure definition
          g = AllocateGraph(1, 0);
@@ -314,24 +675,23 @@ SubList *GetInitialSubs(Parameters *parameters)
          sub = AllocateSub();
          sub->definition = g;
          sub->instances = AllocateInstanceList();
-         // collect instances in positive graph
-         j = posGraph->numVertices;
-         do 
+         // collect instances in positive graph, last vertex first
+         vertices = VerticesWithLabel(posGraph, vertexLabelIndex,
+                                      & numVertices);
+         j = numVertices;
+         while (j > 0) 
          {
             j--;
-            if (posGraph->vertices[j].label == vertexLabelIndex) 
-            {
-               // ***** do inexact label matches here? (instance->minMatchCost
-               // ***** too)
-               instance = AllocateInstance(1, 0);
-               instance->vertices[0] = j;
-               instance->mapping[0].v1 = 0;
-               instance->mapping[0].v2 = j;
-               instance->minMatchCost = 0.0;
-               InstanceListInsert(instance, sub->instances, FALSE);
-               sub->numInstances++;
-            }
-         } while (j > i);
+            // ***** do inexact label matches here? (instance->minMatchCost
+            // ***** too)
+            instance = AllocateInstance(1, 0);
+            instance->vertices[0] = vertices[j];
+            instance->mapping[0].v1 = 0;
+            instance->mapping[0].v2 = vertices[j];
+            instance->minMatchCost = 0.0;
+            InstanceListInsert(instance, sub->instances, FALSE);
+            sub->numInstances++;
+         }
 
          //
          // Only keep substructures if more than one positive
@@ -350,7 +710,7 @@ SubList *GetInitialSubs(Parameters *parameters)
          {
             EvaluateSub(sub, parameters);
             // add to initialSubs
-            SubListInsert(sub, initialSubs, 0, FALSE, labelList);
+            SubBeamInsert(sub, initialSubs, labelList);
             numInitialSubs++;
          } 
          else 
@@ -359,10 +719,11 @@ SubList *GetInitialSubs(Parameters *parameters)
          }
       }
    }
+   free(labelSeen);
    if (outputLevel > 1)
       printf("%lu initial substructures\n", numInitialSubs);
 
-   return initialSubs;
+   return SubBeamToList(initialSubs);
 }
 
 
@@ -156,6 +156,7 @@ void WriteGraphWithInstancesToDotFile(char *dotFileName, Graph *graph,
 
    // parameters used
    LabelList *labelList = parameters->labelList;
+   Workspace *workspace = parameters->workspace;
 
    // open dot file for writing
    dotFile = fopen(dotFileName, "w");
@@ -171,6 +172,7 @@ void WriteGraphWithInstancesToDotFile(char *dotFileName, Graph *graph,
 
    vertexOffset = 0; // always zero for writing just one graph
    // first write instances of graph to dot file
+   NewWorkspaceEpoch(workspace, graph);
    i = 0;
    instanceListNode = instanceList->head;
    while (instanceListNode != NULL) 
@@ -182,35 +184,25 @@ void WriteGraphWithInstancesToDotFile(char *dotFileName, Graph *graph,
       for (e = 0; e < instance->numEdges; e++)
          WriteEdgeToDotFile(dotFile, instance->edges[e], vertexOffset,
                             graph, labelList, "blue");
-      MarkInstanceVertices(instance, graph, TRUE);
-      MarkInstanceEdges(instance, graph, TRUE);
+      MarkInstanceVertices(instance, workspace);
+      MarkInstanceEdges(instance, workspace);
       instanceListNode = instanceListNode->next;
       i++;
    }
 
    // write rest of graph to dot file
    for (v = 0; v < graph->numVertices; v++)
-      if (! graph->vertices[v].used)
+      if (! VERTEX_MARKED(workspace, v))
          WriteVertexToDotFile(dotFile, v, vertexOffset, graph, labelList,
                               "black");
    for (e = 0; e < graph->numEdges; e++)
-      if (! graph->edges[e].used)
+      if (! EDGE_MARKED(workspace, e))
          WriteEdgeToDotFile(dotFile, e, vertexOffset, graph, labelList,
                             "black");
 
    // write end of dot file
    fprintf(dotFile, "}\n");
    fclose(dotFile);
-
-   // unmark instance vertices and edges
-   instanceListNode = instanceList->head;
-   while (instanceListNode != NULL) 
-   {
-      instance = instanceListNode->instance;
-      MarkInstanceVertices(instance, graph, FALSE);
-      MarkInstanceEdges(instance, graph, FALSE);
-      instanceListNode = instanceListNode->next;
-   }
 }
 
 
@@ -52,10 +52,12 @@ void EvaluateSub(Substructure *sub, Parameters *parameters)
    double sizeOfSub;
    double sizeOfPosGraph;
    double sizeOfCompressedPosGraph;
+   double labelBits;
    double subValue = 0.0;
    Graph *compressedGraph;
    ULONG numLabels;
    ULONG posEgsCovered;
+   GraphStats *posGraphStats;
 
    // parameters used
    Graph *posGraph              = parameters->posGraph;
@@ -74,16 +76,46 @@ void EvaluateSub(Substructure *sub, Parameters *parameters)
          numLabels = labelList->numLabels;
          sizeOfSub = MDL(sub->definition, numLabels, parameters);
          sizeOfPosGraph = posGraphDL; // cached at beginning
-         compressedGraph = CompressGraph(posGraph, sub->instances, parameters);
-         numLabels++; // add one for new "SUB" vertex label
-         if ((allowInstanceOverlap) && (InstancesOverlap(sub->instances)))
-            numLabels++; // add one for new "OVERLAP" edge label
-         sizeOfCompressedPosGraph = MDL(compressedGraph, numLabels, parameters);
-         // add extra bits to describe where external edges connect to instances
-         sizeOfCompressedPosGraph +=
-            ExternalEdgeBits(compressedGraph,sub->definition,sub->numInstances);
+         if (allowInstanceOverlap)
+         {
+            compressedGraph = CompressGraph(posGraph, sub->instances,
+                                            parameters);
+            numLabels++; // add one for new "SUB" vertex label
+            if (InstancesOverlap(sub->instances))
+               numLabels++; // add one for new "OVERLAP" edge label
+            sizeOfCompressedPosGraph = MDL(compressedGraph, numLabels,
+                                           parameters);
+            // add extra bits to describe where external edges connect to
+            // instances
+            sizeOfCompressedPosGraph +=
+               ExternalEdgeBits(compressedGraph, sub->definition,
+                                sub->numInstances);
+            FreeGraph(compressedGraph);
+         }
+         else
+         {
+            // Without "OVERLAP" edges, the compressed graph differs from
+            // the positive graph only around the instances, so its size
+            // is computed from the positive graph's cached statistics
+            // without actually compressing.
+            posGraphStats = parameters->posGraphStats;
+            if (posGraphStats == NULL)
+            {
+               posGraphStats = ComputeGraphStats(posGraph);
+               parameters->posGraphStats = posGraphStats;
+            }
+            numLabels++; // add one for new "SUB" vertex label
+            sizeOfCompressedPosGraph =
+               CompressedGraphMDL(posGraph, posGraphStats, sub, numLabels,
+                                  parameters);
+         }
+         // bits added to every vertex and edge label by the new labels
+         labelBits = (posGraph->numVertices + posGraph->numEdges) *
+                     (Log2(numLabels) - Log2(labelList->numLabels));
+         sizeOfCompressedPosGraph =
+            ScaleCompressedSize(sizeOfPosGraph, labelBits,
+                                sizeOfCompressedPosGraph, sub);
          subValue = sizeOfPosGraph / (sizeOfSub + sizeOfCompressedPosGraph);
-         FreeGraph(compressedGraph);
       break;
 
       case EVAL_SIZE:
@@ -92,12 +124,21 @@ void EvaluateSub(Substructure *sub, Parameters *parameters)
          sizeOfCompressedPosGraph =
            (double) SizeOfCompressedGraph(posGraph, sub->instances,
                                           parameters, POS);
+         sizeOfCompressedPosGraph =
+            ScaleCompressedSize(sizeOfPosGraph, 0.0, sizeOfCompressedPosGraph,
+                                sub);
          subValue = sizeOfPosGraph / (sizeOfSub + sizeOfCompressedPosGraph);
 
       break;
 
       case EVAL_SETCOVER:
          posEgsCovered = PosExamplesCovered(sub, parameters);
+         if (sub->instanceScale > 1.0)
+         {
+            posEgsCovered = (ULONG) (posEgsCovered * sub->instanceScale);
+            if (posEgsCovered > numPosEgs)
+               posEgsCovered = numPosEgs;
+         }
          subValue = ((double) (posEgsCovered)) / ((double) (numPosEgs));
          break;
    }
@@ -107,6 +148,42 @@ void EvaluateSub(Substructure *sub, Parameters *parameters)
 }
 
 
+//******************************************************************************
+// NAME: ScaleCompressedSize
+//
+// INPUTS: (double sizeOfGraph) - size of positive graph
+//         (double labelBits) - size added to positive graph by the labels
+//                              that compressing it adds
+//         (double sizeOfCompressedGraph) - size of positive graph compressed
+//                                          with the instances of sub
+//         (Substructure *sub) - substructure evaluated
+//
+// RETURN: (double) - size of positive graph compressed with all instances
+//
+// PURPOSE: If sub was extended from a sample of its parent's instances
+// (-maxmem), each of its instances stands for sub->instanceScale of them in
+// the positive graph, so estimate the size compressed with all of them by
+// scaling the reduction in size achieved by the instances kept.  The
+// labels added by compression cost the same however many instances are
+// compressed, so labelBits is not scaled.
+//******************************************************************************
+
+double ScaleCompressedSize(double sizeOfGraph, double labelBits,
+                           double sizeOfCompressedGraph, Substructure *sub)
+{
+   double size;
+
+   if (sub->instanceScale <= 1.0)
+      return sizeOfCompressedGraph;
+   size = sizeOfGraph + labelBits -
+          (sub->instanceScale *
+           (sizeOfGraph + labelBits - sizeOfCompressedGraph));
+   if (size < 0.0)
+      size = 0.0;
+   return size;
+}
+
+
 //******************************************************************************
 // NAME: GraphSize
 //
@@ -172,6 +249,17 @@ double MDL(Graph *graph, ULONG numLabels, Parameters *parameters)
    ULONG K;  // number of 1s in adjacency matrix
    ULONG M;  // maximum number of edges between any two vertices
    ULONG tmpM;
+   GraphStats *stats;
+
+   // row statistics of the positive graph are kept for later calls
+   if (graph == parameters->posGraph)
+   {
+      if (parameters->posGraphStats == NULL)
+         parameters->posGraphStats = ComputeGraphStats(graph);
+      stats = parameters->posGraphStats;
+   }
+   else
+      stats = ComputeGraphStats(graph);
 
    V = graph->numVertices;
    E = graph->numEdges;
@@ -184,7 +272,7 @@ double MDL(Graph *graph, ULONG numLabels, Parameters *parameters)
    M = 0;
    for (v1 = 0; v1 < V; v1++) 
    {
-      ki = NumUniqueEdges(graph, v1);
+      ki = stats->uniqueEdges[v1];
       rowBits -= (Log2Factorial(ki, parameters) +
                   Log2Factorial((V - ki), parameters));
       if (ki > B) 
@@ -192,7 +280,7 @@ double MDL(Graph *graph, ULONG numLabels, Parameters *parameters)
          B = ki;
       }
       K += ki;
-      tmpM = MaxEdgesToSingleVertex(graph, v1);
+      tmpM = stats->maxEdges[v1];
       if (tmpM > M) 
       {
          M = tmpM;
@@ -202,120 +290,507 @@ double MDL(Graph *graph, ULONG numLabels, Parameters *parameters)
    edgeBits += ((K + 1) * Log2(M));
    totalBits = vertexBits + rowBits + edgeBits;
 
+   if (stats != parameters->posGraphStats)
+      FreeGraphStats(stats);
+
    return totalBits;
 }
 
 
 //******************************************************************************
-// NAME: NumUniqueEdges
+// NAME: VertexRowStats
 //
 // INPUTS: (Graph *graph) - graph containing vertex
-//         (ULONG v1) - vertex to find number of unique edges
+//         (ULONG v1) - vertex whose adjacency matrix row is computed
+//         (ULONG *numOutgoing) - per-vertex counters, all zero on entry
+//         (ULONG *numUndirected) - per-vertex counters, all zero on entry
+//         (ULONG *uniqueEdges) - returns number of unique edges of v1
+//         (ULONG *maxEdges) - returns maximum edges from v1 to one vertex
 //
-// RETURN: (ULONG) - number of unique edges of vertex v1
+// RETURN: (void)
 //
 // PURPOSE: Compute the number of different vertices that vertex v1 has an
-// edge to.  If edge is undirected, then it is included only if connected
-// to a larger-numbered vertex (or itself).  This prevents double counting
-// undirected edges.
+// edge to, and the maximum number of edges between v1 and another vertex
+// (including v1 itself).  If edge is undirected, then it is included only
+// if connected to a larger-numbered vertex (or itself).  This prevents
+// double counting undirected edges.  Once an undirected edge to a vertex
+// is counted, all later edges to that vertex count towards the maximum.
+// The counters are indexed by neighbor, so each edge is visited only
+// twice; they are reset to zero before returning.
 //******************************************************************************
 
-ULONG NumUniqueEdges(Graph *graph, ULONG v1)
+void VertexRowStats(Graph *graph, ULONG v1, ULONG *numOutgoing,
+                    ULONG *numUndirected, ULONG *uniqueEdges,
+                    ULONG *maxEdges)
 {
    ULONG e;
    ULONG v2;
    Edge *edge;
-   ULONG numUniqueEdges;
+   Vertex *vertex = & graph->vertices[v1];
 
-   numUniqueEdges = 0;
-   // look through all edges of vertex v1
-   for (e = 0; e < graph->vertices[v1].numEdges; e++) 
+   *uniqueEdges = 0;
+   *maxEdges = 0;
+   // count edges to each neighbor
+   for (e = 0; e < vertex->numEdges; e++) 
+   {
+      edge = & graph->edges[vertex->edges[e]];
+      if (edge->vertex1 == v1)
+         v2 = edge->vertex2;
+      else 
+         v2 = edge->vertex1;
+      if ((edge->directed) && (edge->vertex1 == v1)) // out-going edge
+         numOutgoing[v2]++;
+      if (numUndirected[v2] > 0)
+         numUndirected[v2]++;
+      else if ((! edge->directed) && (v2 >= v1))
+         numUndirected[v2] = 1;
+   }
+   // collect counts of each neighbor once, resetting them
+   for (e = 0; e < vertex->numEdges; e++) 
    {
-      edge = & graph->edges[graph->vertices[v1].edges[e]];
+      edge = & graph->edges[vertex->edges[e]];
       if (edge->vertex1 == v1)
          v2 = edge->vertex2;
       else 
          v2 = edge->vertex1;
-      // check if edge connected to unique vertex
-      if (((edge->directed) && (edge->vertex1 == v1)) || // out-going edge
-          ((! edge->directed) && (v2 >= v1))) 
+      if ((numOutgoing[v2] > 0) || (numUndirected[v2] > 0))
       {
-         if (! graph->vertices[v2].used) 
-         {
-            numUniqueEdges++;
-            graph->vertices[v2].used = TRUE;
-         }
+         (*uniqueEdges)++;
+         if (numOutgoing[v2] > *maxEdges)
+            *maxEdges = numOutgoing[v2];
+         if (numUndirected[v2] > *maxEdges)
+            *maxEdges = numUndirected[v2];
+         numOutgoing[v2] = 0;
+         numUndirected[v2] = 0;
       }
    }
-   // reset vertex used flags
-   for (e = 0; e < graph->vertices[v1].numEdges; e++) 
+}
+
+
+//******************************************************************************
+// NAME: ComputeGraphStats
+//
+// INPUTS: (Graph *graph) - graph whose statistics are computed
+//
+// RETURN: (GraphStats *) - newly allocated statistics of graph
+//
+// PURPOSE: Compute the per-vertex adjacency matrix statistics used by the
+// MDL computation (see MDL), so that CompressedGraphMDL only needs to
+// recompute them for vertices affected by compression.
+//******************************************************************************
+
+GraphStats *ComputeGraphStats(Graph *graph)
+{
+   GraphStats *stats;
+   ULONG v;
+   ULONG *numOutgoing;
+   ULONG *numUndirected;
+
+   stats = (GraphStats *) malloc(sizeof(GraphStats));
+   if (stats == NULL)
+      OutOfMemoryError("ComputeGraphStats:stats");
+   stats->numVertices = graph->numVertices;
+   stats->uniqueEdges =
+      (ULONG *) malloc(sizeof(ULONG) * (graph->numVertices + 1));
+   stats->maxEdges =
+      (ULONG *) malloc(sizeof(ULONG) * (graph->numVertices + 1));
+   if ((stats->uniqueEdges == NULL) || (stats->maxEdges == NULL))
+      OutOfMemoryError("ComputeGraphStats:stats->uniqueEdges");
+   numOutgoing = (ULONG *) calloc(graph->numVertices + 1, sizeof(ULONG));
+   numUndirected = (ULONG *) calloc(graph->numVertices + 1, sizeof(ULONG));
+   if ((numOutgoing == NULL) || (numUndirected == NULL))
+      OutOfMemoryError("ComputeGraphStats:numOutgoing");
+   for (v = 0; v < graph->numVertices; v++)
+      VertexRowStats(graph, v, numOutgoing, numUndirected,
+                     & stats->uniqueEdges[v], & stats->maxEdges[v]);
+   free(numOutgoing);
+   free(numUndirected);
+   return stats;
+}
+
+
+//******************************************************************************
+// NAME: FreeGraphStats
+//
+// INPUTS: (GraphStats *stats)
+//
+// RETURN: (void)
+//
+// PURPOSE: Free memory used by graph statistics.
+//******************************************************************************
+
+void FreeGraphStats(GraphStats *stats)
+{
+   if (stats != NULL)
    {
-      edge = & graph->edges[graph->vertices[v1].edges[e]];
-      graph->vertices[edge->vertex1].used = FALSE;
-      graph->vertices[edge->vertex2].used = FALSE;
+      free(stats->uniqueEdges);
+      free(stats->maxEdges);
+      free(stats);
    }
-   return numUniqueEdges;
 }
 
 
 //******************************************************************************
-// NAME: MaxEdgesToSingleVertex
+// NAME: CompareRowEdges
 //
-// INPUTS: (Graph *graph) - graph containing vertex
-//         (ULONG v1) - vertex to look for maximum edges
+// INPUTS: (const void *p1)
+//         (const void *p2) - RowEdges to compare
+//
+// RETURN: (int) - negative, zero or positive as p1 is before, same as or
+//                 after p2
+//
+// PURPOSE: qsort comparison ordering row edges by neighbor, and then by
+// position in the vertex's edge list.
+//******************************************************************************
+
+static int CompareRowEdges(const void *p1, const void *p2)
+{
+   const RowEdge *rowEdge1 = (const RowEdge *) p1;
+   const RowEdge *rowEdge2 = (const RowEdge *) p2;
+
+   if (rowEdge1->neighbor != rowEdge2->neighbor)
+      return (rowEdge1->neighbor < rowEdge2->neighbor) ? -1 : 1;
+   if (rowEdge1->position != rowEdge2->position)
+      return (rowEdge1->position < rowEdge2->position) ? -1 : 1;
+   return 0;
+}
+
+
+//******************************************************************************
+// NAME: RowStats
+//
+// INPUTS: (RowEdge *rowEdges) - edges of vertex (array is reordered)
+//         (ULONG numRowEdges) - number of edges of vertex
+//         (ULONG self) - the vertex itself (in the same ordering as the
+//                        neighbors of rowEdges)
+//         (ULONG *uniqueEdges) - returns number of unique edges of vertex
+//         (ULONG *maxEdges) - returns maximum edges from vertex to one vertex
 //
-// RETURN: (ULONG) - maximum number of edges from v1 to another vertex
+// RETURN: (void)
 //
-// PURPOSE: Computes the maximum number of edges between v1 and
-// another vertex (including v1 itself).
+// PURPOSE: Compute the same values as VertexRowStats for a vertex, given
+// only its edges, by sorting them by neighbor.  This is used when the
+// neighbors are not vertices of an existing graph.
 //******************************************************************************
 
-ULONG MaxEdgesToSingleVertex(Graph *graph, ULONG v1)
+void RowStats(RowEdge *rowEdges, ULONG numRowEdges, ULONG self,
+              ULONG *uniqueEdges, ULONG *maxEdges)
 {
-   ULONG maxEdges;
-   ULONG numEdges;
    ULONG i, j;
-   ULONG v2, v2j;
-   Edge *edge1, *edge2;
-   ULONG numEdgesToVertex2;
+   ULONG neighbor;
+   ULONG numOutgoing;
+   ULONG firstUndirected;
+   ULONG numEdgesToNeighbor;
+   BOOLEAN counted;
+
+   *uniqueEdges = 0;
+   *maxEdges = 0;
+   if (numRowEdges > 1)
+      qsort(rowEdges, numRowEdges, sizeof(RowEdge), CompareRowEdges);
+   i = 0;
+   while (i < numRowEdges)
+   {
+      neighbor = rowEdges[i].neighbor;
+      numOutgoing = 0;
+      firstUndirected = MAX_UNSIGNED_LONG;
+      j = i;
+      while ((j < numRowEdges) && (rowEdges[j].neighbor == neighbor))
+      {
+         if (rowEdges[j].outgoing)
+            numOutgoing++;
+         else if ((! rowEdges[j].directed) && (neighbor >= self) &&
+                  (firstUndirected == MAX_UNSIGNED_LONG))
+            firstUndirected = j;
+         j++;
+      }
+      counted = FALSE;
+      if (numOutgoing > 0)
+      {
+         counted = TRUE;
+         if (numOutgoing > *maxEdges)
+            *maxEdges = numOutgoing;
+      }
+      if (firstUndirected != MAX_UNSIGNED_LONG)
+      {
+         counted = TRUE;
+         numEdgesToNeighbor = j - firstUndirected;
+         if (numEdgesToNeighbor > *maxEdges)
+            *maxEdges = numEdgesToNeighbor;
+      }
+      if (counted)
+         (*uniqueEdges)++;
+      i = j;
+   }
+}
 
-   maxEdges = 0;
-   numEdges = graph->vertices[v1].numEdges;
-   for (i = 0; i < numEdges; i++) 
+
+//******************************************************************************
+// NAME: CompressedGraphMDL
+//
+// INPUTS: (Graph *graph) - graph to be compressed
+//         (GraphStats *stats) - statistics of graph (see ComputeGraphStats)
+//         (Substructure *sub) - substructure whose instances compress graph
+//         (ULONG numLabels) - number of labels, including "SUB" label
+//         (Parameters *parameters) - parameters->workspace used for
+//                                        marking instances
+//
+// RETURN: (double) - description length of compressed graph in bits,
+//                    including external edge bits
+//
+// PURPOSE: Return the same value as MDL plus ExternalEdgeBits of the graph
+// returned by CompressGraph, for the case where instance overlap is not
+// allowed, but without building the compressed graph.  Compression only
+// changes the adjacency matrix rows of the instance vertices (replaced by
+// one "SUB" vertex row per instance) and of the vertices with external
+// edges to them, so only those rows are recomputed; all other rows are
+// taken from the cached statistics.  The rows are summed in the same order
+// as MDL would sum them for the compressed graph, so the result is
+// identical.
+//******************************************************************************
+
+double CompressedGraphMDL(Graph *graph, GraphStats *stats, Substructure *sub,
+                          ULONG numLabels, Parameters *parameters)
+{
+   InstanceListNode *instanceListNode;
+   Instance *instance;
+   Vertex *vertex;
+   Edge *edge;
+   ULONG instanceNo;
+   ULONG numInstances;
+   ULONG numInstanceVertices;
+   ULONG numInstanceEdges;
+   ULONG v, e, i;
+   ULONG w;
+   ULONG V, E, L;
+   ULONG ki, mi;
+   ULONG B, K, M;
+   ULONG key1, key2;
+   ULONG *affected = NULL;
+   ULONG numAffected = 0;
+   ULONG affectedSize = 0;
+   ULONG *rowUniqueEdges;
+   ULONG *rowEdgeIndices = NULL;
+   ULONG numRowEdgeIndices;
+   ULONG rowSize = 0;
+   RowEdge *rowEdges = NULL;
+   ULONG rowEdgesSize = 0;
+   double vertexBits;
+   double rowBits;
+   double edgeBits;
+   double externalEdgeBits;
+   double log2SubVertices;
+   Workspace *workspace = parameters->workspace;
+   ULONG *vertexMap;
+
+   // mark instance vertices and edges in the workspace, assigning each
+   // vertex to the first instance it occurs in, as done by CompressGraph
+   NewWorkspaceEpoch(workspace, graph);
+   vertexMap = workspace->vertexMap;
+   numInstanceVertices = 0;
+   numInstanceEdges = 0;
+   instanceNo = 1;
+   instanceListNode = sub->instances->head;
+   while (instanceListNode != NULL)
    {
-      edge1 = & graph->edges[graph->vertices[v1].edges[i]];
-      // get other vertex
-      if (edge1->vertex1 == v1)
-         v2 = edge1->vertex2;
-      else 
-         v2 = edge1->vertex1;
-      if (((edge1->directed) && (edge1->vertex1 == v1)) || // outgoing edge
-          ((! edge1->directed) && (v2 >= v1))) 
+      instance = instanceListNode->instance;
+      for (v = 0; v < instance->numVertices; v++)
+         if (! VERTEX_MARKED(workspace, instance->vertices[v]))
+         {
+            numInstanceVertices++;
+            MARK_VERTEX(workspace, instance->vertices[v]);
+            vertexMap[instance->vertices[v]] = instanceNo - 1;
+         }
+      for (e = 0; e < instance->numEdges; e++)
+         if (! EDGE_MARKED(workspace, instance->edges[e]))
+         {
+            numInstanceEdges++;
+            MARK_EDGE(workspace, instance->edges[e]);
+         }
+      instanceNo++;
+      instanceListNode = instanceListNode->next;
+   }
+   numInstances = instanceNo - 1;
+
+   V = graph->numVertices - numInstanceVertices + numInstances;
+   E = graph->numEdges - numInstanceEdges;
+   L = numLabels;
+
+   // collect vertices with an external edge to an instance vertex
+   instanceListNode = sub->instances->head;
+   while (instanceListNode != NULL)
+   {
+      instance = instanceListNode->instance;
+      for (v = 0; v < instance->numVertices; v++)
       {
-         // count how many edges to v2
-         numEdgesToVertex2 = 1;
-         for (j = i + 1; j < numEdges; j++) 
-         { //start at i+1 since only want max
-            edge2 = & graph->edges[graph->vertices[v1].edges[j]];
-            if (edge2->vertex1 == v1)
-               v2j = edge2->vertex2;
-            else 
-               v2j = edge2->vertex1;
-            if (v2j == v2) 
+         vertex = & graph->vertices[instance->vertices[v]];
+         for (e = 0; e < vertex->numEdges; e++)
+         {
+            if (EDGE_MARKED(workspace, vertex->edges[e]))
+               continue;
+            edge = & graph->edges[vertex->edges[e]];
+            w = (edge->vertex1 == instance->vertices[v]) ?
+                edge->vertex2 : edge->vertex1;
+            if (VERTEX_MARKED(workspace, w))
+               continue;
+            if (numAffected == affectedSize)
             {
-               // outgoing edge
-               if (((edge2->directed) && (edge2->vertex1 == v1)) ||
-                   ((! edge1->directed) && (v2j >= v1))) 
+               affectedSize += LIST_SIZE_INC;
+               affected = (ULONG *)
+                  realloc(affected, sizeof(ULONG) * affectedSize);
+               if (affected == NULL)
+                  OutOfMemoryError("CompressedGraphMDL:affected");
+            }
+            affected[numAffected++] = w;
+         }
+      }
+      instanceListNode = instanceListNode->next;
+   }
+   numAffected = SortUnique(affected, numAffected);
+
+   // compute the rows of the "SUB" vertices, followed by the rows of the
+   // affected vertices; in the compressed graph, the "SUB" vertices come
+   // first in instance order, followed by the remaining vertices in their
+   // original order, and a vertex's edges are kept in their original order
+   rowUniqueEdges =
+      (ULONG *) malloc(sizeof(ULONG) * (numInstances + numAffected + 1));
+   if (rowUniqueEdges == NULL)
+      OutOfMemoryError("CompressedGraphMDL:rowUniqueEdges");
+   M = 0;
+   externalEdgeBits = 0.0;
+   log2SubVertices = Log2(sub->definition->numVertices);
+   instanceListNode = sub->instances->head;
+   for (i = 0; i < numInstances + numAffected; i++)
+   {
+      numRowEdgeIndices = 0;
+      if (i < numInstances)
+      {
+         // row of "SUB" vertex: external edges of all its vertices
+         instance = instanceListNode->instance;
+         for (v = 0; v < instance->numVertices; v++)
+         {
+            if (vertexMap[instance->vertices[v]] != i)
+               continue; // vertex belongs to an earlier instance
+            vertex = & graph->vertices[instance->vertices[v]];
+            for (e = 0; e < vertex->numEdges; e++)
+               if (! EDGE_MARKED(workspace, vertex->edges[e]))
                {
-                  numEdgesToVertex2++;
+                  if (numRowEdgeIndices == rowSize)
+                  {
+                     rowSize += LIST_SIZE_INC;
+                     rowEdgeIndices = (ULONG *)
+                        realloc(rowEdgeIndices, sizeof(ULONG) * rowSize);
+                     if (rowEdgeIndices == NULL)
+                        OutOfMemoryError("CompressedGraphMDL:rowEdgeIndices");
+                  }
+                  rowEdgeIndices[numRowEdgeIndices++] = vertex->edges[e];
                }
-            }
          }
-         if (numEdgesToVertex2 > maxEdges)
-            maxEdges = numEdgesToVertex2;
+         w = i;
+         instanceListNode = instanceListNode->next;
+      }
+      else
+      {
+         // row of vertex with external edges to instances
+         vertex = & graph->vertices[affected[i - numInstances]];
+         if (vertex->numEdges > rowSize)
+         {
+            rowSize = vertex->numEdges;
+            rowEdgeIndices = (ULONG *)
+               realloc(rowEdgeIndices, sizeof(ULONG) * rowSize);
+            if (rowEdgeIndices == NULL)
+               OutOfMemoryError("CompressedGraphMDL:rowEdgeIndices");
+         }
+         for (e = 0; e < vertex->numEdges; e++)
+            if (! EDGE_MARKED(workspace, vertex->edges[e]))
+               rowEdgeIndices[numRowEdgeIndices++] = vertex->edges[e];
+         w = numInstances + affected[i - numInstances];
       }
+      numRowEdgeIndices = SortUnique(rowEdgeIndices, numRowEdgeIndices);
+
+      if (numRowEdgeIndices > rowEdgesSize)
+      {
+         rowEdgesSize = numRowEdgeIndices;
+         rowEdges = (RowEdge *)
+            realloc(rowEdges, sizeof(RowEdge) * rowEdgesSize);
+         if (rowEdges == NULL)
+            OutOfMemoryError("CompressedGraphMDL:rowEdges");
+      }
+      for (e = 0; e < numRowEdgeIndices; e++)
+      {
+         edge = & graph->edges[rowEdgeIndices[e]];
+         // order of edge's vertices in compressed graph
+         if (VERTEX_MARKED(workspace, edge->vertex1))
+            key1 = vertexMap[edge->vertex1];
+         else
+            key1 = numInstances + edge->vertex1;
+         if (VERTEX_MARKED(workspace, edge->vertex2))
+            key2 = vertexMap[edge->vertex2];
+         else
+            key2 = numInstances + edge->vertex2;
+         rowEdges[e].neighbor = (key1 == w) ? key2 : key1;
+         rowEdges[e].position = e;
+         rowEdges[e].directed = edge->directed;
+         rowEdges[e].outgoing = (edge->directed && (key1 == w));
+         // add bits for each edge connected to "SUB" vertex
+         if ((i < numInstances) && (w < sub->numInstances))
+         {
+            externalEdgeBits += log2SubVertices;
+            if (key1 == key2) // self-edge
+               externalEdgeBits += log2SubVertices;
+         }
+      }
+      RowStats(rowEdges, numRowEdgeIndices, w, & ki, & mi);
+      rowUniqueEdges[i] = ki;
+      if (mi > M)
+         M = mi;
    }
-   return maxEdges;
+
+   // sum up all rows as MDL does, taking unaffected rows from stats
+   vertexBits = Log2(V) + (V * Log2(L));
+   rowBits = V * Log2Factorial(V, parameters);
+   edgeBits = E * (1 + Log2(L));
+   B = 0;
+   K = 0;
+   for (i = 0; i < numInstances; i++)
+   {
+      ki = rowUniqueEdges[i];
+      rowBits -= (Log2Factorial(ki, parameters) +
+                  Log2Factorial((V - ki), parameters));
+      if (ki > B)
+         B = ki;
+      K += ki;
+   }
+   i = 0;
+   for (v = 0; v < graph->numVertices; v++)
+   {
+      if (VERTEX_MARKED(workspace, v))
+         continue;
+      if ((i < numAffected) && (affected[i] == v))
+      {
+         ki = rowUniqueEdges[numInstances + i];
+         i++;
+      }
+      else
+      {
+         ki = stats->uniqueEdges[v];
+         if (stats->maxEdges[v] > M)
+            M = stats->maxEdges[v];
+      }
+      rowBits -= (Log2Factorial(ki, parameters) +
+                  Log2Factorial((V - ki), parameters));
+      if (ki > B)
+         B = ki;
+      K += ki;
+   }
+   rowBits += ((V + 1) * Log2(B + 1));
+   edgeBits += ((K + 1) * Log2(M));
+
+   free(affected);
+   free(rowUniqueEdges);
+   free(rowEdgeIndices);
+   free(rowEdges);
+
+   return (vertexBits + rowBits + edgeBits) + externalEdgeBits;
 }
 
 
@@ -444,9 +919,10 @@ ULONG PosExamplesCovered(Substructure *sub, Parameters *parameters)
    ULONG start = 0;
 
    return ExamplesCovered(sub->instances,
-                          parameters->posGraph,
                           parameters->numPosEgs,
-                          parameters->posEgsVertexIndices, start);
+                          parameters->posEgsVertexIndices,
+                          parameters->posVertexExamples, start,
+                          parameters->workspace);
 }
 
 
@@ -454,62 +930,77 @@ ULONG PosExamplesCovered(Substructure *sub, Parameters *parameters)
 // NAME: ExamplesCovered
 //
 // INPUTS: (InstanceList *instanceList) - instances of substructure
-//         (Graph *graph) - graph containing instances and examples
 //         (ULONG numEgs) - number of examples to consider
 //         (ULONG *egsVertexIndices) - vertex indices of each examples
 //           starting vertex
+//         (ULONG *vertexExamples) - example number of each graph vertex
 //         (ULONG start) - start vertex for current increment
+//         (Workspace *workspace) - holds set of examples already counted
 //
 // RETURN: (ULONG) - number of examples covered by instances
 //
 // PURPOSE: Return the number of examples, whose starting vertices are
 // stored in egsVertexIndices, are covered by an instance in
 // instanceList.  Note that one example may contain more than one
-// instance.
+// instance, so covered examples are collected in the workspace's
+// example set, which is cleared again before returning.
 //******************************************************************************
 
-ULONG ExamplesCovered(InstanceList *instanceList, Graph *graph,
-                      ULONG numEgs, ULONG *egsVertexIndices, ULONG start)
+ULONG ExamplesCovered(InstanceList *instanceList, ULONG numEgs,
+                      ULONG *egsVertexIndices, ULONG *vertexExamples,
+                      ULONG start, Workspace *workspace)
 {
    ULONG i;
-   ULONG egStartVertexIndex;
-   ULONG egEndVertexIndex;
+   ULONG eg;
+   ULONG word;
+   ULONG bit;
    ULONG instanceVertexIndex;
    InstanceListNode *instanceListNode;
-   BOOLEAN found;
    ULONG numEgsCovered;
 
    numEgsCovered = 0;
-   if (instanceList != NULL) 
+   if ((instanceList != NULL) && (numEgs > 0))
    {
-      // for each example, look for a covering instance
-      for (i = 0; i < numEgs; i++)
+      if (numEgs > workspace->exampleSetSize * ULONG_BITS)
       {
-         // find example's starting and ending vertex indices
-         egStartVertexIndex = egsVertexIndices[i];
-         if (egStartVertexIndex >= start)
+         word = (numEgs + ULONG_BITS - 1) / ULONG_BITS;
+         workspace->exampleSet = (ULONG *)
+            realloc(workspace->exampleSet, sizeof(ULONG) * word);
+         if (workspace->exampleSet == NULL)
+            OutOfMemoryError("ExamplesCovered:exampleSet");
+         for (i = workspace->exampleSetSize; i < word; i++)
+            workspace->exampleSet[i] = 0;
+         workspace->exampleSetSize = word;
+      }
+
+      // count the example of each instance, unless counted already
+      instanceListNode = instanceList->head;
+      while (instanceListNode != NULL)
+      {
+         // can check any instance vertex, so use the first
+         instanceVertexIndex = instanceListNode->instance->vertices[0];
+         eg = vertexExamples[instanceVertexIndex] - 1;
+         if ((egsVertexIndices[eg] >= start) &&
+             (instanceVertexIndex >= egsVertexIndices[eg]))
          {
-            if (i < (numEgs - 1))
-               egEndVertexIndex = egsVertexIndices[i + 1] - 1;
-            else
-               egEndVertexIndex = graph->numVertices - 1;
-            // look for an instance whose vertices are in range
-            instanceListNode = instanceList->head;
-            found = FALSE;
-            while ((instanceListNode != NULL) && (! found))
+            word = eg / ULONG_BITS;
+            bit = ((ULONG) 1) << (eg % ULONG_BITS);
+            if (! (workspace->exampleSet[word] & bit))
             {
-               // can check any instance vertex, so use the first
-               instanceVertexIndex = instanceListNode->instance->vertices[0];
-               if ((instanceVertexIndex >= egStartVertexIndex) &&
-                   (instanceVertexIndex <= egEndVertexIndex))
-               {
-                  // found an instance covering this example
-                  numEgsCovered++;
-                  found = TRUE;
-               }
-               instanceListNode = instanceListNode->next;
+               workspace->exampleSet[word] |= bit;
+               numEgsCovered++;
             }
          }
+         instanceListNode = instanceListNode->next;
+      }
+
+      // clear example set
+      instanceListNode = instanceList->head;
+      while (instanceListNode != NULL)
+      {
+         eg = vertexExamples[instanceListNode->instance->vertices[0]] - 1;
+         workspace->exampleSet[eg / ULONG_BITS] = 0;
+         instanceListNode = instanceListNode->next;
       }
    }
    return numEgsCovered;
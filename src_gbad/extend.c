@@ -37,6 +37,7 @@ SubList *ExtendSub(Substructure *sub, Parameters *parameters)
    SubList *extendedSubs;
    SubListNode *newSubListNode = NULL;
    ULONG newInstanceListIndex = 0;
+   double scale;
 
    // parameters used
    Graph *posGraph = parameters->posGraph;
@@ -45,34 +46,337 @@ SubList *ExtendSub(Substructure *sub, Parameters *parameters)
    extendedSubs = AllocateSubList();
    newInstanceList = ExtendInstances(sub->instances, posGraph, FALSE,
                                      parameters);
-   newInstanceListNode = newInstanceList->head;
-   while (newInstanceListNode != NULL) 
+   //
+   // GBAD-P: After the first iteration, only single-vertex substructures
+   // are extended, by a single edge.  If matches must be exact, the
+   // extended instances matching each other are then simply those of the
+   // same type, so group them by type instead of matching them.
+   //
+   if ((parameters->prob) && (parameters->currentIteration > 1) &&
+       (parameters->threshold == 0.0) &&
+       (sub->definition->numVertices == 1) &&
+       (sub->definition->numEdges == 0))
+      GroupExtensionsByType(newInstanceList, extendedSubs, parameters);
+   else
    {
-      newInstance = newInstanceListNode->instance;
-      if (newInstance->minMatchCost != 0.0) 
+      newInstanceListNode = newInstanceList->head;
+      while (newInstanceListNode != NULL) 
       {
-         // minMatchCost=0.0 means the instance is an exact match to a
-         // previously-generated sub, so a sub created from this instance
-         // would be a duplicate of one already on the extendedSubs list
-         newSub = CreateSubFromInstance(newInstance, posGraph);
-         if (! MemberOfSubList(newSub, extendedSubs, labelList)) 
+         newInstance = newInstanceListNode->instance;
+         if (newInstance->minMatchCost != 0.0) 
          {
-            AddPosInstancesToSub(newSub, newInstance, newInstanceList, 
-                                  parameters,newInstanceListIndex);
-            // add newSub to head of extendedSubs list
-            newSubListNode = AllocateSubListNode(newSub);
-            newSubListNode->next = extendedSubs->head;
-            extendedSubs->head = newSubListNode;
-         } else FreeSub(newSub);
+            // minMatchCost=0.0 means the instance is an exact match to a
+            // previously-generated sub, so a sub created from this instance
+            // would be a duplicate of one already on the extendedSubs list
+            newSub = CreateSubFromInstance(newInstance, posGraph);
+            if (! MemberOfSubList(newSub, extendedSubs, labelList)) 
+            {
+               AddPosInstancesToSub(newSub, newInstance, newInstanceList, 
+                                     parameters,newInstanceListIndex);
+               // add newSub to head of extendedSubs list
+               newSubListNode = AllocateSubListNode(newSub);
+               newSubListNode->next = extendedSubs->head;
+               extendedSubs->head = newSubListNode;
+            } else FreeSub(newSub);
+         }
+         newInstanceListNode = newInstanceListNode->next;
+         newInstanceListIndex++;
       }
-      newInstanceListNode = newInstanceListNode->next;
-      newInstanceListIndex++;
    }
    FreeInstanceList(newInstanceList);
+   //
+   // Each extended instance stands for as many instances in the positive
+   // graph as the instances of sub do, or more if, with -maxmem, those are
+   // a sample of them (see SampleSubInstances).
+   //
+   scale = sub->instanceScale;
+   if ((parameters->maxMemory > 0) &&
+       (sub->instances->numNodes < sub->numInstances))
+      scale = scale * (double) sub->numInstances /
+              (double) sub->instances->numNodes;
+   newSubListNode = extendedSubs->head;
+   while (newSubListNode != NULL)
+   {
+      newSubListNode->sub->instanceScale = scale;
+      newSubListNode = newSubListNode->next;
+   }
    return extendedSubs;
 }
 
 
+//******************************************************************************
+// NAME: GroupExtensionsByType (GBAD-P)
+//
+// INPUTS: (InstanceList *instanceList) - single-edge extensions of the
+//                                        instances of a single-vertex
+//                                        substructure
+//         (SubList *extendedSubs) - list to add extended substructures to
+//         (Parameters *parameters)
+//
+// RETURN: (void)
+//
+// PURPOSE: Collect the extended instances into one new substructure per
+// extension type (edge label, directedness and the labels at either end
+// of the edge), using a hash table of the types found so far.  With exact
+// matching, this gives the same substructures, with the same instances in
+// the same order, as matching each extended instance against the new
+// substructures in ExtendSub, but in time linear in the number of
+// extended instances.
+//******************************************************************************
+
+void GroupExtensionsByType(InstanceList *instanceList, SubList *extendedSubs,
+                           Parameters *parameters)
+{
+   InstanceListNode *instanceListNode;
+   Instance *instance;
+   SubListNode *subListNode;
+   ExtensionType *types;
+   ExtensionType **buckets;
+   ExtensionType *type;
+   Edge *edge;
+   ULONG numTypes;
+   ULONG numBuckets;
+   ULONG label1;
+   ULONG label2;
+   ULONG hash;
+   ULONG t;
+
+   // parameters used
+   Graph *posGraph = parameters->posGraph;
+
+   // there are at most as many types as extended instances
+   numBuckets = 1;
+   while (numBuckets < instanceList->numNodes)
+      numBuckets *= 2;
+   types = (ExtensionType *) malloc(sizeof(ExtensionType) *
+                                    (instanceList->numNodes + 1));
+   buckets = (ExtensionType **) malloc(sizeof(ExtensionType *) * numBuckets);
+   if ((types == NULL) || (buckets == NULL))
+      OutOfMemoryError("GroupExtensionsByType:types");
+   for (t = 0; t < numBuckets; t++)
+      buckets[t] = NULL;
+
+   numTypes = 0;
+   instanceListNode = instanceList->head;
+   while (instanceListNode != NULL)
+   {
+      instance = instanceListNode->instance;
+      edge = & posGraph->edges[instance->edges[0]];
+      label1 = posGraph->vertices[edge->vertex1].label;
+      label2 = posGraph->vertices[edge->vertex2].label;
+      if ((! edge->directed) && (label1 > label2))
+      {
+         label1 = label2;
+         label2 = posGraph->vertices[edge->vertex1].label;
+      }
+      hash = MixHash((edge->label * 4) + (edge->directed * 2) +
+                     (edge->vertex1 == edge->vertex2));
+      hash = MixHash(hash + label1);
+      hash = MixHash(hash + label2);
+
+      // find type of extension, adding it if new
+      type = buckets[hash & (numBuckets - 1)];
+      while ((type != NULL) &&
+             ((type->edgeLabel != edge->label) ||
+              (type->directed != edge->directed) ||
+              (type->selfEdge != (edge->vertex1 == edge->vertex2)) ||
+              (type->label1 != label1) || (type->label2 != label2)))
+         type = type->nextInBucket;
+      if (type == NULL)
+      {
+         type = & types[numTypes];
+         numTypes++;
+         type->label1 = label1;
+         type->label2 = label2;
+         type->edgeLabel = edge->label;
+         type->directed = edge->directed;
+         type->selfEdge = (edge->vertex1 == edge->vertex2);
+         type->sub = CreateSubFromInstance(instance, posGraph);
+         type->sub->instances = AllocateInstanceList();
+         type->nextInBucket = buckets[hash & (numBuckets - 1)];
+         buckets[hash & (numBuckets - 1)] = type;
+      }
+      instance->minMatchCost = 0.0;
+      InstanceListInsert(instance, type->sub->instances, FALSE);
+      type->sub->numInstances++;
+      instanceListNode = instanceListNode->next;
+   }
+
+   // like ExtendSub, add each new substructure to the head of the list
+   for (t = 0; t < numTypes; t++)
+   {
+      subListNode = AllocateSubListNode(types[t].sub);
+      subListNode->next = extendedSubs->head;
+      extendedSubs->head = subListNode;
+   }
+   free(buckets);
+   free(types);
+}
+
+
+//******************************************************************************
+// NAME: ExtensionBytes
+//
+// INPUTS: (InstanceList *instanceList) - instances to be extended
+//         (Graph *graph) - graph containing instances
+//
+// RETURN: (double) - estimated bytes taken by the extended instances
+//
+// PURPOSE: Estimate the memory ExtendInstances would take to extend the
+// instances, counting one extended instance per edge at each instance
+// vertex; used by memory-bounded discovery (-maxmem).
+//******************************************************************************
+
+double ExtensionBytes(InstanceList *instanceList, Graph *graph)
+{
+   InstanceListNode *instanceListNode;
+   Instance *instance;
+   double bytes = 0.0;
+   ULONG degree;
+   ULONG v;
+
+   instanceListNode = instanceList->head;
+   while (instanceListNode != NULL)
+   {
+      instance = instanceListNode->instance;
+      degree = 0;
+      for (v = 0; v < instance->numVertices; v++)
+         degree += graph->vertices[instance->vertices[v]].numEdges;
+      bytes += (double) degree *
+               InstanceBytes(instance->numVertices + 1, instance->numEdges + 1);
+      instanceListNode = instanceListNode->next;
+   }
+   return bytes;
+}
+
+
+//******************************************************************************
+// NAME: SampleSize
+//
+// INPUTS: (ULONG numInstances) - number of instances of a substructure
+//         (Parameters *parameters)
+//
+// RETURN: (ULONG) - number of those instances extended at this beam level
+//
+// PURPOSE: The size of the sample SampleSubInstances takes of a
+// substructure's instances: parameters->sampleFraction of them, but at
+// least MIN_SAMPLE_INSTANCES, and at most all of them.
+//******************************************************************************
+
+ULONG SampleSize(ULONG numInstances, Parameters *parameters)
+{
+   ULONG numSampled;
+
+   numSampled = (ULONG) ceil(numInstances * parameters->sampleFraction);
+   if (numSampled < MIN_SAMPLE_INSTANCES)
+      numSampled = MIN_SAMPLE_INSTANCES;
+   if (numSampled > numInstances)
+      numSampled = numInstances;
+   return numSampled;
+}
+
+
+//******************************************************************************
+// NAME: SampleSubInstances
+//
+// INPUTS: (Substructure *sub) - substructure about to be extended
+//         (Parameters *parameters)
+//
+// RETURN: (InstanceList *) - all instances of sub if they were replaced by
+//                            a sample, else NULL
+//
+// PURPOSE: Memory-bounded discovery (-maxmem).  If only a fraction of the
+// instances can be extended at this beam level (parameters->sampleFraction),
+// replace sub's instances by a reservoir sample of SampleSize of them,
+// keeping their order, until
+// RestoreSubInstances is called with the list returned.  The sample is
+// drawn with a fixed hash sequence, so is the same on every run.  Must not
+// be called by a worker thread, since the sampled instances may be shared
+// with other substructures.
+//******************************************************************************
+
+InstanceList *SampleSubInstances(Substructure *sub, Parameters *parameters)
+{
+   InstanceList *allInstances;
+   InstanceList *sampleInstances;
+   InstanceListNode *instanceListNode;
+   InstanceListNode *sampleListNode;
+   InstanceListNode *lastListNode;
+   BOOLEAN *sampled;
+   ULONG *reservoir;
+   ULONG numInstances;
+   ULONG numSampled;
+   ULONG i;
+   ULONG j;
+
+   allInstances = sub->instances;
+   numInstances = allInstances->numNodes;
+   numSampled = SampleSize(numInstances, parameters);
+   if (numSampled == numInstances)
+      return NULL;
+
+   // reservoir sample of instance indices
+   reservoir = (ULONG *) malloc(sizeof(ULONG) * numSampled);
+   sampled = (BOOLEAN *) malloc(sizeof(BOOLEAN) * numInstances);
+   if ((reservoir == NULL) || (sampled == NULL))
+      OutOfMemoryError("SampleSubInstances:reservoir");
+   for (i = 0; i < numSampled; i++)
+      reservoir[i] = i;
+   for (i = numSampled; i < numInstances; i++)
+   {
+      j = MixHash(i) % (i + 1);
+      if (j < numSampled)
+         reservoir[j] = i;
+   }
+   for (i = 0; i < numInstances; i++)
+      sampled[i] = FALSE;
+   for (i = 0; i < numSampled; i++)
+      sampled[reservoir[i]] = TRUE;
+
+   // copy sampled instances, in order, to new list
+   sampleInstances = AllocateInstanceList();
+   lastListNode = NULL;
+   instanceListNode = allInstances->head;
+   for (i = 0; i < numInstances; i++)
+   {
+      if (sampled[i])
+      {
+         sampleListNode = AllocateInstanceListNode(instanceListNode->instance);
+         if (lastListNode == NULL)
+            sampleInstances->head = sampleListNode;
+         else
+            lastListNode->next = sampleListNode;
+         lastListNode = sampleListNode;
+         sampleInstances->numNodes++;
+      }
+      instanceListNode = instanceListNode->next;
+   }
+   free(reservoir);
+   free(sampled);
+
+   sub->instances = sampleInstances;
+   return allInstances;
+}
+
+
+//******************************************************************************
+// NAME: RestoreSubInstances
+//
+// INPUTS: (Substructure *sub) - substructure holding a sample of instances
+//         (InstanceList *allInstances) - list returned by SampleSubInstances
+//
+// RETURN: (void)
+//
+// PURPOSE: Free the sample of sub's instances and give it back all of them.
+//******************************************************************************
+
+void RestoreSubInstances(Substructure *sub, InstanceList *allInstances)
+{
+   FreeInstanceList(sub->instances);
+   sub->instances = allInstances;
+}
+
+
 //******************************************************************************
 // NAME: ExtendInstances
 //
@@ -83,7 +387,8 @@ SubList *ExtendSub(Substructure *sub, Parameters *parameters)
 //
 // PURPOSE: Create and return a list of new instances by extending the
 // given substructure's instances by one edge (or edge and new vertex)
-// in all possible ways based on given graph.
+// in all possible ways based on given graph.  An extension is only
+// created if it is not already on the new list.
 //******************************************************************************
 
 InstanceList *ExtendInstances(InstanceList *instanceList, Graph *graph,
@@ -92,52 +397,37 @@ InstanceList *ExtendInstances(InstanceList *instanceList, Graph *graph,
    InstanceList *newInstanceList;
    InstanceListNode *instanceListNode;
    Instance *instance;
-   Instance *newInstance;
    ULONG v;
    ULONG e;
+   ULONG hash;
    Vertex *vertex;
-   Edge *edge;
 
    char subLabelString[TOKEN_LEN];
    sprintf(subLabelString, "%s_%lu", SUB_LABEL_STRING, (parameters->currentIteration-1));
 
    newInstanceList = AllocateInstanceList();
+   IndexInstanceList(newInstanceList, INSTANCE_HASH_SIZE);
    instanceListNode = instanceList->head;
    while (instanceListNode != NULL) 
    {
       instance = instanceListNode->instance;
-      MarkInstanceEdges(instance, graph, TRUE);
+      hash = InstanceHash(instance);
+      // the graph is not marked, so that several threads can extend
+      // instances in it at once
       for (v = 0; v < instance->numVertices; v++) 
       {
          vertex = & graph->vertices[instance->vertices[v]];
          for (e = 0; e < vertex->numEdges; e++) 
          {
-            edge = & graph->edges[vertex->edges[e]];
-            if (! edge->used) 
+            if (! InstanceContainsEdge(instance, vertex->edges[e])) 
             {
                // add new instance to list
-               //
-               // GBAD-P: Set anomalous edges if we are flagging this instance
-               //         as an anomaly.
-               //
-               if (flagAnomaly) {
-                  newInstance =
-                     CreateExtendedInstance(instance, instance->vertices[v],
-                                            vertex->edges[e], graph, TRUE);
-                  newInstance->anomalousEdges[instance->numAnomalousEdges] =
-                     vertex->edges[e];
-                  newInstance->numAnomalousEdges++;
-               }
-               else {
-                  newInstance =
-                     CreateExtendedInstance(instance, instance->vertices[v],
-                                            vertex->edges[e], graph, FALSE);
-               }
-               InstanceListInsert(newInstance, newInstanceList, TRUE);
+               InsertExtendedInstance(instance, hash, instance->vertices[v],
+                                      vertex->edges[e], graph,
+                                      newInstanceList, flagAnomaly);
             }
          }
       }
-      MarkInstanceEdges(instance, graph, FALSE);
       instanceListNode = instanceListNode->next;
    }
    return newInstanceList;
@@ -158,7 +448,8 @@ InstanceList *ExtendInstances(InstanceList *instanceList, Graph *graph,
 // given instance extended by one edge e along vertex v.  Edge e may
 // introduce a new vertex.  Make sure that instance's vertices and
 // edges arrays are kept in increasing order, which is important for
-// fast instance matching.
+// fast instance matching.  If flagAnomaly = TRUE (GBAD-P), the new
+// vertex and edge are also recorded as anomalous.
 //******************************************************************************
 
 Instance *CreateExtendedInstance(Instance *instance, ULONG v, ULONG e,
@@ -176,9 +467,9 @@ Instance *CreateExtendedInstance(Instance *instance, ULONG v, ULONG e,
       v2 = graph->edges[e].vertex1;
 
    // check if edge's other vertex is already in instance
-   for (i = 0; ((i < instance->numVertices) && (! found)); i++)
-      if (instance->vertices[i] == v2)
-         found = TRUE;
+   if (FindULONG(instance->vertices, instance->numVertices, v2) <
+       instance->numVertices)
+      found = TRUE;
 
    // allocate memory for new instance
    if (! found)
@@ -198,6 +489,8 @@ Instance *CreateExtendedInstance(Instance *instance, ULONG v, ULONG e,
       }
       newInstance->anomalousVertices[instance->numAnomalousVertices] = v2;
       newInstance->numAnomalousVertices = instance->numAnomalousVertices+1;
+      newInstance->anomalousEdges[instance->numAnomalousEdges] = e;
+      newInstance->numAnomalousEdges++;
    }
    //
 
@@ -265,6 +558,50 @@ Instance *CreateExtendedInstance(Instance *instance, ULONG v, ULONG e,
 }
 
 
+//******************************************************************************
+// NAME: InsertExtendedInstance
+//
+// INPUTS: (Instance *instance) - instance being extended
+//         (ULONG hash) - InstanceHash of instance
+//         (ULONG v) - vertex in graph where new edge being added
+//         (ULONG e) - edge in graph being added to instance
+//         (Graph *graph) - graph containing instance and new edge
+//         (InstanceList *newInstanceList) - list with hash index to
+//                                           insert into
+//         (BOOLEAN flagAnomaly) - passed to CreateExtendedInstance
+//
+// RETURN: (void)
+//
+// PURPOSE: Insert the extension of instance by edge e along vertex v
+// into newInstanceList, unless it is already there.  The check is made
+// from the instance, the edge and the new vertex, so the copy of the
+// instance's arrays made by CreateExtendedInstance is only made for
+// extensions that are inserted.
+//******************************************************************************
+
+void InsertExtendedInstance(Instance *instance, ULONG hash, ULONG v, ULONG e,
+                            Graph *graph, InstanceList *newInstanceList,
+                            BOOLEAN flagAnomaly)
+{
+   ULONG v2;
+
+   // get edge's other vertex, if not already in instance
+   if (graph->edges[e].vertex1 == v)
+      v2 = graph->edges[e].vertex2;
+   else 
+      v2 = graph->edges[e].vertex1;
+   if (FindULONG(instance->vertices, instance->numVertices, v2) <
+       instance->numVertices)
+      v2 = VERTEX_UNMAPPED;
+
+   hash = ExtendedInstanceHash(hash, e, v2);
+   if (! ExtensionOnInstanceList(instance, e, v2, hash, newInstanceList))
+      InstanceListInsertHashed(CreateExtendedInstance(instance, v, e, graph,
+                                                      flagAnomaly),
+                               hash, newInstanceList);
+}
+
+
 //******************************************************************************
 // NAME: CreateSubFromInstance
 //
@@ -310,16 +647,15 @@ void AddPosInstancesToSub(Substructure *sub, Instance *subInstance,
 {
    InstanceListNode *instanceListNode;
    Instance *instance;
-   Graph *instanceGraph;
-   double thresholdLimit;
+   InstanceList *excludedInstances;
+   double *matchCosts;
    double matchCost;
+   ULONG i;
    //ULONG counter = 0;
 
    // parameters used
    Graph *posGraph              = parameters->posGraph;
-   LabelList *labelList         = parameters->labelList;
    BOOLEAN allowInstanceOverlap = parameters->allowInstanceOverlap;
-   double threshold             = parameters->threshold;
 
    // collect positive instances of substructure
    if (instanceList != NULL) 
@@ -340,6 +676,17 @@ void AddPosInstancesToSub(Substructure *sub, Instance *subInstance,
          sub->numInstances++;
       }
       //
+      // Match candidates in parallel if possible, skipping those that
+      // overlap the instances found so far.  Candidates overlapping
+      // instances found below are still matched, and dropped below.
+      //
+      excludedInstances = sub->instances;
+      if (allowInstanceOverlap ||
+          ((parameters->prob) && (parameters->currentIteration > 1)))
+         excludedInstances = NULL;
+      matchCosts = InstanceMatchCosts(sub->definition, instanceList,
+                                      excludedInstances, posGraph, parameters);
+      i = 0;
       instanceListNode = instanceList->head;
       while (instanceListNode != NULL) 
       {
@@ -353,24 +700,25 @@ void AddPosInstancesToSub(Substructure *sub, Instance *subInstance,
                 (! InstanceListOverlap(instance, sub->instances))) ||
                 ((parameters->prob) && (parameters->currentIteration > 1)))
             {
-               thresholdLimit = threshold *
-                                (instance->numVertices + instance->numEdges);
-               instanceGraph = InstanceToGraph(instance, posGraph);
-	       if (GraphMatch(sub->definition, instanceGraph, labelList,
-                              thresholdLimit, & matchCost, NULL))
+               if (matchCosts != NULL)
+                  matchCost = matchCosts[i];
+               else
+                  matchCost = InstanceMatchCost(sub->definition, instance,
+                                                posGraph, parameters,
+                                                parameters->matchContext);
+               if (matchCost != MAX_DOUBLE)
                {
                   if (matchCost < instance->minMatchCost)
                      instance->minMatchCost = matchCost;
                   InstanceListInsert(instance, sub->instances, FALSE);
                   sub->numInstances++;
                }
-	       //
-               
-               FreeGraph(instanceGraph);
             }
+            i++;
             //counter++;
          }
          instanceListNode = instanceListNode->next;
       }
+      free(matchCosts);
    }
 }
@@ -96,7 +96,7 @@ void FlagAnomalousVerticesAndEdges(InstanceList *instanceList, Graph *graph,
          mapping = (VertexMap *) malloc(sizeof(VertexMap) * maxVertices);
          InexactGraphMatch(instanceGraph, sub->definition,
                            parameters->labelList, MAX_DOUBLE,
-                           mapping);
+                           mapping, parameters->matchContext);
       }
       else
       {
@@ -104,7 +104,7 @@ void FlagAnomalousVerticesAndEdges(InstanceList *instanceList, Graph *graph,
          mapping = (VertexMap *) malloc(sizeof(VertexMap) * maxVertices);
          InexactGraphMatch(sub->definition, instanceGraph,
                            parameters->labelList, MAX_DOUBLE,
-                           mapping);
+                           mapping, parameters->matchContext);
       }
       sortedMapping = (ULONG *) malloc(sizeof(ULONG) * maxVertices);
       if (sortedMapping == NULL)
@@ -246,7 +246,8 @@ void PrintProbabilisticAnomalies(InstanceList *instanceList,
             {
                // GUI coloring
                orignalIndex = posGraph->vertices[firstInstanceListNode->instance->vertices[i]].originalVertexIndex;
-               if ((parameters->posGraph->vertices[firstInstanceListNode->instance->vertices[i]].color != NO_COLOR) && 
+               if ((parameters->originalPosGraph != NULL) &&
+                   (parameters->posGraph->vertices[firstInstanceListNode->instance->vertices[i]].color != NO_COLOR) && 
                    (parameters->originalPosGraph->vertices[orignalIndex].color != POSITIVE_ANOM_VERTEX))
                {
                   parameters->originalPosGraph->vertices[orignalIndex].color = POSITIVE_PARTIAL_ANOM_VERTEX;
@@ -269,7 +270,8 @@ void PrintProbabilisticAnomalies(InstanceList *instanceList,
             {
                // GUI coloring
                orignalIndex = posGraph->edges[firstInstanceListNode->instance->edges[i]].originalEdgeIndex;
-               if ((parameters->posGraph->edges[firstInstanceListNode->instance->edges[i]].color != NO_COLOR) && 
+               if ((parameters->originalPosGraph != NULL) &&
+                   (parameters->posGraph->edges[firstInstanceListNode->instance->edges[i]].color != NO_COLOR) && 
                    (parameters->originalPosGraph->edges[orignalIndex].color != POSITIVE_ANOM_EDGE))
                {
                   parameters->originalPosGraph->edges[orignalIndex].color = POSITIVE_PARTIAL_ANOM_VERTEX;
@@ -284,10 +286,8 @@ void PrintProbabilisticAnomalies(InstanceList *instanceList,
 	    printf("\n");
          count++;
          ULONG posEgNo;
-         ULONG numPosEgs = parameters->numPosEgs;
-         ULONG *posEgsVertexIndices = parameters->posEgsVertexIndices;
          posEgNo = InstanceExampleNumber(firstInstanceListNode->instance,
-                                         posEgsVertexIndices, numPosEgs);
+                                         parameters->posVertexExamples);
          printf(" from positive example %lu:\n", posEgNo);
          PrintAnomalousInstance(firstInstanceListNode->instance, posGraph, 
 	                        parameters);
@@ -346,7 +346,6 @@ void StoreAnomalousEdge(Edge *overlapEdges, ULONG edgeIndex,
    overlapEdges[edgeIndex].vertex2 = v2;
    overlapEdges[edgeIndex].label = label;
    overlapEdges[edgeIndex].directed = directed;
-   overlapEdges[edgeIndex].used = FALSE;
    overlapEdges[edgeIndex].spansIncrement = spansIncrement;
    overlapEdges[edgeIndex].anomalous = anomalous;
    overlapEdges[edgeIndex].sourceVertex1 = sourceVertex1;
@@ -373,12 +372,13 @@ void PrintAnomalousVertex(Graph *graph, ULONG vertexIndex, LabelList *labelList,
                           Instance *instance, Parameters *parameters)
 {
    ULONG orignalIndex = 0;
+   Graph *originalPosGraph = parameters->originalPosGraph;
 
    printf("v %lu ", vertexIndex + 1);
    PrintLabel(graph->vertices[vertexIndex].label, labelList);
 
-   // GUI coloring
-   if (parameters->currentIteration == 1)
+   // GUI coloring, kept only for dot output
+   if ((originalPosGraph != NULL) && (parameters->currentIteration == 1))
    {
       orignalIndex = parameters->posGraph->vertices[vertexIndex].originalVertexIndex;
       if ((parameters->posGraph->vertices[vertexIndex].color != NO_COLOR) && 
@@ -402,7 +402,8 @@ void PrintAnomalousVertex(Graph *graph, ULONG vertexIndex, LabelList *labelList,
          if (instance->anomalousVertices[i] == vertexIndex)
          {
             // GUI coloring
-            if ((parameters->currentIteration == 1) && 
+            if ((originalPosGraph != NULL) &&
+                (parameters->currentIteration == 1) && 
                 (parameters->originalPosGraph->vertices[orignalIndex].color != NO_COLOR))
             {
                parameters->originalPosGraph->vertices[orignalIndex].color = 
@@ -427,8 +428,9 @@ void PrintAnomalousVertex(Graph *graph, ULONG vertexIndex, LabelList *labelList,
             }
 
             // GUI coloring
-            if (parameters->originalPosGraph->vertices[graph->vertices[vertexIndex].originalVertexIndex].anomalousValue > 
-                instance->probAnomalousValue)
+            if ((originalPosGraph != NULL) &&
+                (parameters->originalPosGraph->vertices[graph->vertices[vertexIndex].originalVertexIndex].anomalousValue > 
+                 instance->probAnomalousValue))
             {
                parameters->originalPosGraph->vertices[graph->vertices[vertexIndex].originalVertexIndex].anomalousValue = 
                   instance->probAnomalousValue;
@@ -461,6 +463,7 @@ void PrintAnomalousEdge(Graph *graph, ULONG edgeIndex, LabelList *labelList,
 {
    ULONG orignalIndex = 0;
    Edge *edge = & graph->edges[edgeIndex];
+   Graph *originalPosGraph = parameters->originalPosGraph;
 
    if (edge->directed)
       printf("d");
@@ -469,8 +472,8 @@ void PrintAnomalousEdge(Graph *graph, ULONG edgeIndex, LabelList *labelList,
    printf(" %lu %lu ", edge->vertex1 + 1, edge->vertex2 + 1);
    PrintLabel(edge->label, labelList);
 
-   // GUI coloring
-   if (parameters->currentIteration == 1)
+   // GUI coloring, kept only for dot output
+   if ((originalPosGraph != NULL) && (parameters->currentIteration == 1))
    {
       orignalIndex = parameters->posGraph->edges[edgeIndex].originalEdgeIndex;
       if (parameters->originalPosGraph->edges[orignalIndex].color != 
@@ -494,7 +497,8 @@ void PrintAnomalousEdge(Graph *graph, ULONG edgeIndex, LabelList *labelList,
          if (instance->anomalousEdges[i] == edgeIndex)
          {
             // GUI coloring
-            if (parameters->currentIteration == 1)
+            if ((originalPosGraph != NULL) &&
+                (parameters->currentIteration == 1))
             {
                parameters->originalPosGraph->edges[orignalIndex].color = 
                   POSITIVE_ANOM_EDGE;
@@ -519,8 +523,9 @@ void PrintAnomalousEdge(Graph *graph, ULONG edgeIndex, LabelList *labelList,
 	                 graph->edges[edgeIndex].sourceExample);
             }
             // GUI coloring
-            if (parameters->originalPosGraph->edges[graph->edges[edgeIndex].originalEdgeIndex].anomalousValue > 
-                instance->probAnomalousValue)
+            if ((originalPosGraph != NULL) &&
+                (parameters->originalPosGraph->edges[graph->edges[edgeIndex].originalEdgeIndex].anomalousValue > 
+                 instance->probAnomalousValue))
             {
                parameters->originalPosGraph->edges[graph->edges[edgeIndex].originalEdgeIndex].anomalousValue = 
                   instance->probAnomalousValue;
@@ -600,7 +605,7 @@ void SetExampleNumber(SubList *subList, Parameters *parameters)
    // parameters used
    Graph *graph = parameters->posGraph;
    ULONG numPosEgs = parameters->numPosEgs;
-   ULONG *posEgsVertexIndices = parameters->posEgsVertexIndices;
+   ULONG *posVertexExamples = parameters->posVertexExamples;
 
    if (subList != NULL)
    {
@@ -617,8 +622,7 @@ void SetExampleNumber(SubList *subList, Parameters *parameters)
                {
                   instance = instanceListNode->instance;
                   posEgNo = InstanceExampleNumber(instance,
-                                                  posEgsVertexIndices, 
-						  numPosEgs);
+                                                  posVertexExamples);
                   for (i = 0; i < instance->numEdges; i++)
                      graph->edges[instance->edges[i]].sourceExample = posEgNo;
                   for (i = 0; i < instance->numVertices; i++)
@@ -633,6 +637,40 @@ void SetExampleNumber(SubList *subList, Parameters *parameters)
 }
 
 
+//******************************************************************************
+// NAME: SetGraphExampleNumbers
+//
+// INPUTS: (Parameters *parameters)
+//
+// RETURN: (void)
+//
+// PURPOSE: Set the sourceExample field in every vertex and edge of the
+// positive graph.  With -maxmem, the substructures may be extended from a
+// sample of their instances, so SetExampleNumber would not reach every
+// instance; this is then called instead, on the first iteration only.
+//******************************************************************************
+
+void SetGraphExampleNumbers(Parameters *parameters)
+{
+   ULONG v;
+   ULONG e;
+
+   // parameters used
+   Graph *graph = parameters->posGraph;
+   ULONG numPosEgs = parameters->numPosEgs;
+   ULONG *posVertexExamples = parameters->posVertexExamples;
+
+   if (numPosEgs > 1)
+   {
+      for (v = 0; v < graph->numVertices; v++)
+         graph->vertices[v].sourceExample = posVertexExamples[v];
+      for (e = 0; e < graph->numEdges; e++)
+         graph->edges[e].sourceExample =
+            posVertexExamples[graph->edges[e].vertex1];
+   }
+}
+
+
 //******************************************************************************
 // NAME: AddAnomalousInstancesToBestSubstructure (GBAD-P)
 //
@@ -659,8 +697,6 @@ SubList* AddAnomalousInstancesToBestSubstructure(SubList *subList,
    double currentAnomalousValue = 0.0;
    double minAnomalousValue = 1.0;
 
-   ULONG i;
-
    char subLabelString[TOKEN_LEN];
    sprintf(subLabelString, "%s_%lu", SUB_LABEL_STRING, (parameters->currentIteration-1));
 
@@ -674,19 +710,8 @@ SubList* AddAnomalousInstancesToBestSubstructure(SubList *subList,
    bestSub->numInstances = 0;
    while (subListNode != NULL)
    {
-      for (i=0;i<subListNode->sub->definition->numVertices;i++)
-      {
-         if ((parameters->labelList->labels[subListNode->sub->definition->vertices[i].label].labelType == STRING_LABEL) &&
-             (parameters->labelList->labels[subListNode->sub->definition->vertices[i].label].labelValue.stringLabel != NULL) &&
-             (subLabelString != NULL) &&
-             (subListNode->sub->definition->numEdges > 0) &&
-	     (!strncmp(parameters->labelList->labels[subListNode->sub->definition->vertices[i].label].labelValue.stringLabel,
-	               subLabelString,5)))
-         {
-            bestSub->numInstances = bestSub->numInstances + subListNode->sub->numInstances;
-	    break;
-         }
-      }
+      if (ExtendsPreviousSub(subListNode->sub, subLabelString, parameters))
+         bestSub->numInstances = bestSub->numInstances + subListNode->sub->numInstances;
       subListNode = subListNode->next;
    }
    if (bestSub != NULL) 
@@ -704,23 +729,12 @@ SubList* AddAnomalousInstancesToBestSubstructure(SubList *subList,
    subListNode = subList->head;
    while (subListNode != NULL)
    {
-      for (i=0;i<subListNode->sub->definition->numVertices;i++)
+      if (ExtendsPreviousSub(subListNode->sub, subLabelString, parameters))
       {
-         if ((parameters->labelList->labels[subListNode->sub->definition->vertices[i].label].labelType == STRING_LABEL) &&
-             (parameters->labelList->labels[subListNode->sub->definition->vertices[i].label].labelValue.stringLabel != NULL) &&
-             (subLabelString != NULL) &&
-             (subListNode->sub->definition->numEdges > 0) &&
-	     (!strncmp(parameters->labelList->labels[subListNode->sub->definition->vertices[i].label].labelValue.stringLabel,
-	               subLabelString,5)))
-         {
-            currentAnomalousValue = (double)subListNode->sub->numInstances /
-                                    (double)parameters->numPreviousInstances;
-	    if (currentAnomalousValue < minAnomalousValue)
-	    {
-	       minAnomalousValue = currentAnomalousValue;
-	       break;
-            }
-         }
+         currentAnomalousValue = (double)subListNode->sub->numInstances /
+                                 (double)parameters->numPreviousInstances;
+         if (currentAnomalousValue < minAnomalousValue)
+            minAnomalousValue = currentAnomalousValue;
       }
       subListNode = subListNode->next;
    }
@@ -736,38 +750,29 @@ SubList* AddAnomalousInstancesToBestSubstructure(SubList *subList,
    anomInstanceList = AllocateInstanceList();
    while (subListNode != NULL)
    {
-      for (i=0;i<subListNode->sub->definition->numVertices;i++)
+      if (ExtendsPreviousSub(subListNode->sub, subLabelString, parameters))
       {
-         if ((parameters->labelList->labels[subListNode->sub->definition->vertices[i].label].labelType == STRING_LABEL) &&
-             (parameters->labelList->labels[subListNode->sub->definition->vertices[i].label].labelValue.stringLabel != NULL) &&
-             (subLabelString != NULL) &&
-             (subListNode->sub->definition->numEdges > 0) &&
-	     (!strncmp(parameters->labelList->labels[subListNode->sub->definition->vertices[i].label].labelValue.stringLabel,
-	               subLabelString,5)))
+         currentAnomalousValue = (double)subListNode->sub->numInstances /
+                                 (double)parameters->numPreviousInstances;
+         // The reason for the following unusual comparison is that there is
+         // not a good way to compare two floating type variables.  I am
+         // using this for now, BUT, if the precision needs to go out beyond
+         // 6 digits to the right, this will not work.
+         if (fabs(currentAnomalousValue - minAnomalousValue) < 0.000001)
          {
-            currentAnomalousValue = (double)subListNode->sub->numInstances /
-	                            (double)parameters->numPreviousInstances;
-            // The reason for the following unusual comparison is that there is
-	    // not a good way to compare two floating type variables.  I am
-	    // using this for now, BUT, if the precision needs to go out beyond
-	    // 6 digits to the right, this will not work.
-            if (fabs(currentAnomalousValue - minAnomalousValue) < 0.000001)
+            //
+            // Set probabilistic value for all of the instances to the
+            // same anomalous value
+            //
+            instanceList = subListNode->sub->instances;
+            instanceListNode = instanceList->head;
+            while (instanceListNode != NULL)
             {
-	       //
-	       // Set probabilistic value for all of the instances to the
-	       // same anomalous value
-	       //
-               instanceList = subListNode->sub->instances;
-               instanceListNode = instanceList->head;
-               while (instanceListNode != NULL)
-               {
-                  instance = instanceListNode->instance;
-                  instance->probAnomalousValue = (double)currentAnomalousValue;
-                  InstanceListInsert(instance, anomInstanceList, FALSE);
-                  instanceListNode = instanceListNode->next;
-               }
-	       break;
-	    }
+               instance = instanceListNode->instance;
+               instance->probAnomalousValue = (double)currentAnomalousValue;
+               InstanceListInsert(instance, anomInstanceList, FALSE);
+               instanceListNode = instanceListNode->next;
+            }
          }
       }
       subListNode = subListNode->next;
@@ -809,6 +814,42 @@ SubList* AddAnomalousInstancesToBestSubstructure(SubList *subList,
    return bestSubList;
 }
 
+//******************************************************************************
+// NAME: ExtendsPreviousSub (GBAD-P)
+//
+// INPUTS: (Substructure *sub) - substructure to check
+//         (char *subLabelString) - label of previously compressed
+//                                  substructure ("SUB_<n>")
+//         (Parameters *parameters)
+//
+// RETURN: (BOOLEAN) - TRUE if sub extends the previous substructure
+//
+// PURPOSE: Returns TRUE if the given substructure has at least one edge
+// and a vertex labeled by the previously compressed substructure, i.e.,
+// it is an extension of the normative pattern.  As before, only the
+// first five characters of the labels are compared.
+//******************************************************************************
+
+BOOLEAN ExtendsPreviousSub(Substructure *sub, char *subLabelString,
+                           Parameters *parameters)
+{
+   Label *label;
+   ULONG i;
+
+   if (sub->definition->numEdges == 0)
+      return FALSE;
+   for (i = 0; i < sub->definition->numVertices; i++)
+   {
+      label = & parameters->labelList->labels[sub->definition->vertices[i].label];
+      if ((label->labelType == STRING_LABEL) &&
+          (label->labelValue.stringLabel != NULL) &&
+          (! strncmp(label->labelValue.stringLabel, subLabelString, 5)))
+         return TRUE;
+   }
+   return FALSE;
+}
+
+
 //******************************************************************************
 // NAME: FindAnomalousInstances
 //
@@ -838,11 +879,15 @@ InstanceList *FindAnomalousInstances(Substructure *sub, Graph *g2,
    InstanceList *parentInstanceList = NULL;
    InstanceListNode *instanceListNode = NULL;
    BOOLEAN *reached;
+   BOOLEAN *visited;
+   BOOLEAN *edgeVisited;
    BOOLEAN noMatches;
    BOOLEAN found;
    Graph *g1 = sub->definition;
    ULONG numInitialVerticesToConsider;
-   ULONG i, j, vertexLabelIndex;
+   ULONG i, j;
+   ULONG *vertices;
+   ULONG numVertices;
    ULONG firstVertex = 0;
    Instance *instance = NULL;
    BOOLEAN overlaps;
@@ -853,11 +898,19 @@ InstanceList *FindAnomalousInstances(Substructure *sub, Graph *g2,
 
    parentInstanceList = AllocateInstanceList();
 
-   reached = (BOOLEAN *) malloc(sizeof(BOOLEAN) * g1->numVertices);
+   reached = (BOOLEAN *) malloc(sizeof(BOOLEAN) * (2 * g1->numVertices +
+                                                   g1->numEdges));
    if (reached == NULL)
       OutOfMemoryError("FindAnomalousInstances:reached");
+   visited = reached + g1->numVertices;
+   edgeVisited = visited + g1->numVertices;
    for (v1 = 0; v1 < g1->numVertices; v1++)
+   {
       reached[v1] = FALSE;
+      visited[v1] = FALSE;
+   }
+   for (e1 = 0; e1 < g1->numEdges; e1++)
+      edgeVisited[e1] = FALSE;
 
    //
    // In order to make sure we don't miss the anomalous instance without
@@ -876,23 +929,22 @@ InstanceList *FindAnomalousInstances(Substructure *sub, Graph *g2,
 
    for (j = 0; j < numInitialVerticesToConsider; j++)
    {
-      for (i = 0; i < g2->numVertices; i++)
+      vertices = VerticesWithLabel(g2, g1->vertices[j].label, & numVertices);
+      for (i = 0; i < numVertices; i++)
       {
-         vertexLabelIndex = g2->vertices[i].label;
-         if (g1->vertices[j].label == vertexLabelIndex)
+         instance = AllocateInstance(1, 0);
+         instance->vertices[0] = vertices[i];
+         instance->minMatchCost = 0.0;
+         overlaps = InstanceListOverlap(instance,sub->instances);
+         if (!overlaps)
          {
-            instance = AllocateInstance(1, 0);
-            instance->vertices[0] = i;
-            instance->minMatchCost = 0.0;
-            overlaps = InstanceListOverlap(instance,sub->instances);
-            if (!overlaps)
-            {
-               InstanceListInsert(instance, instanceList, FALSE);
-               reached[j] = TRUE;
-               if (firstVertex == 0)
-                  firstVertex = j;
-            }
+            InstanceListInsert(instance, instanceList, FALSE);
+            reached[j] = TRUE;
+            if (firstVertex == 0)
+               firstVertex = j;
          }
+         else
+            FreeInstance(instance);
       }
    }
 
@@ -903,12 +955,12 @@ InstanceList *FindAnomalousInstances(Substructure *sub, Graph *g2,
       noMatches = TRUE;
    while ((vertex1 != NULL) && (!noMatches))
    {
-      vertex1->used = TRUE;
+      visited[v1] = TRUE;
       // extend by each unmarked edge involving vertex v1
       for (e1 = 0; ((e1 < vertex1->numEdges) && (!noMatches)); e1++)
       {
          edge1 = & g1->edges[g1->vertices[v1].edges[e1]];
-         if (!edge1->used)
+         if (! edgeVisited[g1->vertices[v1].edges[e1]])
          {
             reached[edge1->vertex1] = TRUE;
             reached[edge1->vertex2] = TRUE;
@@ -917,16 +969,16 @@ InstanceList *FindAnomalousInstances(Substructure *sub, Graph *g2,
                                               parameters);
             if (instanceList->head == NULL)
                noMatches = TRUE;
-            edge1->used = TRUE;
+            edgeVisited[g1->vertices[v1].edges[e1]] = TRUE;
          }
       }
 
-      // find next un-used, reached vertex (for next loop through)
+      // find next unvisited, reached vertex (for next loop through)
       vertex1 = NULL;
       found = FALSE;
       for (v = 0; ((v < g1->numVertices) && (! found)); v++)
       {
-         if ((! g1->vertices[v].used) && (reached[v]))
+         if ((! visited[v]) && (reached[v]))
          {
             v1 = v;
             vertex1 = & g1->vertices[v1];
@@ -956,7 +1008,8 @@ InstanceList *FindAnomalousInstances(Substructure *sub, Graph *g2,
                      // true candidates....
                      instanceGraph = InstanceToGraph(instanceListNode->instance, posGraph);
                      GraphMatch(sub->definition,instanceGraph,parameters->labelList, MAX_DOUBLE,
-                                & matchCost, NULL);
+                                & matchCost, NULL,
+                                parameters->matchContext);
                      matchThreshold = matchCost /
                                       (sub->definition->numVertices + sub->definition->numEdges);
                      //
@@ -981,12 +1034,6 @@ InstanceList *FindAnomalousInstances(Substructure *sub, Graph *g2,
    }
    free(reached);
 
-   // set used flags to FALSE
-   for (v1 = 0; v1 < g1->numVertices; v1++)
-      g1->vertices[v1].used = FALSE;
-   for (e1 = 0; e1 < g1->numEdges; e1++)
-      g1->edges[e1].used = FALSE;
-
    return parentInstanceList;
 }
 
@@ -1045,7 +1092,8 @@ void ScoreAndPrintAnomalousInstances(InstanceList *instanceList,
                {
                   otherInstanceGraph = InstanceToGraph(otherInstance, posGraph);
                   GraphMatch(instanceGraph, otherInstanceGraph, labelList,
-                             MAX_DOUBLE, & matchCost, NULL);
+                             MAX_DOUBLE, & matchCost, NULL,
+                             parameters->matchContext);
                   if (matchCost == 0.0)
                   {
                      instance->frequency++;
@@ -1143,11 +1191,8 @@ void ScoreAndPrintAnomalousInstances(InstanceList *instanceList,
             {
                printf("\n");
                ULONG posEgNo;
-               ULONG numPosEgs = parameters->numPosEgs;
-               ULONG *posEgsVertexIndices = parameters->posEgsVertexIndices;
                posEgNo = InstanceExampleNumber(instanceListNode->instance,
-                                               posEgsVertexIndices,
-                                               numPosEgs);
+                                               parameters->posVertexExamples);
                printf(" from example %lu:\n", posEgNo);
                PrintAnomalousInstance(instanceListNode->instance, 
                                       posGraph, parameters);
@@ -1616,7 +1661,8 @@ void ScoreAndPrintAnomalousAncestors(InstanceList *instanceList,
          //
          instanceGraph = InstanceToGraph(instance, posGraph);
          GraphMatch(sub->definition,instanceGraph,labelList, MAX_DOUBLE, 
-                    & matchCost, NULL);
+                    & matchCost, NULL,
+                    parameters->matchContext);
          matchThreshold = matchCost / 
                      (sub->definition->numVertices + sub->definition->numEdges);
          //
@@ -1673,7 +1719,8 @@ void ScoreAndPrintAnomalousAncestors(InstanceList *instanceList,
                {
                   otherInstanceGraph = InstanceToGraph(otherInstance, posGraph);
                   GraphMatch(instanceGraph, otherInstanceGraph, labelList,
-                             MAX_DOUBLE, & matchCost, NULL);
+                             MAX_DOUBLE, & matchCost, NULL,
+                             parameters->matchContext);
                   if (matchCost == 0.0)
                   {
                      instance->frequency++;
@@ -1820,11 +1867,8 @@ void ScoreAndPrintAnomalousAncestors(InstanceList *instanceList,
             {
                printf("\n");
                ULONG posEgNo;
-               ULONG numPosEgs = parameters->numPosEgs;
-               ULONG *posEgsVertexIndices = parameters->posEgsVertexIndices;
                posEgNo = InstanceExampleNumber(instanceListNode->instance,
-                                               posEgsVertexIndices,
-                                               numPosEgs);
+                                               parameters->posVertexExamples);
                printf(" from example %lu:\n", posEgNo);
                PrintAnomalousInstance(instanceListNode->instance, 
                                       posGraph, parameters);
@@ -2091,22 +2135,34 @@ InstanceList *FindPotentialAnomalousAncestors(Substructure *sub, Graph *g2,
    InstanceList *parentInstanceList = NULL;
    InstanceListNode *instanceListNode = NULL;
    BOOLEAN *reached;
+   BOOLEAN *visited;
+   BOOLEAN *edgeVisited;
    BOOLEAN noMatches;
    BOOLEAN found;
    Graph *g1 = sub->definition;
    ULONG numInitialVerticesToConsider;
-   ULONG i, j, vertexLabelIndex;
+   ULONG i, j;
+   ULONG *vertices;
+   ULONG numVertices;
    ULONG firstVertex = 0;
    Instance *instance = NULL;
    BOOLEAN overlaps;
 
    parentInstanceList = AllocateInstanceList();
 
-   reached = (BOOLEAN *) malloc(sizeof(BOOLEAN) * g1->numVertices);
+   reached = (BOOLEAN *) malloc(sizeof(BOOLEAN) * (2 * g1->numVertices +
+                                                   g1->numEdges));
    if (reached == NULL)
       OutOfMemoryError("FindPotentialAnomalousAncestors:reached");
+   visited = reached + g1->numVertices;
+   edgeVisited = visited + g1->numVertices;
    for (v1 = 0; v1 < g1->numVertices; v1++)
+   {
       reached[v1] = FALSE;
+      visited[v1] = FALSE;
+   }
+   for (e1 = 0; e1 < g1->numEdges; e1++)
+      edgeVisited[e1] = FALSE;
 
    //
    // In order to make sure we don't miss the anomalous instance without
@@ -2118,26 +2174,27 @@ InstanceList *FindPotentialAnomalousAncestors(Substructure *sub, Graph *g2,
 
    numInitialVerticesToConsider = (ULONG) ((g1->numVertices + g1->numEdges) * 
                                            parameters->mpsThreshold) + 1;
+   if (numInitialVerticesToConsider > g1->numVertices)
+      numInitialVerticesToConsider = g1->numVertices;
 
    for (j = 0; j < numInitialVerticesToConsider; j++)
    {
-      for (i = 0; i < g2->numVertices; i++)
+      vertices = VerticesWithLabel(g2, g1->vertices[j].label, & numVertices);
+      for (i = 0; i < numVertices; i++)
       {
-         vertexLabelIndex = g2->vertices[i].label;
-         if (g1->vertices[j].label == vertexLabelIndex)
+         instance = AllocateInstance(1, 0);
+         instance->vertices[0] = vertices[i];
+         instance->minMatchCost = 0.0;
+         overlaps = InstanceListOverlap(instance,sub->instances);
+         if (!overlaps)
          {
-            instance = AllocateInstance(1, 0);
-            instance->vertices[0] = i;
-            instance->minMatchCost = 0.0;
-            overlaps = InstanceListOverlap(instance,sub->instances);
-            if (!overlaps)
-            {
-               InstanceListInsert(instance, instanceList, FALSE);
-               reached[j] = TRUE;
-               if (firstVertex == 0)
-                  firstVertex = j;
-            }
+            InstanceListInsert(instance, instanceList, FALSE);
+            reached[j] = TRUE;
+            if (firstVertex == 0)
+               firstVertex = j;
          }
+         else
+            FreeInstance(instance);
       }
    }
 
@@ -2148,7 +2205,7 @@ InstanceList *FindPotentialAnomalousAncestors(Substructure *sub, Graph *g2,
       noMatches = TRUE;
    while ((vertex1 != NULL) && (! noMatches))
    {
-      vertex1->used = TRUE;
+      visited[v1] = TRUE;
       // extend by each unmarked edge involving vertex v1
       for (e1 = 0; ((e1 < vertex1->numEdges) && (! noMatches)); e1++)
       {
@@ -2156,7 +2213,7 @@ InstanceList *FindPotentialAnomalousAncestors(Substructure *sub, Graph *g2,
          // Need to make sure this is a new edge extension AND that we are
          // still dealing with an instance that when extended would be
          // smaller than the normative pattern
-         if ((! edge1->used) && 
+         if ((! edgeVisited[g1->vertices[v1].edges[e1]]) && 
              (((instanceList->head->instance->numVertices + 1) < g1->numVertices) ||
               ((instanceList->head->instance->numEdges + 1) < g1->numEdges)))
          {
@@ -2168,16 +2225,16 @@ InstanceList *FindPotentialAnomalousAncestors(Substructure *sub, Graph *g2,
                                                     parameters);
             if (instanceList->head == NULL)
                noMatches = TRUE;
-            edge1->used = TRUE;
+            edgeVisited[g1->vertices[v1].edges[e1]] = TRUE;
          }
       }
 
-      // find next un-used, reached vertex
+      // find next unvisited, reached vertex
       vertex1 = NULL;
       found = FALSE;
       for (v = 0; ((v < g1->numVertices) && (! found)); v++)
       {
-         if ((! g1->vertices[v].used) && (reached[v]))
+         if ((! visited[v]) && (reached[v]))
          {
             v1 = v;
             vertex1 = & g1->vertices[v1];
@@ -2213,12 +2270,6 @@ InstanceList *FindPotentialAnomalousAncestors(Substructure *sub, Graph *g2,
    }
    free(reached);
 
-   // set used flags to FALSE
-   for (v1 = 0; v1 < g1->numVertices; v1++)
-      g1->vertices[v1].used = FALSE;
-   for (e1 = 0; e1 < g1->numEdges; e1++)
-      g1->edges[e1].used = FALSE;
-
    return parentInstanceList;
 }
 
@@ -2238,7 +2289,8 @@ InstanceList *FindPotentialAnomalousAncestors(Substructure *sub, Graph *g2,
 // PURPOSE: Attempts to extend each instance in instanceList by an
 // edge from graph g2 that matches the attributes of the given edge in
 // graph g1.  Returns a new (possibly empty) instance list containing
-// the extended instances.  The given instance list is de-allocated.
+// the extended instances.  The given instance list is de-allocated.  With
+// several threads, the instances are extended in parallel.
 //******************************************************************************
 
 InstanceList *ExtendPotentialInstancesByEdge(InstanceList *instanceList,
@@ -2248,25 +2300,81 @@ InstanceList *ExtendPotentialInstancesByEdge(InstanceList *instanceList,
 {
    InstanceList *newInstanceList;
    InstanceListNode *instanceListNode;
+
+   if ((parameters->numThreads > 1) && (instanceList->numNodes > 1))
+      newInstanceList = ExtendPotentialInstancesInParallel(instanceList, g1,
+                                                           g2, sub, FALSE,
+                                                           parameters);
+   else
+   {
+      newInstanceList = AllocateInstanceList();
+      AddPotentialExtensions(instanceList, g1, g2, sub, newInstanceList,
+                             parameters);
+   }
+
+   //
+   // If no new extensions, return what we have so far
+   //
+   if (newInstanceList->head == NULL)
+   {
+      instanceListNode = instanceList->head;
+      if (instanceListNode->instance != NULL)
+      {
+         while (instanceListNode != NULL)
+         {
+            InstanceListInsert(instanceListNode->instance, newInstanceList,
+                               TRUE);
+            instanceListNode = instanceListNode->next;
+         }
+      }
+   }
+
+   FreeInstanceList(instanceList);
+   return newInstanceList;
+}
+
+
+//******************************************************************************
+// NAME: AddPotentialExtensions
+//
+// INPUTS: (InstanceList *instanceList) - instances to extend by one edge
+//         (Graph *g1) - graph whose instances we are looking for
+//         (Graph *g2) - graph containing instances
+//         (Substructure *sub) - best substructure
+//         (InstanceList *newInstanceList) - list extensions are added to
+//         (Parameters *parameters) - global parameters
+//
+// RETURN: (void)
+//
+// PURPOSE: Adds the extensions of each instance in instanceList by an edge
+// from graph g2 to newInstanceList for ExtendPotentialInstancesByEdge:
+// those still smaller than the normative pattern, and those of its size
+// that match it closely enough to be anomalous.
+//******************************************************************************
+
+void AddPotentialExtensions(InstanceList *instanceList, Graph *g1, Graph *g2,
+                            Substructure *sub, InstanceList *newInstanceList,
+                            Parameters *parameters)
+{
+   InstanceListNode *instanceListNode;
    Instance *instance;
    Instance *newInstance;
    ULONG v2;
    ULONG e2;
-   Edge *edge2;
    Vertex *vertex2;
    BOOLEAN overlaps = FALSE;
-   BOOLEAN noExtensions = TRUE;
    double matchCost;
    double matchThreshold;
    Graph *instanceGraph;
+   Workspace *workspace = parameters->workspace;
 
-   newInstanceList = AllocateInstanceList();
    // extend each instance
    instanceListNode = instanceList->head;
    while (instanceListNode != NULL)
    {
       instance = instanceListNode->instance;
-      MarkInstanceEdges(instance, g2, TRUE);
+      NewWorkspaceEpoch(workspace, g2);
+      MarkInstanceEdges(instance, workspace);
       //
       // See if the instance overlaps with any of the
       // best substructure instances; if so, we can skip doing any 
@@ -2284,8 +2392,7 @@ InstanceList *ExtendPotentialInstancesByEdge(InstanceList *instanceList,
             vertex2 = & g2->vertices[instance->vertices[v2]];
             for (e2 = 0; e2 < vertex2->numEdges; e2++)
             {
-               edge2 = & g2->edges[vertex2->edges[e2]];
-               if (!edge2->used)
+               if (! EDGE_MARKED(workspace, vertex2->edges[e2]))
                {
                   // add new instance to list
                   newInstance =
@@ -2303,16 +2410,17 @@ InstanceList *ExtendPotentialInstancesByEdge(InstanceList *instanceList,
                             (newInstance->numEdges < sub->definition->numEdges))
                         {
                            InstanceListInsert(newInstance, newInstanceList, TRUE);
-                           noExtensions = FALSE;
                         }
                         // if the size of the normative pattern, see if it is
-                        // a candidate...
-                        if ((newInstance->numVertices == sub->definition->numVertices) &&
+                        // a candidate... (else, since a duplicate inserted
+                        // above has been freed)
+                        else if ((newInstance->numVertices == sub->definition->numVertices) &&
                             (newInstance->numEdges == sub->definition->numEdges))
                         {
                            instanceGraph = InstanceToGraph(newInstance, g2);
                            GraphMatch(sub->definition,instanceGraph,parameters->labelList, MAX_DOUBLE,
-                                      & matchCost, NULL);
+                                      & matchCost, NULL,
+                                      parameters->matchContext);
                            matchThreshold = matchCost /
                                             (sub->definition->numVertices + sub->definition->numEdges);
                            //
@@ -2323,7 +2431,6 @@ InstanceList *ExtendPotentialInstancesByEdge(InstanceList *instanceList,
                                (matchCost <= parameters->maxAnomalousScore))
                            {
                               InstanceListInsert(newInstance, newInstanceList, TRUE);
-                              noExtensions = FALSE;
                            }
                            FreeGraph(instanceGraph);
                         }
@@ -2333,14 +2440,53 @@ InstanceList *ExtendPotentialInstancesByEdge(InstanceList *instanceList,
             }
          }
       }
-      MarkInstanceEdges(instance, g2, FALSE);
       instanceListNode = instanceListNode->next;
    }
+}
+
+
+//******************************************************************************
+// NAME: ExtendPotentialInstancesByEdgeForMPS
+//
+// INPUTS: (InstanceList *instanceList) - instances to extend by one edge
+//         (Graph *g1) - graph whose instances we are looking for
+//         (Edge *edge1) - edge in g1 by which to extend each instance
+//         (Graph *g2) - graph containing instances
+//         (Parameters parameters) - global parameters
+//
+// RETURN: (InstanceList *) - new instance list with extended instances
+//
+// PURPOSE: Attempts to extend each instance in instanceList by an
+// edge from graph g2 that matches the attributes of the given edge in
+// graph g1.  Returns a new (possibly empty) instance list containing
+// the extended instances.  The given instance list is de-allocated.
+// This is for the MPS approach only.  With several threads, the instances
+// are extended in parallel.
+//******************************************************************************
+
+InstanceList *ExtendPotentialInstancesByEdgeForMPS(InstanceList *instanceList,
+                                                   Graph *g1, Edge *edge1, 
+                                                   Graph *g2, Substructure *sub,
+                                                   Parameters *parameters)
+{
+   InstanceList *newInstanceList;
+   InstanceListNode *instanceListNode;
+
+   if ((parameters->numThreads > 1) && (instanceList->numNodes > 1))
+      newInstanceList = ExtendPotentialInstancesInParallel(instanceList, g1,
+                                                           g2, sub, TRUE,
+                                                           parameters);
+   else
+   {
+      newInstanceList = AllocateInstanceList();
+      AddPotentialExtensionsForMPS(instanceList, g1, g2, sub, newInstanceList,
+                                   parameters);
+   }
 
    //
    // If no new extensions, return what we have so far
    //
-   if ((newInstanceList->head == NULL) && (noExtensions))
+   if (newInstanceList->head == NULL)
    {
       instanceListNode = instanceList->head;
       if (instanceListNode->instance != NULL)
@@ -2358,50 +2504,48 @@ InstanceList *ExtendPotentialInstancesByEdge(InstanceList *instanceList,
    return newInstanceList;
 }
 
+
 //******************************************************************************
-// NAME: ExtendPotentialInstancesByEdgeForMPS
+// NAME: AddPotentialExtensionsForMPS
 //
 // INPUTS: (InstanceList *instanceList) - instances to extend by one edge
 //         (Graph *g1) - graph whose instances we are looking for
-//         (Edge *edge1) - edge in g1 by which to extend each instance
 //         (Graph *g2) - graph containing instances
-//         (Parameters parameters) - global parameters
+//         (Substructure *sub) - best substructure
+//         (InstanceList *newInstanceList) - list extensions are added to
+//         (Parameters *parameters) - global parameters
 //
-// RETURN: (InstanceList *) - new instance list with extended instances
+// RETURN: (void)
 //
-// PURPOSE: Attempts to extend each instance in instanceList by an
-// edge from graph g2 that matches the attributes of the given edge in
-// graph g1.  Returns a new (possibly empty) instance list containing
-// the extended instances.  The given instance list is de-allocated.
-// This is for the MPS approach only.
+// PURPOSE: Adds the extensions of each instance in instanceList by an edge
+// from graph g2 that do not overlap the normative instances to
+// newInstanceList for ExtendPotentialInstancesByEdgeForMPS.
 //******************************************************************************
 
-InstanceList *ExtendPotentialInstancesByEdgeForMPS(InstanceList *instanceList,
-                                                   Graph *g1, Edge *edge1, 
-                                                   Graph *g2, Substructure *sub,
-                                                   Parameters *parameters)
+void AddPotentialExtensionsForMPS(InstanceList *instanceList, Graph *g1,
+                                  Graph *g2, Substructure *sub,
+                                  InstanceList *newInstanceList,
+                                  Parameters *parameters)
 {
-   InstanceList *newInstanceList;
    InstanceListNode *instanceListNode;
    Instance *instance;
    Instance *newInstance;
    ULONG v2;
    ULONG e2;
-   Edge *edge2;
    Vertex *vertex2;
    BOOLEAN overlaps = FALSE;
-   BOOLEAN noExtensions = TRUE;
 
    ULONG possibleEdgeChanges = g1->numEdges + 2;
    ULONG possibleVertexChanges = g1->numVertices;
+   Workspace *workspace = parameters->workspace;
 
-   newInstanceList = AllocateInstanceList();
    // extend each instance
    instanceListNode = instanceList->head;
    while (instanceListNode != NULL)
    {
       instance = instanceListNode->instance;
-      MarkInstanceEdges(instance, g2, TRUE);
+      NewWorkspaceEpoch(workspace, g2);
+      MarkInstanceEdges(instance, workspace);
       //
       // See if the instance overlaps with any of the
       // best substructure instances; if so, we can skip doing any 
@@ -2410,7 +2554,7 @@ InstanceList *ExtendPotentialInstancesByEdgeForMPS(InstanceList *instanceList,
       overlaps = InstanceListOverlap(instance,sub->instances);
       //
       // Need to avoid overlapping instances, HOWEVER, it is possible that with
-      // the way edges are extended, plus the "used" flags, could cause
+      // the way edges are extended, plus the edge marks, could cause
       // potential anomalous instances to be missed.  So, once the growth
       // has reached a significant size, let's allow some overlap
       //
@@ -2422,8 +2566,7 @@ InstanceList *ExtendPotentialInstancesByEdgeForMPS(InstanceList *instanceList,
             vertex2 = & g2->vertices[instance->vertices[v2]];
             for (e2 = 0; e2 < vertex2->numEdges; e2++)
             {
-               edge2 = & g2->edges[vertex2->edges[e2]];
-               if (! edge2->used)
+               if (! EDGE_MARKED(workspace, vertex2->edges[e2]))
                {
                   // add new instance to list
                   newInstance =
@@ -2436,7 +2579,6 @@ InstanceList *ExtendPotentialInstancesByEdgeForMPS(InstanceList *instanceList,
                      if (!InstanceListOverlap(newInstance,sub->instances))
                      {
                         InstanceListInsert(newInstance, newInstanceList, TRUE);
-                        noExtensions = FALSE;
                      }
                   }
 
@@ -2456,26 +2598,120 @@ InstanceList *ExtendPotentialInstancesByEdgeForMPS(InstanceList *instanceList,
             }
          }
       }
-      MarkInstanceEdges(instance, g2, FALSE);
       instanceListNode = instanceListNode->next;
    }
-   //
-   // If no new extensions, return what we have so far
-   //
-   if ((newInstanceList->head == NULL) && (noExtensions))
-   {
-      instanceListNode = instanceList->head;
-      if (instanceListNode->instance != NULL)
-      {
-         while (instanceListNode != NULL)
-         {
-            InstanceListInsert(instanceListNode->instance, newInstanceList,
-                               TRUE);
-            instanceListNode = instanceListNode->next;
-         }
-      }
-   }
+}
 
-   FreeInstanceList(instanceList);
+
+//******************************************************************************
+// NAME: ExtendPotentialInstancesInParallel
+//
+// INPUTS: (InstanceList *instanceList) - instances to extend by one edge
+//         (Graph *g1) - graph whose instances we are looking for
+//         (Graph *g2) - graph containing instances
+//         (Substructure *sub) - best substructure
+//         (BOOLEAN forMPS) - TRUE if extending for GBAD-MPS
+//         (Parameters *parameters) - global parameters
+//
+// RETURN: (InstanceList *) - new instance list with extended instances
+//
+// PURPOSE: Same as AddPotentialExtensions (or AddPotentialExtensionsForMPS)
+// to a new list, but with the instances split into chunks (see
+// SplitInstanceList) that parameters->numThreads worker threads extend
+// independently.  The chunks' extensions are then merged by
+// MergeInstanceChunks, so the resulting list is the same as when
+// extending serially.  The given instance list is left as is.
+//******************************************************************************
+
+InstanceList *ExtendPotentialInstancesInParallel(InstanceList *instanceList,
+                                                 Graph *g1, Graph *g2,
+                                                 Substructure *sub,
+                                                 BOOLEAN forMPS,
+                                                 Parameters *parameters)
+{
+   PotentialInstanceQueue queue;
+   InstanceList *newInstanceList;
+   ULONG numThreads = parameters->numThreads;
+   ULONG c;
+
+   queue.chunks = SplitInstanceList(instanceList, numThreads,
+                                    & queue.numChunks);
+   queue.extensions =
+      (InstanceList **) malloc(sizeof(InstanceList *) * queue.numChunks);
+   if (queue.extensions == NULL)
+      OutOfMemoryError("ExtendPotentialInstancesInParallel:queue.extensions");
+   for (c = 0; c < queue.numChunks; c++)
+      queue.extensions[c] = AllocateInstanceList();
+   queue.g1 = g1;
+   queue.g2 = g2;
+   queue.sub = sub;
+   queue.forMPS = forMPS;
+   queue.nextChunk = 0;
+   queue.parameters = parameters;
+   // build the normative instances' vertex set and the pattern's
+   // fingerprint now, so that workers only read them
+   if (sub->instances->vertexSet == NULL)
+      IndexInstanceVertices(sub->instances, VERTEX_SET_SIZE);
+   GetGraphFingerprint(sub->definition);
+   GraphFingerprintHash(sub->definition);
+
+   if (numThreads > queue.numChunks)
+      numThreads = queue.numChunks;
+   pthread_mutex_init(& queue.mutex, NULL);
+   RunWorkerThreads(PotentialInstanceWorker, & queue, numThreads,
+                    "ExtendPotentialInstancesInParallel");
+   pthread_mutex_destroy(& queue.mutex);
+
+   newInstanceList = MergeInstanceChunks(queue.extensions, queue.numChunks);
+   for (c = 0; c < queue.numChunks; c++)
+      FreeInstanceList(queue.chunks[c]);
+   free(queue.extensions);
+   free(queue.chunks);
    return newInstanceList;
 }
+
+
+//******************************************************************************
+// NAME: PotentialInstanceWorker
+//
+// INPUTS: (void *arg) - PotentialInstanceQueue shared by workers
+//
+// RETURN: (void *) - NULL
+//
+// PURPOSE: Thread function taking chunks of instances from the queue until
+// none are left, adding the extensions of each chunk to its own list.
+// Each worker uses a private copy of the parameters with its own workspace
+// and match context.
+//******************************************************************************
+
+void *PotentialInstanceWorker(void *arg)
+{
+   PotentialInstanceQueue *queue = (PotentialInstanceQueue *) arg;
+   Parameters threadParameters = *(queue->parameters);
+   ULONG c;
+
+   threadParameters.workspace = AllocateWorkspace();
+   threadParameters.matchContext = AllocateMatchContext();
+   while (TRUE)
+   {
+      pthread_mutex_lock(& queue->mutex);
+      c = queue->nextChunk;
+      if (c < queue->numChunks)
+         queue->nextChunk++;
+      pthread_mutex_unlock(& queue->mutex);
+      if (c >= queue->numChunks)
+         break;
+
+      if (queue->forMPS)
+         AddPotentialExtensionsForMPS(queue->chunks[c], queue->g1, queue->g2,
+                                      queue->sub, queue->extensions[c],
+                                      & threadParameters);
+      else
+         AddPotentialExtensions(queue->chunks[c], queue->g1, queue->g2,
+                                queue->sub, queue->extensions[c],
+                                & threadParameters);
+   }
+   FreeWorkspace(threadParameters.workspace);
+   FreeMatchContext(threadParameters.matchContext);
+   return NULL;
+}
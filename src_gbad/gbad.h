@@ -24,6 +24,7 @@
 #include <limits.h>
 #include <float.h>
 #include <math.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -42,6 +43,9 @@
 // If set to zero, then no limit
 #define MATCH_SEARCH_THRESHOLD_EXPONENT 3.0
 
+// Number of neighborhood refinement rounds used by GraphHash
+#define GRAPH_HASH_ROUNDS 3
+
 // Starting strings for input files
 #define SUB_TOKEN        "S"  // new substructure
 #define PREDEF_SUB_TOKEN "PS" // new predefined substructure
@@ -66,6 +70,13 @@
 #define SUBSTITUTE_EDGE_DIRECTION_COST 1.0 // change directedness of edge
 #define REVERSE_EDGE_DIRECTION_COST    1.0 // change direction of directed edge
 
+// Lower bounds used by InexactGraphMatch to estimate the remaining cost of
+// a partial match; each must not exceed the smallest of the costs above
+// that apply to a vertex (insert, delete, substitute label) or an edge
+// (delete, delete with vertex, substitute label), respectively
+#define MIN_VERTEX_MATCH_COST          1.0
+#define MIN_EDGE_MATCH_COST            1.0
+
 // Constants for graph matcher.  Special vertex mappings use the upper few
 // unsigned long integers.  This assumes graphs will never have this many
 // vertices, which is a pretty safe assumption.  The maximum double is used
@@ -73,7 +84,10 @@
 #define MAX_UNSIGNED_LONG ULONG_MAX  // ULONG_MAX defined in limits.h
 #define VERTEX_UNMAPPED   MAX_UNSIGNED_LONG
 #define VERTEX_DELETED    MAX_UNSIGNED_LONG - 1
+#define NO_MATCH_MAP      MAX_UNSIGNED_LONG // empty mapping of match node
 #define MAX_DOUBLE        DBL_MAX    // DBL_MAX from float.h
+#define MAX_EPOCH         UINT_MAX   // UINT_MAX defined in limits.h
+#define ULONG_BITS        (sizeof(ULONG) * CHAR_BIT) // bits in bit set word
 
 // Label types
 #define STRING_LABEL  0
@@ -81,16 +95,36 @@
 
 // General defines
 #define LIST_SIZE_INC  100  // initial size and increment for realloc-ed lists
+#define INSTANCE_HASH_SIZE 64 // initial number of buckets in instance list index
+#define VERTEX_SET_SIZE 64 // initial size of instance list vertex set (power of 2)
+#define SUB_BEAM_HASH_SIZE 64 // initial number of buckets in substructure beam index
+#define INSTANCE_MATCH_CHUNK 16 // candidates taken at once by a match worker
+#define EXTEND_CHUNKS_PER_THREAD 4 // instance chunks per thread when
+                                   //   extending instances in parallel
+#define MIN_SAMPLE_INSTANCES 16 // least instances of a substructure extended
+                                //   when sampling under -maxmem
 #define TOKEN_LEN     256  // maximum length of token from input graph file
 #define FILE_NAME_LEN 512  // maximum length of file names
 #define COMMENT       '%'  // comment character for input graph file
+#define LABEL_CACHE_SIZE 64 // initial size of graph parser label cache
+                            //   (power of 2)
+#define ERR_STR_LEN   64   // maximum length of graph parser error message
+#define LOAD_CHUNKS_PER_THREAD 4 // input file chunks per thread when
+                                 //   parsing XP examples in parallel
+#define LOAD_CHUNK_MIN_SIZE 1048576 // least bytes of input file per chunk
 #define NUMERIC_OUTPUT_PRECISION 6
 #define LOG_2 0.6931471805599452862 // log_e(2) pre-computed
 
+// Positions in array-based heaps (match queue, substructure beam)
+#define HeapParent(i) ((i - 1) / 2)
+#define HeapLeftChild(i) ((2 * i) + 1)
+#define HeapRightChild(i) ((2 * i) + 2)
+
 #define SPACE ' '
 #define TAB   '\t'
 #define NEWLINE '\n'
 #define DOUBLEQUOTE '\"'
+#define SINGLEQUOTE '\''
 #define CARRIAGERETURN '\r'
 
 #define FALSE 0
@@ -103,6 +137,7 @@
 typedef unsigned char UCHAR;
 typedef unsigned char BOOLEAN;
 typedef unsigned long ULONG;
+typedef unsigned int EPOCH; // 32-bit visitation stamp, see Workspace
 
 // GUI coloring
 typedef enum COLOR
@@ -137,7 +172,6 @@ typedef struct
       char *stringLabel;
       double numericLabel;
    } labelValue;
-   BOOLEAN used;          // flag used to mark labels at various times
 } Label;
 
 // Label list
@@ -155,8 +189,6 @@ typedef struct
    ULONG   vertex2;  // target vertex index into vertices array
    ULONG   label;    // index into label list of edge's label
    BOOLEAN directed; // TRUE if edge is directed
-   BOOLEAN used;     // flag for marking edge used at various times
-                     //   used flag assumed FALSE, so always reset when done
    BOOLEAN spansIncrement;   // TRUE if edge crosses a previous increment
    BOOLEAN validPath;
    BOOLEAN anomalous; // flag indicating whether or not this vertex is an anomaly
@@ -178,8 +210,6 @@ typedef struct
    ULONG *edges;   // indices into edge array of edges using this vertex
    ULONG map;      // used to store mapping of this vertex to corresponding
                    //   vertex in another graph
-   BOOLEAN used;   // flag for marking vertex used at various times
-                   //   used flag assumed FALSE, so always reset when done
    BOOLEAN anomalous; // flag indicating whether or not this vertex is an anomaly
                       // will be marked when compression takes place
    ULONG   sourceVertex;  // original source vertex ID
@@ -190,6 +220,49 @@ typedef struct
    double anomalousValue;      // anomalous value for appropriate coloring
 } Vertex;
 
+// GraphFingerprint: isomorphism invariants of a graph, used by the graph
+// matcher to reject pairs without searching; arrays share one allocation
+typedef struct
+{
+   ULONG hash;             // GraphHash of graph, computed on first use
+                           //   (0 = not computed)
+   ULONG *vertexLabels;    // labels of vertices, sorted
+   ULONG *edgeLabels;      // labels of edges, sorted
+   ULONG *degrees;         // degrees of vertices, in decreasing order
+   ULONG *orderedVertices; // vertices in order of decreasing degree
+} GraphFingerprint;
+
+// VertexLabelIndex: vertices of a graph grouped by label; arrays share one
+// allocation
+typedef struct
+{
+   ULONG numLabels; // labels indexed are 0..numLabels-1
+   ULONG *start;    // vertices with label l are vertices[start[l]] up to
+                    //   vertices[start[l+1]-1]
+   ULONG *vertices; // vertex indices, increasing within each label
+} VertexLabelIndex;
+
+// IncidentEdge: edge of a vertex keyed by the edge's type as seen from
+// the vertex
+typedef struct
+{
+   ULONG label;      // label of edge
+   BOOLEAN directed; // TRUE if edge directed
+   BOOLEAN source;   // TRUE if directed edge leaves the vertex (also TRUE
+                     //   for directed self-edges, FALSE if undirected)
+   ULONG otherLabel; // label of edge's other vertex
+   ULONG position;   // position of edge in the vertex's edge list
+} IncidentEdge;
+
+// EdgeTypeIndex: edges of each vertex of a graph sorted by type, then by
+// position in the vertex's edge list; arrays share one allocation
+typedef struct
+{
+   ULONG *start;         // edges of vertex v are edges[start[v]] up to
+                         //   edges[start[v+1]-1]
+   IncidentEdge *edges;
+} EdgeTypeIndex;
+
 // Graph
 typedef struct 
 {
@@ -197,6 +270,14 @@ typedef struct
    ULONG  numEdges;    // number of edges in graph
    Vertex *vertices;   // array of graph vertices
    Edge   *edges;      // array of graph edges
+   GraphFingerprint *fingerprint; // computed when first matched (NULL if
+                                  //   not computed); cleared when a vertex
+                                  //   or edge is added
+   VertexLabelIndex *labelIndex;  // vertices by label (NULL if not built);
+                                  //   cleared when vertices or labels change
+   EdgeTypeIndex *edgeIndex;      // edges of vertices by type (NULL if not
+                                  //   built); cleared when vertices, edges
+                                  //   or labels change
 } Graph;
 
 // VertexMap: vertex to vertex mapping for graph match search
@@ -243,12 +324,24 @@ typedef struct _instance_list_node
 {
    Instance *instance;
    struct _instance_list_node *next;
+   ULONG hash;                              // InstanceHash of instance
+   struct _instance_list_node *nextInBucket; // next node in same hash bucket
 } InstanceListNode;
 
-// InstanceList: singly-linked list of instances
+// InstanceList: singly-linked list of instances, with an optional hash
+// index used to find duplicates during unique inserts, and an optional
+// set of the vertices covered by its instances used for overlap checks
 typedef struct 
 {
    InstanceListNode *head;
+   ULONG numNodes;              // number of nodes on list
+   ULONG numBuckets;            // size of hash index (0 if not yet built)
+   InstanceListNode **buckets;  // hash index of nodes on list
+   ULONG vertexSetSize;         // size of vertex set (0 if not yet built)
+   ULONG numSetVertices;        // number of distinct vertices in vertex set
+   ULONG *vertexSet;            // open-addressing hash set of vertices of
+                                //   instances on list, VERTEX_UNMAPPED if
+                                //   slot empty
 } InstanceList;
 
 // Substructure
@@ -263,6 +356,9 @@ typedef struct _substructure
    double posIncrementValue;   // DL/#Egs value of sub for positive increment
    ULONG  numParentInstances;  // number of positive parent instances
    InstanceList *parentInstances;  // instances in positive parent substructure
+   double instanceScale;       // instances in positive graph represented by
+                               //   each instance kept (> 1.0 if extended
+                               //   from a sample of its parent's instances)
 } Substructure;
 
 // SubListNode: node in singly-linked list of substructures
@@ -278,14 +374,91 @@ typedef struct
    SubListNode *head;
 } SubList;
 
+// SubBeamEntry: substructure kept in a beam
+typedef struct _sub_beam_entry
+{
+   Substructure *sub;
+   ULONG order;   // insertion order; of equal values, earlier is better
+   ULONG hash;    // SubHash of sub
+   struct _sub_beam_entry *nextInBucket; // next entry in same hash bucket
+} SubBeamEntry;
+
+// SubBeam: bounded queue of the best substructures found so far, kept as
+// a heap with the worst substructure on top and a hash index of the
+// substructures for finding duplicates; turned into a SubList, in
+// decreasing order by value, by SubBeamToList
+typedef struct
+{
+   ULONG max;              // max substructures or values (0 = no limit)
+   BOOLEAN valueBased;     // TRUE if max limits number of different values
+   ULONG size;             // number of entries allocated in heap
+   ULONG numEntries;       // number of entries in heap
+   SubBeamEntry **heap;    // heap of entries, worst at heap[0]
+   ULONG numInserts;       // number of substructures inserted so far
+   ULONG numValues;        // number of different values, if valueBased
+   double *values;         // different values in decreasing order
+   ULONG *valueCounts;     // number of entries with each value
+   ULONG numBuckets;       // number of buckets in hash index
+   SubBeamEntry **buckets; // hash index of entries by SubHash
+   double bestValue;       // value of best substructure in beam
+} SubBeam;
+
+// ExtensionType: type of single-edge extensions of single-vertex
+// substructures (GBAD-P), given by the edge and the labels at either end
+typedef struct _extension_type
+{
+   ULONG label1;      // label of edge's first vertex (source, if directed)
+   ULONG label2;      // label of edge's second vertex
+   ULONG edgeLabel;   // label of edge
+   BOOLEAN directed;  // TRUE if edge directed
+   BOOLEAN selfEdge;  // TRUE if edge is a self-edge
+   Substructure *sub; // substructure collecting extensions of this type
+   struct _extension_type *nextInBucket; // next type in same hash bucket
+} ExtensionType;
+
 // MatchHeapNode: node in heap for graph match search queue
 typedef struct 
 {
    ULONG  depth; // depth of node in search space (number of vertices mapped)
    double cost;  // cost of mapping
-   VertexMap *mapping;
+   double bound; // cost plus lower bound on cost of completing mapping
+   ULONG  map;   // last vertex map of mapping in MatchContext's maps,
+                 //   or NO_MATCH_MAP
 } MatchHeapNode;
 
+// MatchMap: vertex map in a partial mapping of the graph matcher; the
+// rest of the mapping is found by following the parent maps
+typedef struct
+{
+   ULONG v1;
+   ULONG v2;
+   ULONG parent; // index of previous vertex map, or NO_MATCH_MAP
+} MatchMap;
+
+// MatchBound: label counts of the parts of two graphs not yet matched,
+// from which InexactGraphMatch bounds the cost of completing a mapping
+typedef struct
+{
+   ULONG vertexListSize; // allocated size of vertex label arrays
+   ULONG edgeListSize;   // allocated size of edge label arrays
+   ULONG labelListSize;  // allocated size of label count arrays
+   ULONG *labels;        // labels of both graphs, sorted
+   ULONG numLabels;      // number of different labels in both graphs
+   ULONG *vertexLabels1; // label (0..numLabels-1) of each vertex of g1
+   ULONG *vertexLabels2; // label (0..numLabels-1) of each vertex of g2
+   ULONG *edgeLabels1;   // label (0..numLabels-1) of each edge of g1
+   ULONG *edgeLabels2;   // label (0..numLabels-1) of each edge of g2
+   ULONG *vertexCount1;  // unmapped vertices of g1 with each label
+   ULONG *vertexCount2;  // unmapped vertices of g2 with each label
+   ULONG *edgeCount1;    // edges of g1 not yet costed with each label
+   ULONG *edgeCount2;    // edges of g2 not yet costed with each label
+   ULONG numVertices1;   // unmapped vertices of g1
+   ULONG numVertices2;   // unmapped vertices of g2
+   ULONG numEdges1;      // edges of g1 not yet costed
+   ULONG commonVertices; // sum over labels of min(vertexCount1,vertexCount2)
+   ULONG commonEdges;    // sum over labels of min(edgeCount1,edgeCount2)
+} MatchBound;
+
 // MatchHeap: heap of match nodes
 typedef struct 
 {
@@ -294,6 +467,36 @@ typedef struct
    MatchHeapNode *nodes;
 } MatchHeap;
 
+// MatchContext: memory used by the graph matcher, kept between matches so
+// that matching does not allocate once the context has grown large enough;
+// one context per thread
+typedef struct
+{
+   ULONG vertexListSize;   // allocated size of vertex arrays
+   ULONG *orderedVertices; // vertices of g1 in the order they are mapped
+   ULONG *vertexDegree;    // degrees used for ordering vertices
+   ULONG *mapped1;         // mapping of vertices in g1 to vertices in g2
+   ULONG *mapped2;         // mapping of vertices in g2 to vertices in g1
+   ULONG *anchor;          // ExactGraphMatch: earlier vertex of g1 adjacent
+                           //   to each vertex in order, or VERTEX_UNMAPPED
+   ULONG *nextCandidate;   // ExactGraphMatch: next candidate at each depth
+   ULONG *inDegree1;       // ExactGraphMatch: incoming directed edges of
+   ULONG *outDegree1;      //   each vertex of g1, and outgoing
+   ULONG *inDegree2;       // ExactGraphMatch: same for g2
+   ULONG *outDegree2;
+   ULONG edgeListSize;     // allocated size of edgeUsed
+   BOOLEAN *edgeUsed;      // edges of g2 already matched
+   ULONG mapListSize;      // allocated size of maps
+   ULONG numMaps;          // vertex maps used by current match
+   MatchMap *maps;         // vertex maps of all partial mappings searched
+   MatchHeap *queue;       // partial mappings to be expanded
+   MatchBound *matchBound; // label counts for bounding match cost
+   Graph *instanceGraph;   // InstanceToMatchGraph: graph of an instance
+   ULONG instanceVertexListSize; // allocated vertices of instanceGraph
+   ULONG instanceEdgeListSize;   // allocated edges of instanceGraph
+   ULONG *instanceEdgeLists;     // storage for edge lists of instanceGraph
+} MatchContext;
+
 // ReferenceEdge
 typedef struct
 {
@@ -388,8 +591,119 @@ typedef struct
    IncrementListNode *head;
 } IncrementList;
 
+// GraphStats: per-vertex adjacency matrix statistics of a graph, as used by
+// the MDL computation, cached so that the description length of the graph
+// compressed by a substructure can be computed without compressing it
+typedef struct
+{
+   ULONG numVertices;  // number of vertices in graph
+   ULONG *uniqueEdges; // k_i, number of 1s in row i of adjacency matrix
+   ULONG *maxEdges;    // most edges from vertex i to any single vertex
+} GraphStats;
+
+// RowEdge: edge in one row of the adjacency matrix, as seen from the
+// vertex owning the row
+typedef struct
+{
+   ULONG neighbor;   // vertex at other end of edge (in row ordering)
+   ULONG position;   // position of edge in the vertex's edge list
+   BOOLEAN directed; // TRUE if edge is directed
+   BOOLEAN outgoing; // TRUE if edge is directed away from the row's vertex
+} RowEdge;
+
+// Workspace: per-thread marks on the vertices and edges of a graph, used
+// instead of flags in the graph itself so that a shared graph is only ever
+// read.  A vertex or edge is marked when its stamp equals the current
+// epoch, so starting a new epoch clears all marks at once.
+typedef struct
+{
+   EPOCH epoch;          // stamp of marks set since last NewWorkspaceEpoch
+   ULONG vertexListSize; // allocated size of vertexMark and vertexMap
+   ULONG edgeListSize;   // allocated size of edgeMark
+   EPOCH *vertexMark;    // epoch in which each vertex was last marked
+   EPOCH *edgeMark;      // epoch in which each edge was last marked
+   ULONG *vertexMap;     // mapping of each vertex, valid only while marked
+   ULONG exampleSetSize; // allocated size of exampleSet, in words
+   ULONG *exampleSet;    // bit set of examples, cleared by whoever sets it
+} Workspace;
+
+// Workspace marks on vertex or edge index i
+#define VERTEX_MARKED(ws, i) ((ws)->vertexMark[i] == (ws)->epoch)
+#define MARK_VERTEX(ws, i)   ((ws)->vertexMark[i] = (ws)->epoch)
+#define UNMARK_VERTEX(ws, i) ((ws)->vertexMark[i] = 0)
+#define EDGE_MARKED(ws, i)   ((ws)->edgeMark[i] == (ws)->epoch)
+#define MARK_EDGE(ws, i)     ((ws)->edgeMark[i] = (ws)->epoch)
+
+// BeamTask: extension of one parent substructure by a worker thread
+typedef struct
+{
+   Substructure *parentSub;   // substructure to extend
+   SubList *extendedSubList;  // extensions of parentSub
+   BOOLEAN evaluated;         // TRUE if extensions already evaluated
+   InstanceList *allInstances; // instances of parentSub while it holds
+                               //   a sample of them, else NULL
+} BeamTask;
+
+// BeamTaskQueue: tasks of one beam level shared by worker threads
+typedef struct
+{
+   BeamTask *tasks;          // tasks in parent list order
+   ULONG numTasks;           // number of tasks
+   ULONG nextTask;           // next task to be taken by a worker
+   pthread_mutex_t mutex;    // protects nextTask
+   BOOLEAN evaluate;         // TRUE if workers also evaluate extensions
+   struct _parameters *parameters; // parameters shared by all workers
+} BeamTaskQueue;
+
+// InstanceMatchQueue: candidate instances matched against a substructure
+// by worker threads
+typedef struct
+{
+   Graph *subGraph;          // graph candidates are matched against
+   Graph *graph;             // graph containing candidates
+   Instance **instances;     // candidates in list order
+   ULONG numInstances;       // number of candidates
+   InstanceList *excludedInstances; // candidates overlapping these are not
+                                    //   matched (NULL if none)
+   double *matchCosts;       // match cost of each candidate, or MAX_DOUBLE
+   ULONG nextInstance;       // next candidate to be taken by a worker
+   pthread_mutex_t mutex;    // protects nextInstance
+   struct _parameters *parameters; // parameters shared by all workers
+} InstanceMatchQueue;
+
+// InstanceSearchQueue: chunks of instances extended by one edge by worker
+// threads in FindInstances
+typedef struct
+{
+   Graph *g1;                // graph whose instances are found
+   Edge *edge1;              // edge of g1 by which instances are extended
+   Graph *g2;                // graph containing instances
+   InstanceList **chunks;    // instances of each chunk, replaced by their
+                             //   extensions
+   ULONG numChunks;          // number of chunks
+   ULONG nextChunk;          // next chunk to be taken by a worker
+   pthread_mutex_t mutex;    // protects nextChunk
+   struct _parameters *parameters; // parameters shared by all workers
+} InstanceSearchQueue;
+
+// PotentialInstanceQueue: chunks of potential anomalous instances extended
+// by one edge by worker threads in GBAD-MDL and GBAD-MPS
+typedef struct
+{
+   Graph *g1;                  // normative pattern
+   Graph *g2;                  // graph containing instances
+   Substructure *sub;          // best substructure
+   BOOLEAN forMPS;             // TRUE if extending for GBAD-MPS
+   InstanceList **chunks;      // instances of each chunk
+   InstanceList **extensions;  // extensions of the instances of each chunk
+   ULONG numChunks;            // number of chunks
+   ULONG nextChunk;            // next chunk to be taken by a worker
+   pthread_mutex_t mutex;      // protects nextChunk
+   struct _parameters *parameters; // parameters shared by all workers
+} PotentialInstanceQueue;
+
 // Parameters: parameters used throughout GBAD system
-typedef struct 
+typedef struct _parameters
 {
    char inputFileName[FILE_NAME_LEN];   // main input file
    char psInputFileName[FILE_NAME_LEN]; // predefined substructures input file
@@ -398,6 +712,7 @@ typedef struct
    double posGraphDL;    // Description length of positive input graph
    ULONG numPosEgs;      // Number of positive examples
    ULONG *posEgsVertexIndices; // vertex indices of where positive egs begin
+   ULONG *posVertexExamples; // positive example number of each vertex
    LabelList *labelList; // List of unique labels in input graph(s)
    Graph **preSubs;      // Array of predefined substructure graphs
    ULONG numPreSubs;     // Number of predefined substructures read in
@@ -405,6 +720,13 @@ typedef struct
    BOOLEAN outputToFile; // TRUE if file given for machine-readable output
    BOOLEAN directed;     // If TRUE, 'e' edges treated as directed
    ULONG beamWidth;      // Limit on size of substructure queue (> 0)
+   ULONG numThreads;     // Number of threads extending and evaluating the
+                         //   substructures of one beam level (> 0)
+   ULONG maxMemory;      // Soft limit on bytes held in instance lists during
+                         //   discovery (0 = no limit)
+   double sampleFraction; // Fraction of the instances of each
+                          //   substructure extended at the current beam
+                          //   level (if maxMemory > 0)
    ULONG limit;          // Limit on number of substructures expanded (> 0)
    ULONG maxVertices;    // Maximum vertices in discovered substructures
    ULONG minVertices;    // Minimum vertices in discovered substructures
@@ -428,6 +750,10 @@ typedef struct
                          // graph compressed with best sub between iterations
    double *log2Factorial;   // Cache array A[i] = lg(i!); grows as needed
    ULONG log2FactorialSize; // Size of log2Factorial array
+   GraphStats *posGraphStats; // MDL statistics of posGraph, computed when
+                              // first needed (NULL if not computed)
+   Workspace *workspace; // Marks on posGraph private to this thread
+   MatchContext *matchContext; // Graph matcher memory private to this thread
    BOOLEAN compress;     // If TRUE, write compressed graph to file
    IncrementList *incrementList;   // Set of increments
    InstanceVertexList *vertexList; // List of avl trees containing
@@ -454,8 +780,10 @@ typedef struct
 
    // GUI coloring
    char dotFileName[FILE_NAME_LEN];     // file name to write dot file into
-   Graph *originalPosGraph;      // copy of posGraph
-   LabelList *originalLabelList;  // copy of labelList
+   Graph *originalPosGraph;      // copy of input posGraph for dot output
+                                 //   (NULL unless dotToFile)
+   LabelList *originalLabelList;  // copy of input labelList (NULL unless
+                                  //   dotToFile)
    BOOLEAN dotToFile;    // TRUE if file given for dot file output
    BOOLEAN optimize;     // user option to skip certain processing and assume 
                          // solution is near
@@ -478,6 +806,7 @@ typedef struct
 // compress.c
 
 Graph *CompressGraph(Graph *, InstanceList *, Parameters *);
+void CompressGraphInPlace(Graph *, InstanceList *, Parameters *);
 //
 // GBAD
 //
@@ -494,7 +823,7 @@ void CompressFinalGraphs(Substructure *, Parameters *, ULONG, BOOLEAN);
 void CompressLabelListWithGraph(LabelList *, Graph *, Parameters *);
 ULONG SizeOfCompressedGraph(Graph *, InstanceList *, Parameters *, ULONG);
 void RemovePosEgsCovered(Substructure *, Parameters *);
-void MarkExample(ULONG, ULONG, Graph *, BOOLEAN);
+void MarkExample(ULONG, ULONG, Graph *, Workspace *);
 void CopyUnmarkedGraph(Graph *, Graph *, ULONG, Parameters *);
 void CompressWithPredefinedSubs(Parameters *);
 void WriteCompressedGraphToFile(Substructure *sub, Parameters *parameters,
@@ -506,6 +835,12 @@ void MarkPosEgsCovered(Substructure *, Parameters *);
 // discover.c
 void color_subs(Parameters *, SubList *);
 SubList *DiscoverSubs(Parameters *, ULONG);     // GBAD-P  change in parameters
+BOOLEAN SubToBeExtended(Substructure *, Parameters *);
+void SetSampleFraction(SubList *, SubBeam *, SubBeam *, ULONG, ULONG,
+                       Parameters *);
+void FindSampledSubInstances(SubBeam *, SubBeam *, Parameters *);
+void ExtendBeamLevel(BeamTask *, ULONG, Parameters *);
+void *BeamWorker(void *);
 SubList *GetInitialSubs(Parameters *);
 BOOLEAN SinglePreviousSub(Substructure *, Parameters *);
 
@@ -521,22 +856,35 @@ void WriteEdgeToDotFile(FILE *, ULONG, ULONG, Graph *, LabelList *, char *);
 // evaluate.c
 
 void EvaluateSub(Substructure *, Parameters *);
+double ScaleCompressedSize(double, double, double, Substructure *);
 ULONG GraphSize(Graph *);
 double MDL(Graph *, ULONG, Parameters *);
-ULONG NumUniqueEdges(Graph *, ULONG);
-ULONG MaxEdgesToSingleVertex(Graph *, ULONG);
+void VertexRowStats(Graph *, ULONG, ULONG *, ULONG *, ULONG *, ULONG *);
 double ExternalEdgeBits(Graph *, Graph *, ULONG);
 double Log2Factorial(ULONG, Parameters *);
 double Log2(ULONG);
 ULONG PosExamplesCovered(Substructure *, Parameters *);
-ULONG ExamplesCovered(InstanceList *, Graph *, ULONG, ULONG *, ULONG);
+ULONG ExamplesCovered(InstanceList *, ULONG, ULONG *, ULONG *, ULONG,
+                      Workspace *);
+GraphStats *ComputeGraphStats(Graph *);
+void FreeGraphStats(GraphStats *);
+double CompressedGraphMDL(Graph *, GraphStats *, Substructure *, ULONG,
+                          Parameters *);
+void RowStats(RowEdge *, ULONG, ULONG, ULONG *, ULONG *);
 
 // extend.c
 
 SubList *ExtendSub(Substructure *, Parameters *);
+void GroupExtensionsByType(InstanceList *, SubList *, Parameters *);
+double ExtensionBytes(InstanceList *, Graph *);
+ULONG SampleSize(ULONG, Parameters *);
+InstanceList *SampleSubInstances(Substructure *, Parameters *);
+void RestoreSubInstances(Substructure *, InstanceList *);
 // GBAD-P  changed the following parameters
 InstanceList *ExtendInstances(InstanceList *, Graph *, BOOLEAN, Parameters *);
 Instance *CreateExtendedInstance(Instance *, ULONG, ULONG, Graph *, BOOLEAN);
+void InsertExtendedInstance(Instance *, ULONG, ULONG, ULONG, Graph *,
+                            InstanceList *, BOOLEAN);
 
 Substructure *CreateSubFromInstance(Instance *, Graph *);
 void AddPosInstancesToSub(Substructure *, Instance *, InstanceList *, 
@@ -551,10 +899,12 @@ void FlagAnomalousVerticesAndEdges(InstanceList *,Graph *,Substructure *,
 void StoreAnomalousEdge(Edge *, ULONG, ULONG, ULONG, ULONG, BOOLEAN, BOOLEAN, 
                         BOOLEAN, ULONG, ULONG, ULONG);
 void SetExampleNumber(SubList *, Parameters *);
+void SetGraphExampleNumbers(Parameters *);
 void PrintAnomalousVertex(Graph *, ULONG, LabelList *, Instance *, 
                           Parameters *);
 void PrintAnomalousEdge(Graph *, ULONG, LabelList *, Instance *, Parameters *);
 void PrintAnomalousInstance(Instance *, Graph *, Parameters *);
+BOOLEAN ExtendsPreviousSub(Substructure *, char *, Parameters *);
 
 InstanceList *FindAnomalousInstances(Substructure *, Graph *, Parameters *);
 InstanceList *FindPotentialAnomalousAncestors(Substructure *, Graph *, Parameters *);
@@ -564,6 +914,15 @@ InstanceList *ExtendPotentialInstancesByEdgeForMPS(InstanceList *, Graph *,
                                                    Edge *, Graph *, 
                                                    Substructure *, 
                                                    Parameters *);
+void AddPotentialExtensions(InstanceList *, Graph *, Graph *, Substructure *,
+                            InstanceList *, Parameters *);
+void AddPotentialExtensionsForMPS(InstanceList *, Graph *, Graph *,
+                                  Substructure *, InstanceList *,
+                                  Parameters *);
+InstanceList *ExtendPotentialInstancesInParallel(InstanceList *, Graph *,
+                                                 Graph *, Substructure *,
+                                                 BOOLEAN, Parameters *);
+void *PotentialInstanceWorker(void *);
 void ScoreAndPrintAnomalousInstances(InstanceList *, Substructure *, 
                                      Parameters *);
 void ScoreAndPrintAnomalousAncestors(InstanceList *, Substructure *, 
@@ -575,23 +934,44 @@ Substructure *GBAD_P(SubList *, ULONG, Parameters *);
 // graphmatch.c
 
 BOOLEAN GraphMatch(Graph *, Graph *, LabelList *, double, double *,
-                   VertexMap *);
-double InexactGraphMatch(Graph *, Graph *, LabelList *, double, VertexMap *);
-void OrderVerticesByDegree(Graph *, ULONG *);
+                   VertexMap *, MatchContext *);
+double InexactGraphMatch(Graph *, Graph *, LabelList *, double, VertexMap *,
+                         MatchContext *);
+MatchContext *AllocateMatchContext(void);
+void SizeMatchContext(MatchContext *, Graph *, Graph *);
+ULONG AddMatchMap(MatchContext *, ULONG, ULONG, ULONG);
+void FreeMatchContext(MatchContext *);
+BOOLEAN ExactGraphMatch(Graph *, Graph *, VertexMap *, MatchContext *);
+void OrderVerticesForExactMatch(Graph *, MatchContext *);
+ULONG NextExactMatchCandidate(Graph *, Graph *, ULONG, MatchContext *);
+BOOLEAN ExactMatchFeasible(Graph *, Graph *, ULONG, ULONG, MatchContext *);
+void OrderVerticesByDegree(Graph *, ULONG *, ULONG *);
 ULONG MaximumNodes(ULONG);
-double DeletedEdgesCost(Graph *, Graph *, ULONG, ULONG, ULONG *, LabelList *);
-double InsertedEdgesCost(Graph *, ULONG, ULONG *);
+double DeletedEdgesCost(Graph *, Graph *, ULONG, ULONG, ULONG *, LabelList *,
+                        BOOLEAN *);
+double InsertedEdgesCost(Graph *, ULONG, ULONG *, BOOLEAN *);
 double InsertedVerticesCost(Graph *, ULONG *);
+MatchBound *AllocateMatchBound(void);
+void SetMatchBoundLabels(MatchBound *, Graph *, Graph *);
+void InitMatchBound(MatchBound *, Graph *, Graph *, ULONG *, ULONG *);
+double MatchBoundCost(MatchBound *, Graph *, Graph *, ULONG, ULONG,
+                      ULONG *, ULONG *);
+void FreeMatchBound(MatchBound *);
+ULONG MixHash(ULONG);
+ULONG GraphHash(Graph *);
+GraphFingerprint *GetGraphFingerprint(Graph *);
+ULONG GraphFingerprintHash(Graph *);
+BOOLEAN SameGraphFingerprint(Graph *, Graph *);
+double FingerprintMatchCost(Graph *, Graph *);
+void FreeGraphFingerprint(Graph *);
 MatchHeap *AllocateMatchHeap(ULONG);
-VertexMap *AllocateNewMapping(ULONG, VertexMap *, ULONG, ULONG);
 void InsertMatchHeapNode(MatchHeapNode *, MatchHeap *);
 void ExtractMatchHeapNode(MatchHeap *, MatchHeapNode *);
 void HeapifyMatchHeap(MatchHeap *);
 BOOLEAN MatchHeapEmpty(MatchHeap *);
-void MergeMatchHeaps(MatchHeap *, MatchHeap *);
 void CompressMatchHeap(MatchHeap *, ULONG);
-void PrintMatchHeapNode(MatchHeapNode *);
-void PrintMatchHeap(MatchHeap *);
+void PrintMatchHeapNode(MatchHeapNode *, MatchContext *);
+void PrintMatchHeap(MatchHeap *, MatchContext *);
 void ClearMatchHeap(MatchHeap *);
 void FreeMatchHeap(MatchHeap *);
 
@@ -599,6 +979,7 @@ void FreeMatchHeap(MatchHeap *);
 
 void ReadInputFile(Parameters *);
 ULONG *AddVertexIndex(ULONG *, ULONG, ULONG);
+void IndexPosExamples(Parameters *);
 void ReadPredefinedSubsFile(Parameters *);
 void AddVertex(Graph *, ULONG, ULONG *, ULONG);
 void AddEdge(Graph *, ULONG, ULONG, BOOLEAN, ULONG, ULONG *, BOOLEAN);
@@ -607,6 +988,16 @@ void AddEdgeToVertices(Graph *, ULONG);
 Graph *AllocateGraph(ULONG, ULONG);
 Graph *CopyGraph(Graph *);
 void FreeGraph(Graph *);
+void IndexVertexLabels(Graph *);
+ULONG *VerticesWithLabel(Graph *, ULONG, ULONG *);
+void FreeVertexLabelIndex(Graph *);
+void IndexEdgeTypes(Graph *);
+IncidentEdge *EdgesOfType(Graph *, ULONG, ULONG, BOOLEAN, BOOLEAN, ULONG,
+                          ULONG *);
+void FreeEdgeTypeIndex(Graph *);
+Workspace *AllocateWorkspace(void);
+void NewWorkspaceEpoch(Workspace *, Graph *);
+void FreeWorkspace(Workspace *);
 void PrintGraph(Graph *, LabelList *);
 void PrintVertex(Graph *, ULONG, LabelList *);
 void PrintEdge(Graph *, ULONG, LabelList *);
@@ -618,11 +1009,6 @@ void WriteAnomGraphToFile(Graph *, LabelList *, ULONG, ULONG, ULONG, ULONG,
                           ULONG, double);
 void WriteAnomInstanceToFile(Instance *, Graph *, Parameters *, ULONG);
 Graph *ReadGraph(char *, LabelList *, BOOLEAN);
-void ReadVertex(Graph *, FILE *, LabelList *, ULONG *, ULONG *, ULONG);
-void ReadEdge(Graph *, FILE *, LabelList *, ULONG *, ULONG *, BOOLEAN, ULONG);
-int ReadToken(char *, FILE *, ULONG *);
-ULONG ReadLabel(FILE *, LabelList *, ULONG *);
-ULONG ReadInteger(FILE *, ULONG *);
 /////////////////////////////////////////////////////// WFE - PLADS
 
 // labels.c
@@ -643,12 +1029,21 @@ void PrintLabelToFile(FILE *, ULONG, LabelList *);
 // sgiso.c
 
 InstanceList *FindInstances(Graph *, Graph *, Parameters *);
+ULONG PatternEdgeOrder(Graph *, ULONG *);
+InstanceList *ExtendInstancesInParallel(InstanceList *, Graph *, Edge *,
+                                        Graph *, Parameters *);
+void *InstanceSearchWorker(void *);
 InstanceList *FindSingleVertexInstances(Graph *, Vertex *, Parameters *);
 InstanceList *ExtendInstancesByEdge(InstanceList *, Graph *, Edge *,
                                     Graph *, Parameters *);
 BOOLEAN EdgesMatch(Graph *, Edge *, Graph *, Edge *, Parameters *);
 InstanceList *FilterInstances(Graph *, InstanceList *, Graph *,
                               Parameters *);
+double InstanceMatchCost(Graph *, Instance *, Graph *, Parameters *,
+                         MatchContext *);
+double *InstanceMatchCosts(Graph *, InstanceList *, InstanceList *, Graph *,
+                           Parameters *);
+void *InstanceMatchWorker(void *);
 
 // subops.c
 
@@ -659,10 +1054,16 @@ SubListNode *AllocateSubListNode(Substructure *);
 void FreeSubListNode(SubListNode *);
 SubList *AllocateSubList(void);
 void SubListInsert(Substructure *, SubList *, ULONG, BOOLEAN, LabelList *);
+SubBeam *AllocateSubBeam(ULONG, BOOLEAN);
+void IndexSubBeam(SubBeam *, ULONG);
+void RemoveWorstSubBeamEntry(SubBeam *);
+void SubBeamInsert(Substructure *, SubBeam *, LabelList *);
+SubList *SubBeamToList(SubBeam *);
 BOOLEAN MemberOfSubList(Substructure *, SubList *, LabelList *);
+ULONG SubHash(Substructure *);
 void FreeSubList(SubList *);
 void PrintSubList(SubList *, Parameters *);
-void PrintNewBestSub(Substructure *, SubList *, Parameters *);
+void PrintNewBestSub(Substructure *, SubBeam *, Parameters *);
 ULONG CountSubs(SubList *);
 Instance *AllocateInstance(ULONG, ULONG);
 void FreeInstance(Instance *);
@@ -670,21 +1071,36 @@ void PrintInstance(Instance *, Graph *, LabelList *);
 void PrintInstanceList(InstanceList *, Graph *, LabelList *);
 void PrintPosInstanceList(Substructure *, Parameters *);
 //
-void MarkInstanceVertices(Instance *, Graph *, BOOLEAN);
-void MarkInstanceEdges(Instance *, Graph *, BOOLEAN);
+void MarkInstanceVertices(Instance *, Workspace *);
+void MarkInstanceEdges(Instance *, Workspace *);
+BOOLEAN InstanceContainsEdge(Instance *, ULONG);
 InstanceListNode *AllocateInstanceListNode(Instance *);
 void FreeInstanceListNode(InstanceListNode *);
 InstanceList *AllocateInstanceList(void);
 void FreeInstanceList(InstanceList *);
-ULONG InstanceExampleNumber(Instance *, ULONG *, ULONG);
+ULONG InstanceBytes(ULONG, ULONG);
+ULONG InstanceListBytes(InstanceList *);
+ULONG InstanceExampleNumber(Instance *, ULONG *);
 ULONG CountInstances(InstanceList *);
 void InstanceListInsert(Instance *, InstanceList *, BOOLEAN);
+void InstanceListInsertHashed(Instance *, ULONG, InstanceList *);
+InstanceList **SplitInstanceList(InstanceList *, ULONG, ULONG *);
+InstanceList *MergeInstanceChunks(InstanceList **, ULONG);
 BOOLEAN MemberOfInstanceList(Instance *, InstanceList *);
+BOOLEAN MemberOfInstanceIndex(Instance *, ULONG, InstanceList *);
+ULONG InstanceHash(Instance *);
+ULONG ExtendedInstanceHash(ULONG, ULONG, ULONG);
+BOOLEAN ExtensionOnInstanceList(Instance *, ULONG, ULONG, ULONG, InstanceList *);
+void IndexInstanceList(InstanceList *, ULONG);
 BOOLEAN InstanceMatch(Instance *, Instance *);
 BOOLEAN InstanceOverlap(Instance *, Instance *);
 BOOLEAN InstanceListOverlap(Instance *, InstanceList *);
+void IndexInstanceVertices(InstanceList *, ULONG);
+ULONG VertexSetSlot(InstanceList *, ULONG);
+void AddVertexToSet(InstanceList *, ULONG);
 BOOLEAN InstancesOverlap(InstanceList *);
 Graph *InstanceToGraph(Instance *, Graph *);
+Graph *InstanceToMatchGraph(Instance *, Graph *, MatchContext *);
 BOOLEAN InstanceContainsVertex(Instance *, ULONG);
 void AddInstanceToInstance(Instance *, Instance *);
 void AddEdgeToInstance(ULONG, Edge *, Instance *);
@@ -695,6 +1111,11 @@ void UpdateMapping(Instance *, Instance *);
 void OutOfMemoryError(char *);
 void PrintBoolean(BOOLEAN);
 Substructure * CopySub(Substructure *);
+int CompareULONGs(const void *, const void *);
+ULONG SortUnique(ULONG *, ULONG);
+ULONG FindULONG(ULONG *, ULONG, ULONG);
+ULONG NumCommonULONGs(ULONG *, ULONG, ULONG *, ULONG);
+void RunWorkerThreads(void *(*)(void *), void *, ULONG, char *);
 
 
 //******************************************************************************
@@ -719,8 +1140,80 @@ typedef struct graph_info_t
    
    BOOLEAN xp_graph;             // TRUE if reading XP graphs, otherwise
                                  // FALSE if reading PS graphs
+   BOOLEAN plain_graph;          // TRUE if reading a single graph without
+                                 // XP headers
+   ULONG numThreads;             // threads parsing XP examples of large
+                                 // files, in chunks
 } Graph_Info;
 
+// Graph parser label cache entry
+typedef struct
+{
+   ULONG hash;                   // hash of label
+   ULONG labelIndex;             // index of label in label list plus one,
+                                 //   or zero if entry unused
+} LabelCacheEntry;
+
+// Graph parser state, scanning a graph file mapped into memory
+typedef struct
+{
+   Graph_Info *info;             // where graph elements are stored
+   char *fileName;               // name of file, for error messages
+   const char *next;             // next character to scan
+   const char *end;              // end of text
+   ULONG lineNo;                 // line number of next character
+   const char *token;            // latest token, not null-terminated
+   ULONG tokenLength;            // length of latest token, 0 at end of text
+   ULONG tokenLineNo;            // line number of latest token
+   BOOLEAN tokenQuoted;          // TRUE if latest token is a quoted string
+   LabelCacheEntry *labelCache;  // open-addressed map of labels parsed
+   ULONG labelCacheSize;         // size of label cache (power of 2)
+   ULONG numCachedLabels;        // number of labels in label cache
+   BOOLEAN chunk;                // TRUE if parsing a chunk of the file on
+                                 //   its own, without reporting errors
+   BOOLEAN failed;               // TRUE if chunk could not be parsed
+   ULONG egOffset;               // number of examples before chunk, from
+                                 //   its first XP number
+   ULONG *labelMap;              // label list index of each chunk label
+   ULONG vertexBase;             // index of chunk's first vertex in graph
+   ULONG edgeBase;               // index of chunk's first edge in graph
+} GraphParser;
+
+// GraphParseQueue: chunks of an input file parsed by worker threads
+typedef struct
+{
+   GraphParser *chunks;          // parser of each chunk
+   ULONG numChunks;              // number of chunks
+   ULONG nextChunk;              // next chunk to be taken by a worker
+   pthread_mutex_t mutex;        // protects nextChunk
+   Graph *graph;                 // graph chunks are copied into once
+                                 //   parsed (NULL while parsing)
+} GraphParseQueue;
+
 int GP_read_graph(Graph_Info *, char *);
+void GP_init_parser(GraphParser *, Graph_Info *, char *, const char *, ULONG);
+void GP_free_parser(GraphParser *);
+int GP_parse(GraphParser *);
+BOOLEAN GP_parse_in_parallel(GraphParser *);
+void *GP_parse_worker(void *);
+void GP_run_workers(GraphParseQueue *, ULONG);
+const char *GP_find_example(const char *, const char *, const char *);
+void GP_merge_chunks(GraphParser *, GraphParser *, ULONG);
+void GP_copy_chunk(Graph *, GraphParser *);
+BOOLEAN GP_next_token(GraphParser *);
+BOOLEAN GP_next_label(GraphParser *);
+ULONG GP_count_lines(const char *, const char *);
+BOOLEAN GP_token_is(GraphParser *, const char *);
+BOOLEAN GP_read_number(GraphParser *, ULONG *);
+ULONG GP_read_label(GraphParser *);
+ULONG GP_store_label(GraphParser *, Label *, const char *, ULONG);
+void GP_grow_label_cache(GraphParser *);
+int GP_syntax_error(GraphParser *);
+void GP_error(GraphParser *, char *);
+void GP_fatal_error(GraphParser *, char *);
+void GP_add_xp(GraphParser *, ULONG);
+void GP_add_ps(GraphParser *, ULONG);
+void GP_add_vertex(GraphParser *, ULONG, ULONG);
+void GP_add_edge(GraphParser *, BOOLEAN, ULONG, ULONG, ULONG);
 
 #endif
@@ -49,18 +49,20 @@ int main(int argc, char **argv)
    g1 = ReadGraph(argv[1], labelList, directed);
    g2 = ReadGraph(argv[2], labelList, directed);
 
-   if (g1->numVertices < g2->numVertices) 
-   {
+   maxVertices = g1->numVertices;
+   if (g2->numVertices > maxVertices)
       maxVertices = g2->numVertices;
-      mapping = (VertexMap *) malloc(sizeof(VertexMap) * maxVertices);
-      matchCost = InexactGraphMatch(g2, g1, labelList, MAX_DOUBLE, mapping);
-   } 
+   mapping = (VertexMap *) malloc(sizeof(VertexMap) * maxVertices);
+
+   // isomorphic graphs need no search for the cheapest transformation
+   if (ExactGraphMatch(g1, g2, mapping, NULL))
+      matchCost = 0.0;
+   else if (g1->numVertices < g2->numVertices) 
+      matchCost = InexactGraphMatch(g2, g1, labelList, MAX_DOUBLE, mapping,
+                                    NULL);
    else 
-   {
-      maxVertices = g1->numVertices;
-      mapping = (VertexMap *) malloc(sizeof(VertexMap) * maxVertices);
-      matchCost = InexactGraphMatch(g1, g2, labelList, MAX_DOUBLE, mapping);
-   }
+      matchCost = InexactGraphMatch(g1, g2, labelList, MAX_DOUBLE, mapping,
+                                    NULL);
 
 //////////////////////////////////////WFE //////////////////////////////
 // The following is commented out for PLADS - creates too much output
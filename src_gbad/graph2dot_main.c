@@ -82,8 +82,15 @@ Parameters *GetParameters(int argc, char *argv[])
    parameters->labelList = AllocateLabelList();
    parameters->directed = TRUE;
    parameters->posGraph = NULL;
+   parameters->posGraphVertexListSize = 0;
+   parameters->posGraphEdgeListSize = 0;
+   parameters->posGraphStats = NULL;
+   parameters->workspace = AllocateWorkspace();
+   parameters->matchContext = NULL;
    parameters->numPosEgs = 0;
    parameters->posEgsVertexIndices = NULL;
+   parameters->posVertexExamples = NULL;
+   parameters->dotToFile = TRUE;
 
    return parameters;
 }
@@ -103,6 +110,10 @@ void FreeParameters(Parameters *parameters)
 {
    FreeGraph(parameters->posGraph);
    FreeLabelList(parameters->labelList);
+   FreeGraph(parameters->originalPosGraph);
+   FreeLabelList(parameters->originalLabelList);
+   FreeWorkspace(parameters->workspace);
    free(parameters->posEgsVertexIndices);
+   free(parameters->posVertexExamples);
    free(parameters);
 }
@@ -14,10 +14,6 @@
 
 #include "gbad.h"
 
-#define HeapParent(i) ((i - 1) / 2)
-#define HeapLeftChild(i) ((2 * i) + 1)
-#define HeapRightChild(i) ((2 * i) + 2)
-
 
 //******************************************************************************
 // NAME:    GraphMatch
@@ -30,31 +26,50 @@
 //                              ignored if NULL
 //          (VertexMap *mapping) - array to hold final vertex mapping;
 //                                 ignored if NULL
+//          (MatchContext *matchContext) - memory for the matcher; if NULL,
+//                                         a temporary one is used
 //
 // RETURN:  (BOOLEAN) - TRUE is graphs match with cost less than threshold
 //
 // PURPOSE: Returns TRUE if g1 and g2 match with cost less than the given
 // threshold.  If so, side-effects are to store the match cost in the
 // variable pointed to by matchCost and to store the mapping between g1 and
-// g2 in the given mapping input if non-NULL.
+// g2 in the given mapping input if non-NULL.  A zero threshold is handled
+// by ExactGraphMatch.
 //******************************************************************************
 
 BOOLEAN GraphMatch(Graph *g1, Graph *g2, LabelList *labelList,
-                   double threshold, double *matchCost, VertexMap *mapping)
+                   double threshold, double *matchCost, VertexMap *mapping,
+                   MatchContext *matchContext)
 {
    double cost;
 
-   // first, quick check for exact matches
-   if ((threshold == 0.0) &&
-       ((g1->numVertices != g2->numVertices) ||
-        (g1->numEdges != g2->numEdges)))
-      return FALSE;
-
-   // call InexactGraphMatch with larger graph first
-   if (g1->numVertices < g2->numVertices)
-      cost = InexactGraphMatch(g2, g1, labelList, threshold, mapping);
+   // exact matches only need an isomorphism test
+   if (threshold == 0.0)
+   {
+      if (ExactGraphMatch(g1, g2, mapping, matchContext))
+         cost = 0.0;
+      else
+         cost = MAX_DOUBLE;
+   }
+   // call InexactGraphMatch with larger graph first, unless the
+   // fingerprints alone show the cost exceeds the threshold
+   else if (g1->numVertices < g2->numVertices)
+   {
+      if (FingerprintMatchCost(g2, g1) > threshold)
+         cost = MAX_DOUBLE;
+      else
+         cost = InexactGraphMatch(g2, g1, labelList, threshold, mapping,
+                                  matchContext);
+   }
    else 
-      cost = InexactGraphMatch(g1, g2, labelList, threshold, mapping);
+   {
+      if (FingerprintMatchCost(g1, g2) > threshold)
+         cost = MAX_DOUBLE;
+      else
+         cost = InexactGraphMatch(g1, g2, labelList, threshold, mapping,
+                                  matchContext);
+   }
 
    // pass back actual match cost, if desired
    if (matchCost != NULL)
@@ -76,6 +91,8 @@ BOOLEAN GraphMatch(Graph *g1, Graph *g2, LabelList *labelList,
 //          double threshold - upper bound on match cost
 //          (VertexMap *mapping) - array to hold final vertex mapping;
 //                                 if NULL, then ignored
+//          (MatchContext *matchContext) - memory for the matcher; if NULL,
+//                                         a temporary one is used
 //
 // RETURN:  Cost of transforming g1 into an isomorphism of g2.  Will be
 //          MAX_DOUBLE if cost exceeds threshold
@@ -84,73 +101,97 @@ BOOLEAN GraphMatch(Graph *g1, Graph *g2, LabelList *labelList,
 // isomorphism of g2, but any match cost exceeding the given threshold
 // is not considerd.  Graph g1 should be the larger graph in terms of
 // vertices.  A side-effect is to store the mapping between g1 and g2
-// in the given mapping input if non-NULL.
+// in the given mapping input if non-NULL.  Partial mappings are searched
+// in order of their cost plus a lower bound on the cost of completing
+// them (see MatchBoundCost), and are pruned once this exceeds the
+// threshold or the best complete mapping found so far.  Each partial
+// mapping is stored as its last vertex map in the context's maps, linked
+// to the partial mapping it extends, so the maps of all partial mappings
+// searched share their common prefixes.
+//
+// Once more than MaximumNodes partial mappings have been expanded, the
+// search turns greedy: CompressMatchHeap keeps only some of the queued
+// partial mappings, and each is then extended by its best child alone, so
+// the cost returned may exceed the minimum.  The bound changes both which
+// partial mappings are queued at that point and which child is best, so
+// the greedy search may end with a higher or a lower cost than it would
+// ordering partial mappings by cost alone.
 //
 // TODO: May want to input a partial mapping to influence mapping
 // order of vertices in g1.
 //******************************************************************************
 
 double InexactGraphMatch(Graph *g1, Graph *g2, LabelList *labelList,
-                         double threshold, VertexMap *mapping)
+                         double threshold, VertexMap *mapping,
+                         MatchContext *matchContext)
 {
    ULONG i, v1, v2;
+   ULONG map;
+   ULONG bestChildV2 = 0;
    ULONG nv1 = g1->numVertices;
    ULONG nv2 = g2->numVertices;
    Edge *edge;
-   MatchHeap *globalQueue = NULL;
-   MatchHeap *localQueue = NULL;
+   MatchContext *context;
+   MatchHeap *queue;
+   MatchMap *maps;
    MatchHeapNode node;
    MatchHeapNode newNode;
+   MatchHeapNode bestChild;
    MatchHeapNode bestNode;
    double cost = 0.0;
    double newCost = 0.0;
+   double newBound = 0.0;
    ULONG numNodes = 0;
    ULONG quickMatchThreshold = 0;
    BOOLEAN quickMatch = FALSE;
    BOOLEAN done = FALSE;
-   ULONG *orderedVertices = NULL;
-   ULONG *mapped1 = NULL; // mapping of vertices in g1 to vertices in g2
-   ULONG *mapped2 = NULL; // mapping of vertices in g2 to vertices in g1
+   ULONG *orderedVertices;
+   ULONG *mapped1; // mapping of vertices in g1 to vertices in g2
+   ULONG *mapped2; // mapping of vertices in g2 to vertices in g1
+   MatchBound *matchBound;
+
+   context = matchContext;
+   if (context == NULL)
+      context = AllocateMatchContext();
+   SizeMatchContext(context, g1, g2);
+   // vertices of g1 ordered by degree
+   orderedVertices = GetGraphFingerprint(g1)->orderedVertices;
+   mapped1 = context->mapped1;
+   mapped2 = context->mapped2;
+   matchBound = context->matchBound;
+   queue = context->queue;
+   ClearMatchHeap(queue);
+   context->numMaps = 0;
+   for (i = 0; i < g2->numEdges; i++)
+      context->edgeUsed[i] = FALSE;
 
    // Compute threshold on mappings tried before changing from optimal
    // search to greedy search
    quickMatchThreshold = MaximumNodes(nv1);
 
-   // Order vertices of g1 by degree
-   orderedVertices = (ULONG *) malloc(sizeof(ULONG) * nv1);
-   if (orderedVertices == NULL)
-      OutOfMemoryError("orderedVertices");
-   OrderVerticesByDegree(g1, orderedVertices);
-
-   // Allocate arrays holding vertex maps from g1 to g2 and g2 to g1
-   mapped1 = (ULONG *) malloc(sizeof(ULONG) * nv1);
-   if (mapped1 == NULL)
-      OutOfMemoryError("mapped1");
-   mapped2 = (ULONG *) malloc(sizeof(ULONG) * nv2);
-   if (mapped2 == NULL)
-      OutOfMemoryError("mapped2");
-
-   globalQueue = AllocateMatchHeap(nv1 * nv1);
-   localQueue = AllocateMatchHeap(nv1);
+   SetMatchBoundLabels(matchBound, g1, g2);
+
    node.depth = 0;
    node.cost = 0.0;
-   node.mapping = NULL;
-   InsertMatchHeapNode(& node, globalQueue);
+   node.bound = 0.0;
+   node.map = NO_MATCH_MAP;
+   InsertMatchHeapNode(& node, queue);
    bestNode.depth = 0;
    bestNode.cost = MAX_DOUBLE;
-   bestNode.mapping = NULL;
+   bestNode.bound = MAX_DOUBLE;
+   bestNode.map = NO_MATCH_MAP;
 
-   while ((! MatchHeapEmpty(globalQueue)) && (! done)) 
+   while ((! MatchHeapEmpty(queue)) && (! done)) 
    {
-      ExtractMatchHeapNode(globalQueue, & node);
-      if (node.cost < bestNode.cost) 
+      ExtractMatchHeapNode(queue, & node);
+      if (node.bound < bestNode.cost) 
       {
          if (node.depth == nv1) 
          {   // complete mapping found
-            free(bestNode.mapping);
             bestNode.cost = node.cost;
+            bestNode.bound = node.bound;
             bestNode.depth = node.depth;
-            bestNode.mapping = node.mapping;
+            bestNode.map = node.map;
             if (! quickMatch)
                done = TRUE;
          } 
@@ -161,13 +202,17 @@ double InexactGraphMatch(Graph *g1, Graph *g2, LabelList *labelList,
                mapped1[i] = VERTEX_UNMAPPED;
             for (i = 0; i < nv2; i++)
                mapped2[i] = VERTEX_UNMAPPED;
-            for (i = 0; i < node.depth; i++) 
+            maps = context->maps;
+            for (map = node.map; map != NO_MATCH_MAP; map = maps[map].parent)
             {
-               mapped1[node.mapping[i].v1] = node.mapping[i].v2;
-               if (node.mapping[i].v2 != VERTEX_DELETED)
-                  mapped2[node.mapping[i].v2] = node.mapping[i].v1;
+               mapped1[maps[map].v1] = maps[map].v2;
+               if (maps[map].v2 != VERTEX_DELETED)
+                  mapped2[maps[map].v2] = maps[map].v1;
             }
+            InitMatchBound(matchBound, g1, g2, mapped1, mapped2);
             v1 = orderedVertices[node.depth];
+            newNode.depth = node.depth + 1;
+            bestChild.depth = 0; // no child yet
             // first, try mapping v1 to nothing
             newCost = node.cost + DELETE_VERTEX_COST;
             if ((newCost <= threshold) && (newCost < bestNode.cost)) 
@@ -195,15 +240,28 @@ double InexactGraphMatch(Graph *g1, Graph *g2, LabelList *labelList,
                   newCost += cost;
                }
             }
-            if ((newCost <= threshold) && (newCost < bestNode.cost)) 
+            // add lower bound on cost of completing mapping
+            newBound = newCost;
+            if ((newCost <= threshold) && (newCost < bestNode.cost) &&
+                (node.depth < (nv1 - 1)))
+               newBound += MatchBoundCost(matchBound, g1, g2, v1,
+                                          VERTEX_DELETED, mapped1, mapped2);
+            if ((newBound <= threshold) && (newBound < bestNode.cost)) 
             {
-               // add new node to local queue
-               newNode.depth = node.depth + 1;
                newNode.cost = newCost;
-               newNode.mapping =
-                  AllocateNewMapping(node.depth + 1, node.mapping, v1,
-                                     VERTEX_DELETED);
-               InsertMatchHeapNode(& newNode, localQueue);
+               newNode.bound = newBound;
+               if (quickMatch)
+               {
+                  bestChild = newNode;
+                  bestChildV2 = VERTEX_DELETED;
+               }
+               else
+               {
+                  // add new node to queue
+                  newNode.map = AddMatchMap(context, v1, VERTEX_DELETED,
+                                            node.map);
+                  InsertMatchHeapNode(& newNode, queue);
+               }
             }
             // second, try mapping v1 to each unmapped vertex in g2
             for (v2 = 0; v2 < nv2; v2++) 
@@ -218,9 +276,11 @@ double InexactGraphMatch(Graph *g1, Graph *g2, LabelList *labelList,
                                       g2->vertices[v2].label, labelList);
                   if ((newCost <= threshold) && (newCost < bestNode.cost)) 
                   {
-                     cost = DeletedEdgesCost(g1,g2,v1,v2,mapped1,labelList);
+                     cost = DeletedEdgesCost(g1, g2, v1, v2, mapped1,
+                                             labelList, context->edgeUsed);
                      newCost += cost;
-                     cost = InsertedEdgesCost(g2, v2, mapped2);
+                     cost = InsertedEdgesCost(g2, v2, mapped2,
+                                              context->edgeUsed);
                      newCost += cost;
                   }
                   // if complete mapping, add cost for any unmapped vertices
@@ -233,72 +293,623 @@ double InexactGraphMatch(Graph *g1, Graph *g2, LabelList *labelList,
                         newCost += cost;
                      }
                   }
-                  if ((newCost <= threshold) && (newCost < bestNode.cost)) 
+                  // add lower bound on cost of completing mapping
+                  newBound = newCost;
+                  if ((newCost <= threshold) && (newCost < bestNode.cost) &&
+                      (node.depth < (nv1 - 1)))
+                     newBound += MatchBoundCost(matchBound, g1, g2, v1, v2,
+                                                mapped1, mapped2);
+                  if ((newBound <= threshold) && (newBound < bestNode.cost)) 
                   {
-                     // add new node to local queue
-                     newNode.depth = node.depth + 1;
                      newNode.cost = newCost;
-                     newNode.mapping = 
-                        AllocateNewMapping(node.depth + 1,node.mapping,v1,v2);
-                     InsertMatchHeapNode(& newNode, localQueue);
+                     newNode.bound = newBound;
+                     if (quickMatch)
+                     {
+                        // keep only the best child for greedy search
+                        if ((bestChild.depth == 0) ||
+                            (newNode.bound < bestChild.bound))
+                        {
+                           bestChild = newNode;
+                           bestChildV2 = v2;
+                        }
+                     }
+                     else
+                     {
+                        // add new node to queue
+                        newNode.map = AddMatchMap(context, v1, v2, node.map);
+                        InsertMatchHeapNode(& newNode, queue);
+                     }
                   }
                   mapped1[v1] = VERTEX_UNMAPPED;
                   mapped2[v2] = VERTEX_UNMAPPED;
                }
             }
-            free(node.mapping);
-            // Add nodes in localQueue to globalQueue
-            if (quickMatch) 
+            if (bestChild.depth > 0)
             {
-               if (! MatchHeapEmpty(localQueue)) 
-               {
-                  ExtractMatchHeapNode(localQueue, & node);
-                  InsertMatchHeapNode(& node, globalQueue);
-                  ClearMatchHeap(localQueue);
-               }
-            } 
-            else 
-               MergeMatchHeaps(localQueue, globalQueue); // clears localQueue
+               bestChild.map = AddMatchMap(context, v1, bestChildV2, node.map);
+               InsertMatchHeapNode(& bestChild, queue);
+            }
          }
       } 
-      else 
-         free(node.mapping);
 
       // check if maximum nodes exceeded, and if so, switch to greedy search
       numNodes++;
       if ((! quickMatch) && (numNodes > quickMatchThreshold)) 
       {
-         CompressMatchHeap(globalQueue, nv1);
+         CompressMatchHeap(queue, nv1);
          quickMatch = TRUE;
       }
    } // end while
 
    // copy best mapping to input mapping array, if available
-   if ((mapping != NULL) && (bestNode.mapping != NULL))
-      for (i = 0; i < nv1; i++) 
+   if ((mapping != NULL) && (bestNode.map != NO_MATCH_MAP))
+   {
+      maps = context->maps;
+      i = nv1;
+      for (map = bestNode.map; map != NO_MATCH_MAP; map = maps[map].parent)
       {
-         mapping[i].v1 = bestNode.mapping[i].v1;
-         mapping[i].v2 = bestNode.mapping[i].v2;
+         i--;
+         mapping[i].v1 = maps[map].v1;
+         mapping[i].v2 = maps[map].v2;
       }
+   }
 
-   // free memory
-   free(bestNode.mapping);
-   FreeMatchHeap(localQueue);
-   FreeMatchHeap(globalQueue);
-   free(mapped2);
-   free(mapped1);
-   free(orderedVertices);
+   if (matchContext == NULL)
+      FreeMatchContext(context);
 
    return bestNode.cost;
 }
 
 
+//******************************************************************************
+// NAME:    AllocateMatchContext
+//
+// INPUTS:  (void)
+//
+// RETURN:  (MatchContext *) - empty match context
+//
+// PURPOSE: Allocate the memory used by InexactGraphMatch; its arrays are
+// sized by SizeMatchContext and grow as needed.
+//******************************************************************************
+
+MatchContext *AllocateMatchContext(void)
+{
+   MatchContext *context;
+
+   context = (MatchContext *) malloc(sizeof(MatchContext));
+   if (context == NULL)
+      OutOfMemoryError("AllocateMatchContext:context");
+   context->vertexListSize = 0;
+   context->orderedVertices = NULL;
+   context->vertexDegree = NULL;
+   context->mapped1 = NULL;
+   context->mapped2 = NULL;
+   context->anchor = NULL;
+   context->nextCandidate = NULL;
+   context->inDegree1 = NULL;
+   context->outDegree1 = NULL;
+   context->inDegree2 = NULL;
+   context->outDegree2 = NULL;
+   context->edgeListSize = 0;
+   context->edgeUsed = NULL;
+   context->mapListSize = 0;
+   context->numMaps = 0;
+   context->maps = NULL;
+   context->queue = AllocateMatchHeap(LIST_SIZE_INC);
+   context->matchBound = AllocateMatchBound();
+   context->instanceGraph = AllocateGraph(0, 0);
+   context->instanceVertexListSize = 0;
+   context->instanceEdgeListSize = 0;
+   context->instanceEdgeLists = NULL;
+   return context;
+}
+
+
+//******************************************************************************
+// NAME:    SizeMatchContext
+//
+// INPUTS:  (MatchContext *context) - match context to be sized
+//          (Graph *g1)
+//          (Graph *g2) - graphs to be matched
+//
+// RETURN:  void
+//
+// PURPOSE: Make sure the arrays of the match context have room for the
+// vertices of both graphs and the edges of g2.
+//******************************************************************************
+
+void SizeMatchContext(MatchContext *context, Graph *g1, Graph *g2)
+{
+   ULONG size;
+
+   size = g1->numVertices;
+   if (g2->numVertices > size)
+      size = g2->numVertices;
+   if (size > context->vertexListSize)
+   {
+      context->orderedVertices = (ULONG *)
+         realloc(context->orderedVertices, sizeof(ULONG) * size);
+      context->vertexDegree = (ULONG *)
+         realloc(context->vertexDegree, sizeof(ULONG) * size);
+      context->mapped1 = (ULONG *)
+         realloc(context->mapped1, sizeof(ULONG) * size);
+      context->mapped2 = (ULONG *)
+         realloc(context->mapped2, sizeof(ULONG) * size);
+      context->anchor = (ULONG *)
+         realloc(context->anchor, sizeof(ULONG) * size);
+      context->nextCandidate = (ULONG *)
+         realloc(context->nextCandidate, sizeof(ULONG) * size);
+      context->inDegree1 = (ULONG *)
+         realloc(context->inDegree1, sizeof(ULONG) * size);
+      context->outDegree1 = (ULONG *)
+         realloc(context->outDegree1, sizeof(ULONG) * size);
+      context->inDegree2 = (ULONG *)
+         realloc(context->inDegree2, sizeof(ULONG) * size);
+      context->outDegree2 = (ULONG *)
+         realloc(context->outDegree2, sizeof(ULONG) * size);
+      if ((context->orderedVertices == NULL) ||
+          (context->vertexDegree == NULL) ||
+          (context->mapped1 == NULL) || (context->mapped2 == NULL) ||
+          (context->anchor == NULL) || (context->nextCandidate == NULL) ||
+          (context->inDegree1 == NULL) || (context->outDegree1 == NULL) ||
+          (context->inDegree2 == NULL) || (context->outDegree2 == NULL))
+         OutOfMemoryError("SizeMatchContext:mapped1");
+      context->vertexListSize = size;
+   }
+   if (g2->numEdges > context->edgeListSize)
+   {
+      context->edgeUsed = (BOOLEAN *)
+         realloc(context->edgeUsed, sizeof(BOOLEAN) * g2->numEdges);
+      if (context->edgeUsed == NULL)
+         OutOfMemoryError("SizeMatchContext:edgeUsed");
+      context->edgeListSize = g2->numEdges;
+   }
+}
+
+
+//******************************************************************************
+// NAME:    AddMatchMap
+//
+// INPUTS:  (MatchContext *context) - match context holding vertex maps
+//          (ULONG v1)
+//          (ULONG v2) - new vertex map v1 -> v2
+//          (ULONG parent) - last vertex map of mapping being extended
+//
+// RETURN:  (ULONG) - index of new vertex map
+//
+// PURPOSE: Store the partial mapping that extends the one ending in parent
+// by v1 -> v2.
+//******************************************************************************
+
+ULONG AddMatchMap(MatchContext *context, ULONG v1, ULONG v2, ULONG parent)
+{
+   ULONG map;
+
+   if (context->numMaps == context->mapListSize)
+   {
+      context->mapListSize += LIST_SIZE_INC + context->mapListSize;
+      context->maps = (MatchMap *)
+         realloc(context->maps, sizeof(MatchMap) * context->mapListSize);
+      if (context->maps == NULL)
+         OutOfMemoryError("AddMatchMap:context->maps");
+   }
+   map = context->numMaps;
+   context->maps[map].v1 = v1;
+   context->maps[map].v2 = v2;
+   context->maps[map].parent = parent;
+   context->numMaps++;
+   return map;
+}
+
+
+//******************************************************************************
+// NAME:    FreeMatchContext
+//
+// INPUTS:  (MatchContext *context) - match context to be freed
+//
+// RETURN:  void
+//
+// PURPOSE: Free memory used by match context.
+//******************************************************************************
+
+void FreeMatchContext(MatchContext *context)
+{
+   if (context != NULL)
+   {
+      free(context->orderedVertices);
+      free(context->vertexDegree);
+      free(context->mapped1);
+      free(context->mapped2);
+      free(context->anchor);
+      free(context->nextCandidate);
+      free(context->inDegree1);
+      free(context->outDegree1);
+      free(context->inDegree2);
+      free(context->outDegree2);
+      free(context->edgeUsed);
+      free(context->maps);
+      FreeMatchHeap(context->queue);
+      FreeMatchBound(context->matchBound);
+      // instanceGraph edge lists live in instanceEdgeLists, so FreeGraph
+      // cannot be used
+      FreeGraphFingerprint(context->instanceGraph);
+      free(context->instanceGraph->vertices);
+      free(context->instanceGraph->edges);
+      free(context->instanceGraph);
+      free(context->instanceEdgeLists);
+      free(context);
+   }
+}
+
+
+//******************************************************************************
+// NAME:    ExactGraphMatch
+//
+// INPUTS:  (Graph *g1)
+//          (Graph *g2) - graphs to be matched
+//          (VertexMap *mapping) - array to hold final vertex mapping;
+//                                 ignored if NULL
+//          (MatchContext *matchContext) - memory for the matcher; if NULL,
+//                                         a temporary one is used
+//
+// RETURN:  (BOOLEAN) - TRUE if g1 and g2 are isomorphic
+//
+// PURPOSE: Test whether g1 and g2 match with zero cost, i.e., whether
+// there is a one-to-one mapping of their vertices preserving vertex
+// labels and the labels, directedness and direction of all edges.  The
+// graphs are first compared by fingerprint (see SameGraphFingerprint);
+// then the vertices of g1 are mapped one at a time in depth-first order
+// (see OrderVerticesForExactMatch), trying only vertices of g2 with the
+// same label and degrees that are adjacent to the image of an earlier
+// neighbor, and backtracking as soon as the edges to already mapped
+// vertices differ.  A side-effect is to store the mapping between g1 and
+// g2 in the given mapping input if non-NULL and the graphs match.
+//******************************************************************************
+
+BOOLEAN ExactGraphMatch(Graph *g1, Graph *g2, VertexMap *mapping,
+                        MatchContext *matchContext)
+{
+   ULONG i;
+   ULONG depth;
+   ULONG v1, v2;
+   ULONG nv = g1->numVertices;
+   Edge *edge;
+   MatchContext *context;
+   MatchBound *matchBound;
+   BOOLEAN match = TRUE;
+   BOOLEAN found;
+
+   if (! SameGraphFingerprint(g1, g2))
+      return FALSE;
+
+   context = matchContext;
+   if (context == NULL)
+      context = AllocateMatchContext();
+   SizeMatchContext(context, g1, g2);
+   matchBound = context->matchBound;
+
+   // count vertices with each label, used for ordering vertices
+   SetMatchBoundLabels(matchBound, g1, g2);
+   for (i = 0; i < matchBound->numLabels; i++)
+      matchBound->vertexCount1[i] = 0;
+   for (i = 0; i < nv; i++)
+      matchBound->vertexCount1[matchBound->vertexLabels1[i]]++;
+
+   // count directed edges into and out of each vertex
+   for (i = 0; i < nv; i++)
+   {
+      context->inDegree1[i] = 0;
+      context->outDegree1[i] = 0;
+      context->inDegree2[i] = 0;
+      context->outDegree2[i] = 0;
+   }
+   for (i = 0; i < g1->numEdges; i++)
+   {
+      edge = & g1->edges[i];
+      if (edge->directed && (edge->vertex1 != edge->vertex2))
+      {
+         context->outDegree1[edge->vertex1]++;
+         context->inDegree1[edge->vertex2]++;
+      }
+      edge = & g2->edges[i];
+      if (edge->directed && (edge->vertex1 != edge->vertex2))
+      {
+         context->outDegree2[edge->vertex1]++;
+         context->inDegree2[edge->vertex2]++;
+      }
+   }
+
+   OrderVerticesForExactMatch(g1, context);
+   for (i = 0; i < nv; i++)
+   {
+      context->mapped1[i] = VERTEX_UNMAPPED;
+      context->mapped2[i] = VERTEX_UNMAPPED;
+   }
+   for (i = 0; i < g2->numEdges; i++)
+      context->edgeUsed[i] = FALSE;
+
+   // depth-first search for a mapping
+   depth = 0;
+   if (nv > 0)
+      context->nextCandidate[0] = 0;
+   while (match && (depth < nv))
+   {
+      v1 = context->orderedVertices[depth];
+      found = FALSE;
+      v2 = NextExactMatchCandidate(g1, g2, depth, context);
+      while ((! found) && (v2 != VERTEX_UNMAPPED))
+      {
+         if (ExactMatchFeasible(g1, g2, v1, v2, context))
+            found = TRUE;
+         else
+            v2 = NextExactMatchCandidate(g1, g2, depth, context);
+      }
+      if (found)
+      {
+         context->mapped1[v1] = v2;
+         context->mapped2[v2] = v1;
+         depth++;
+         if (depth < nv)
+            context->nextCandidate[depth] = 0;
+      }
+      else if (depth == 0)
+         match = FALSE;
+      else
+      {
+         // backtrack, and try next candidate for previous vertex
+         depth--;
+         v1 = context->orderedVertices[depth];
+         context->mapped2[context->mapped1[v1]] = VERTEX_UNMAPPED;
+         context->mapped1[v1] = VERTEX_UNMAPPED;
+      }
+   }
+
+   // copy mapping to input mapping array, if available
+   if (match && (mapping != NULL))
+      for (i = 0; i < nv; i++)
+      {
+         mapping[i].v1 = context->orderedVertices[i];
+         mapping[i].v2 = context->mapped1[context->orderedVertices[i]];
+      }
+
+   if (matchContext == NULL)
+      FreeMatchContext(context);
+
+   return match;
+}
+
+
+//******************************************************************************
+// NAME:    OrderVerticesForExactMatch
+//
+// INPUTS:  (Graph *g) - graph whose vertices are to be ordered
+//          (MatchContext *context) - context in which to store the order;
+//                                    the label counts of g must be set
+//
+// RETURN:  (void)
+//
+// PURPOSE: Compute the order in which ExactGraphMatch maps the vertices
+// of g.  Each next vertex is the one with the most edges to vertices
+// already ordered, then the one whose label is rarest, then the one of
+// highest degree, so that candidates are constrained as early as
+// possible.  Also stores for each vertex an earlier neighbor (its anchor),
+// if any, whose image limits the candidates for the vertex.
+//******************************************************************************
+
+void OrderVerticesForExactMatch(Graph *g, MatchContext *context)
+{
+   ULONG nv = g->numVertices;
+   ULONG i, e;
+   ULONG depth;
+   ULONG v, best;
+   ULONG otherVertex;
+   Edge *edge;
+   ULONG *numOrderedNeighbors = context->vertexDegree;
+   ULONG *position = context->nextCandidate; // reset by ExactGraphMatch
+   ULONG *labelCount = context->matchBound->vertexCount1;
+   ULONG *vertexLabels = context->matchBound->vertexLabels1;
+
+   for (i = 0; i < nv; i++)
+   {
+      numOrderedNeighbors[i] = 0;
+      position[i] = VERTEX_UNMAPPED;
+   }
+   for (depth = 0; depth < nv; depth++)
+   {
+      best = VERTEX_UNMAPPED;
+      for (v = 0; v < nv; v++)
+         if ((position[v] == VERTEX_UNMAPPED) &&
+             ((best == VERTEX_UNMAPPED) ||
+              (numOrderedNeighbors[v] > numOrderedNeighbors[best]) ||
+              ((numOrderedNeighbors[v] == numOrderedNeighbors[best]) &&
+               ((labelCount[vertexLabels[v]] <
+                 labelCount[vertexLabels[best]]) ||
+                ((labelCount[vertexLabels[v]] ==
+                  labelCount[vertexLabels[best]]) &&
+                 (g->vertices[v].numEdges > g->vertices[best].numEdges))))))
+            best = v;
+      context->orderedVertices[depth] = best;
+      context->anchor[depth] = VERTEX_UNMAPPED;
+      position[best] = depth;
+      for (e = 0; e < g->vertices[best].numEdges; e++)
+      {
+         edge = & g->edges[g->vertices[best].edges[e]];
+         otherVertex = (edge->vertex1 == best) ? edge->vertex2 : edge->vertex1;
+         if (position[otherVertex] == VERTEX_UNMAPPED)
+            numOrderedNeighbors[otherVertex]++;
+         else if ((otherVertex != best) &&
+                  (context->anchor[depth] == VERTEX_UNMAPPED))
+            context->anchor[depth] = otherVertex;
+      }
+   }
+}
+
+
+//******************************************************************************
+// NAME:    NextExactMatchCandidate
+//
+// INPUTS:  (Graph *g1)
+//          (Graph *g2) - graphs being matched
+//          (ULONG depth) - position of vertex of g1 in mapping order
+//          (MatchContext *context) - state of ExactGraphMatch
+//
+// RETURN:  (ULONG) - next vertex of g2 to try for the vertex of g1, or
+//                    VERTEX_UNMAPPED if none left
+//
+// PURPOSE: Step through the candidates for the vertex at the given depth.
+// If the vertex has an anchor, only the neighbors of the anchor's image
+// are tried, each once; otherwise all vertices of g2.  Candidates must be
+// unmapped and agree with the vertex in label, degree, and numbers of
+// incoming and outgoing directed edges.
+//******************************************************************************
+
+ULONG NextExactMatchCandidate(Graph *g1, Graph *g2, ULONG depth,
+                              MatchContext *context)
+{
+   ULONG v1 = context->orderedVertices[depth];
+   ULONG anchor2;
+   ULONG e, k;
+   ULONG v2, otherVertex;
+   Vertex *vertex;
+   Edge *edge;
+   BOOLEAN seen;
+
+   if (context->anchor[depth] != VERTEX_UNMAPPED)
+   {
+      anchor2 = context->mapped1[context->anchor[depth]];
+      vertex = & g2->vertices[anchor2];
+      while (context->nextCandidate[depth] < vertex->numEdges)
+      {
+         e = context->nextCandidate[depth]++;
+         edge = & g2->edges[vertex->edges[e]];
+         v2 = (edge->vertex1 == anchor2) ? edge->vertex2 : edge->vertex1;
+         // skip neighbors already tried through a parallel edge
+         seen = FALSE;
+         for (k = 0; (k < e) && (! seen); k++)
+         {
+            edge = & g2->edges[vertex->edges[k]];
+            otherVertex =
+               (edge->vertex1 == anchor2) ? edge->vertex2 : edge->vertex1;
+            if (otherVertex == v2)
+               seen = TRUE;
+         }
+         if ((! seen) &&
+             (context->mapped2[v2] == VERTEX_UNMAPPED) &&
+             (g2->vertices[v2].label == g1->vertices[v1].label) &&
+             (g2->vertices[v2].numEdges == g1->vertices[v1].numEdges) &&
+             (context->inDegree2[v2] == context->inDegree1[v1]) &&
+             (context->outDegree2[v2] == context->outDegree1[v1]))
+            return v2;
+      }
+   }
+   else
+   {
+      while (context->nextCandidate[depth] < g2->numVertices)
+      {
+         v2 = context->nextCandidate[depth]++;
+         if ((context->mapped2[v2] == VERTEX_UNMAPPED) &&
+             (g2->vertices[v2].label == g1->vertices[v1].label) &&
+             (g2->vertices[v2].numEdges == g1->vertices[v1].numEdges) &&
+             (context->inDegree2[v2] == context->inDegree1[v1]) &&
+             (context->outDegree2[v2] == context->outDegree1[v1]))
+            return v2;
+      }
+   }
+   return VERTEX_UNMAPPED;
+}
+
+
+//******************************************************************************
+// NAME:    ExactMatchFeasible
+//
+// INPUTS:  (Graph *g1)
+//          (Graph *g2) - graphs being matched
+//          (ULONG v1) - vertex of g1 being mapped
+//          (ULONG v2) - candidate vertex of g2
+//          (MatchContext *context) - state of ExactGraphMatch
+//
+// RETURN:  (BOOLEAN) - TRUE if v1 -> v2 can extend the current mapping
+//
+// PURPOSE: Check that the edges between v1 and the mapped vertices of g1
+// (and its self edges) correspond one-to-one to the edges between v2 and
+// their images (and its self edges), with equal labels, directedness and
+// direction.
+//******************************************************************************
+
+BOOLEAN ExactMatchFeasible(Graph *g1, Graph *g2, ULONG v1, ULONG v2,
+                           MatchContext *context)
+{
+   ULONG e1, e2;
+   ULONG otherVertex1, otherVertex2;
+   ULONG numEdges1 = 0;
+   ULONG numEdges2 = 0;
+   Edge *edge1, *edge2;
+   BOOLEAN forward, backward;
+   BOOLEAN found;
+   BOOLEAN feasible = TRUE;
+
+   // match each edge of v1 to a mapped vertex with an unused edge of v2
+   for (e1 = 0; (e1 < g1->vertices[v1].numEdges) && feasible; e1++)
+   {
+      edge1 = & g1->edges[g1->vertices[v1].edges[e1]];
+      otherVertex1 = (edge1->vertex1 == v1) ? edge1->vertex2 : edge1->vertex1;
+      if ((otherVertex1 == v1) ||
+          (context->mapped1[otherVertex1] != VERTEX_UNMAPPED))
+      {
+         numEdges1++;
+         if (otherVertex1 == v1)
+            otherVertex2 = v2;
+         else
+            otherVertex2 = context->mapped1[otherVertex1];
+         found = FALSE;
+         for (e2 = 0; (e2 < g2->vertices[v2].numEdges) && (! found); e2++)
+         {
+            edge2 = & g2->edges[g2->vertices[v2].edges[e2]];
+            forward = ((edge2->vertex1 == v2) &&
+                       (edge2->vertex2 == otherVertex2));
+            backward = ((edge2->vertex1 == otherVertex2) &&
+                        (edge2->vertex2 == v2));
+            if ((! context->edgeUsed[g2->vertices[v2].edges[e2]]) &&
+                (edge2->label == edge1->label) &&
+                (edge2->directed == edge1->directed) &&
+                (((! edge1->directed) && (forward || backward)) ||
+                 (edge1->directed && (edge1->vertex1 == v1) && forward) ||
+                 (edge1->directed && (edge1->vertex1 != v1) && backward)))
+            {
+               context->edgeUsed[g2->vertices[v2].edges[e2]] = TRUE;
+               found = TRUE;
+            }
+         }
+         if (! found)
+            feasible = FALSE;
+      }
+   }
+
+   // v2 must have no other edges to mapped vertices; reset used edges
+   for (e2 = 0; e2 < g2->vertices[v2].numEdges; e2++)
+   {
+      edge2 = & g2->edges[g2->vertices[v2].edges[e2]];
+      otherVertex2 = (edge2->vertex1 == v2) ? edge2->vertex2 : edge2->vertex1;
+      if ((otherVertex2 == v2) ||
+          (context->mapped2[otherVertex2] != VERTEX_UNMAPPED))
+         numEdges2++;
+      context->edgeUsed[g2->vertices[v2].edges[e2]] = FALSE;
+   }
+   if (numEdges1 != numEdges2)
+      feasible = FALSE;
+
+   return feasible;
+}
+
+
 //******************************************************************************
 // NAME: OrderVerticesByDegree
 //
 // INPUTS: (Graph *g) - graph whose vertices are to be sorted by degree
 //         (ULONG *orderedVertices) - array to hold vertex indices
 //                                    sorted by degree
+//         (ULONG *vertexDegree) - array of room for the degree of each
+//                                 vertex, used while sorting
 //
 // RETURN: (void)
 //
@@ -307,16 +918,12 @@ double InexactGraphMatch(Graph *g1, Graph *g2, LabelList *labelList,
 // first will speed up the match.
 //******************************************************************************
 
-void OrderVerticesByDegree(Graph *g, ULONG *orderedVertices)
+void OrderVerticesByDegree(Graph *g, ULONG *orderedVertices,
+                           ULONG *vertexDegree)
 {
    ULONG nv = g->numVertices;
    ULONG i, j;
    ULONG degree;
-   ULONG *vertexDegree = NULL;
-
-   vertexDegree = (ULONG *) malloc(sizeof(ULONG) * nv);
-   if (vertexDegree == NULL)
-      OutOfMemoryError("vertexDegree");
 
    // insertion sort vertices by degree
    for (i = 0; i < nv; i++) 
@@ -332,7 +939,6 @@ void OrderVerticesByDegree(Graph *g, ULONG *orderedVertices)
       vertexDegree[j] = degree;
       orderedVertices[j] = i;
    }
-   free(vertexDegree);
 }
 
 
@@ -367,24 +973,27 @@ ULONG MaximumNodes(ULONG n)
 //         (ULONG v2) - vertex in g2 being mapped
 //         (ULONG *mapped1) - mapping of vertices in g1 to vertices in g2
 //         (LabelList *labelList) - label list containing labels for g1 and g2
+//         (BOOLEAN *edgeUsed) - marks on edges of g2 already matched
 //
 // RETURN: (double) - cost of match edges according to given mapping
 //
 // PURPOSE: Compute the cost of matching edges involved in the new
 // mapping, which has just added v1 -> v2.  In the case of multiple
 // edges between two vertices, do a greedy search to find a low-cost
-// mapping of edges to edges.
+// mapping of edges to edges.  Edges of g2 are marked in edgeUsed rather
+// than by their used flags, so g2 is not written to.
 //
 // NOTE: Assumes InsertedEdgesCost() run right after this one.
 //******************************************************************************
 
 double DeletedEdgesCost(Graph *g1, Graph *g2, ULONG v1, ULONG v2,
-                        ULONG *mapped1, LabelList *labelList)
+                        ULONG *mapped1, LabelList *labelList,
+                        BOOLEAN *edgeUsed)
 {
    ULONG e1, e2;
    Edge *edge1, *edge2;
    ULONG otherVertex1, otherVertex2;
-   Edge *bestMatchEdge;
+   ULONG bestMatchEdge;
    double bestMatchCost;
    double matchCost;
    double totalCost = 0.0;
@@ -401,13 +1010,13 @@ double DeletedEdgesCost(Graph *g1, Graph *g2, ULONG v1, ULONG v2,
           (mapped1[otherVertex1] != VERTEX_DELETED)) 
       {
          // target vertex of edge also mapped
-         bestMatchEdge = NULL;
+         bestMatchEdge = MAX_UNSIGNED_LONG; // none
          bestMatchCost = -1.0;
          otherVertex2 = mapped1[otherVertex1];
          for (e2 = 0; e2 < g2->vertices[v2].numEdges; e2++) 
          {
             edge2 = & g2->edges[g2->vertices[v2].edges[e2]];
-            if ((! edge2->used) &&
+            if ((! edgeUsed[g2->vertices[v2].edges[e2]]) &&
                 (((edge2->vertex1 == otherVertex2) && (edge2->vertex2 == v2)) ||
                 ((edge2->vertex1 == v2) && (edge2->vertex2 == otherVertex2)))) 
             {
@@ -427,15 +1036,15 @@ double DeletedEdgesCost(Graph *g1, Graph *g2, ULONG v1, ULONG v2,
                if ((matchCost < bestMatchCost) || (bestMatchCost < 0.0)) 
                {
                   bestMatchCost = matchCost;
-                  bestMatchEdge = edge2;
+                  bestMatchEdge = g2->vertices[v2].edges[e2];
                }
             }
          }
          // if matching edge found, then add cost of match and mark edge used;
          // else add cost of deleting edge from g1
-         if (bestMatchEdge != NULL) 
+         if (bestMatchEdge != MAX_UNSIGNED_LONG) 
          {
-            bestMatchEdge->used = TRUE;
+            edgeUsed[bestMatchEdge] = TRUE;
             totalCost += bestMatchCost;
          } 
          else 
@@ -452,6 +1061,8 @@ double DeletedEdgesCost(Graph *g1, Graph *g2, ULONG v1, ULONG v2,
 // INPUTS: (Graph *g2) - graph containing vertex being mapped to
 //         (ULONG v2) - vertex in g2 being mapped to
 //         (ULONG *mapped2) - array mapping vertices of g2 to vertices of g1
+//         (BOOLEAN *edgeUsed) - marks on edges of g2 matched by
+//                               DeletedEdgesCost(), cleared here
 //
 // RETURN: (double) - cost of inserting edges found in g2 between v2
 //                    and another mapped vertex, but not matched to
@@ -464,7 +1075,8 @@ double DeletedEdgesCost(Graph *g1, Graph *g2, ULONG v1, ULONG v2,
 // NOTE: Assumes DeletedEdgesCost() run before this one.
 //******************************************************************************
 
-double InsertedEdgesCost(Graph *g2, ULONG v2, ULONG *mapped2)
+double InsertedEdgesCost(Graph *g2, ULONG v2, ULONG *mapped2,
+                         BOOLEAN *edgeUsed)
 {
    ULONG e2;
    Edge *edge2;
@@ -473,13 +1085,13 @@ double InsertedEdgesCost(Graph *g2, ULONG v2, ULONG *mapped2)
    for (e2 = 0; e2 < g2->vertices[v2].numEdges; e2++) 
    {
       edge2 = & g2->edges[g2->vertices[v2].edges[e2]];
-      if ((! edge2->used) &&
+      if ((! edgeUsed[g2->vertices[v2].edges[e2]]) &&
           (mapped2[edge2->vertex1] != VERTEX_UNMAPPED) &&
           (mapped2[edge2->vertex2] != VERTEX_UNMAPPED)) 
       {
          totalCost += INSERT_EDGE_COST;
       }
-      edge2->used = FALSE;
+      edgeUsed[g2->vertices[v2].edges[e2]] = FALSE;
    }
    return totalCost;
 }
@@ -527,6 +1139,642 @@ double InsertedVerticesCost(Graph *g2, ULONG *mapped2)
 }
 
 
+//******************************************************************************
+// NAME: AllocateMatchBound
+//
+// INPUTS: (void)
+//
+// RETURN: (MatchBound *) - empty label counts for bounding match cost
+//
+// PURPOSE: Allocate the label counts used by MatchBoundCost; its arrays
+// are sized by SetMatchBoundLabels and grow as needed.
+//******************************************************************************
+
+MatchBound *AllocateMatchBound(void)
+{
+   MatchBound *matchBound;
+
+   matchBound = (MatchBound *) malloc(sizeof(MatchBound));
+   if (matchBound == NULL)
+      OutOfMemoryError("AllocateMatchBound:matchBound");
+   matchBound->vertexListSize = 0;
+   matchBound->edgeListSize = 0;
+   matchBound->labelListSize = 0;
+   matchBound->labels = NULL;
+   matchBound->numLabels = 0;
+   matchBound->vertexLabels1 = NULL;
+   matchBound->vertexLabels2 = NULL;
+   matchBound->edgeLabels1 = NULL;
+   matchBound->edgeLabels2 = NULL;
+   matchBound->vertexCount1 = NULL;
+   matchBound->vertexCount2 = NULL;
+   matchBound->edgeCount1 = NULL;
+   matchBound->edgeCount2 = NULL;
+   return matchBound;
+}
+
+
+//******************************************************************************
+// NAME: SetMatchBoundLabels
+//
+// INPUTS: (MatchBound *matchBound) - label counts to be set up
+//         (Graph *g1)
+//         (Graph *g2) - graphs being matched
+//
+// RETURN: (void)
+//
+// PURPOSE: Prepare the label counts used by MatchBoundCost for matching g1
+// and g2.  The labels of both graphs are renumbered 0..numLabels-1, so
+// that the counts only need room for the labels actually occurring in the
+// graphs.
+//******************************************************************************
+
+void SetMatchBoundLabels(MatchBound *matchBound, Graph *g1, Graph *g2)
+{
+   ULONG *labels;
+   ULONG numLabels = 0;
+   ULONG size;
+   ULONG i;
+
+   // make room for labels of both graphs
+   size = g1->numVertices;
+   if (g2->numVertices > size)
+      size = g2->numVertices;
+   if (size > matchBound->vertexListSize)
+   {
+      matchBound->vertexLabels1 = (ULONG *)
+         realloc(matchBound->vertexLabels1, sizeof(ULONG) * size);
+      matchBound->vertexLabels2 = (ULONG *)
+         realloc(matchBound->vertexLabels2, sizeof(ULONG) * size);
+      if ((matchBound->vertexLabels1 == NULL) ||
+          (matchBound->vertexLabels2 == NULL))
+         OutOfMemoryError("SetMatchBoundLabels:matchBound->vertexLabels1");
+      matchBound->vertexListSize = size;
+   }
+   size = g1->numEdges;
+   if (g2->numEdges > size)
+      size = g2->numEdges;
+   if (size > matchBound->edgeListSize)
+   {
+      matchBound->edgeLabels1 = (ULONG *)
+         realloc(matchBound->edgeLabels1, sizeof(ULONG) * size);
+      matchBound->edgeLabels2 = (ULONG *)
+         realloc(matchBound->edgeLabels2, sizeof(ULONG) * size);
+      if ((matchBound->edgeLabels1 == NULL) ||
+          (matchBound->edgeLabels2 == NULL))
+         OutOfMemoryError("SetMatchBoundLabels:matchBound->edgeLabels1");
+      matchBound->edgeListSize = size;
+   }
+   size = g1->numVertices + g2->numVertices + g1->numEdges + g2->numEdges;
+   if (size > matchBound->labelListSize)
+   {
+      matchBound->labels = (ULONG *)
+         realloc(matchBound->labels, sizeof(ULONG) * size);
+      matchBound->vertexCount1 = (ULONG *)
+         realloc(matchBound->vertexCount1, sizeof(ULONG) * size);
+      matchBound->vertexCount2 = (ULONG *)
+         realloc(matchBound->vertexCount2, sizeof(ULONG) * size);
+      matchBound->edgeCount1 = (ULONG *)
+         realloc(matchBound->edgeCount1, sizeof(ULONG) * size);
+      matchBound->edgeCount2 = (ULONG *)
+         realloc(matchBound->edgeCount2, sizeof(ULONG) * size);
+      if ((matchBound->labels == NULL) ||
+          (matchBound->vertexCount1 == NULL) ||
+          (matchBound->vertexCount2 == NULL) ||
+          (matchBound->edgeCount1 == NULL) ||
+          (matchBound->edgeCount2 == NULL))
+         OutOfMemoryError("SetMatchBoundLabels:matchBound->labels");
+      matchBound->labelListSize = size;
+   }
+
+   // collect different labels of both graphs
+   labels = matchBound->labels;
+   for (i = 0; i < g1->numVertices; i++)
+      labels[numLabels++] = g1->vertices[i].label;
+   for (i = 0; i < g2->numVertices; i++)
+      labels[numLabels++] = g2->vertices[i].label;
+   for (i = 0; i < g1->numEdges; i++)
+      labels[numLabels++] = g1->edges[i].label;
+   for (i = 0; i < g2->numEdges; i++)
+      labels[numLabels++] = g2->edges[i].label;
+   numLabels = SortUnique(labels, numLabels);
+   matchBound->numLabels = numLabels;
+
+   for (i = 0; i < g1->numVertices; i++)
+      matchBound->vertexLabels1[i] =
+         FindULONG(labels, numLabels, g1->vertices[i].label);
+   for (i = 0; i < g2->numVertices; i++)
+      matchBound->vertexLabels2[i] =
+         FindULONG(labels, numLabels, g2->vertices[i].label);
+   for (i = 0; i < g1->numEdges; i++)
+      matchBound->edgeLabels1[i] =
+         FindULONG(labels, numLabels, g1->edges[i].label);
+   for (i = 0; i < g2->numEdges; i++)
+      matchBound->edgeLabels2[i] =
+         FindULONG(labels, numLabels, g2->edges[i].label);
+}
+
+
+//******************************************************************************
+// NAME: InitMatchBound
+//
+// INPUTS: (MatchBound *matchBound) - label counts to be set
+//         (Graph *g1)
+//         (Graph *g2) - graphs being matched
+//         (ULONG *mapped1) - mapping of vertices in g1 to vertices in g2
+//         (ULONG *mapped2) - mapping of vertices in g2 to vertices in g1
+//
+// RETURN: (void)
+//
+// PURPOSE: Count the labels of the vertices and edges not yet accounted for
+// by the given partial mapping.  An edge of g1 has been costed once one of
+// its vertices is deleted, or both are mapped; an edge of g2 has been
+// costed once both its vertices are mapped.
+//******************************************************************************
+
+void InitMatchBound(MatchBound *matchBound, Graph *g1, Graph *g2,
+                    ULONG *mapped1, ULONG *mapped2)
+{
+   ULONG i;
+   Edge *edge;
+
+   for (i = 0; i < matchBound->numLabels; i++)
+   {
+      matchBound->vertexCount1[i] = 0;
+      matchBound->vertexCount2[i] = 0;
+      matchBound->edgeCount1[i] = 0;
+      matchBound->edgeCount2[i] = 0;
+   }
+   matchBound->numVertices1 = 0;
+   matchBound->numVertices2 = 0;
+   matchBound->numEdges1 = 0;
+   for (i = 0; i < g1->numVertices; i++)
+      if (mapped1[i] == VERTEX_UNMAPPED)
+      {
+         matchBound->vertexCount1[matchBound->vertexLabels1[i]]++;
+         matchBound->numVertices1++;
+      }
+   for (i = 0; i < g2->numVertices; i++)
+      if (mapped2[i] == VERTEX_UNMAPPED)
+      {
+         matchBound->vertexCount2[matchBound->vertexLabels2[i]]++;
+         matchBound->numVertices2++;
+      }
+   for (i = 0; i < g1->numEdges; i++)
+   {
+      edge = & g1->edges[i];
+      if ((mapped1[edge->vertex1] != VERTEX_DELETED) &&
+          (mapped1[edge->vertex2] != VERTEX_DELETED) &&
+          ((mapped1[edge->vertex1] == VERTEX_UNMAPPED) ||
+           (mapped1[edge->vertex2] == VERTEX_UNMAPPED)))
+      {
+         matchBound->edgeCount1[matchBound->edgeLabels1[i]]++;
+         matchBound->numEdges1++;
+      }
+   }
+   for (i = 0; i < g2->numEdges; i++)
+   {
+      edge = & g2->edges[i];
+      if ((mapped2[edge->vertex1] == VERTEX_UNMAPPED) ||
+          (mapped2[edge->vertex2] == VERTEX_UNMAPPED))
+         matchBound->edgeCount2[matchBound->edgeLabels2[i]]++;
+   }
+   matchBound->commonVertices = 0;
+   matchBound->commonEdges = 0;
+   for (i = 0; i < matchBound->numLabels; i++)
+   {
+      if (matchBound->vertexCount1[i] < matchBound->vertexCount2[i])
+         matchBound->commonVertices += matchBound->vertexCount1[i];
+      else
+         matchBound->commonVertices += matchBound->vertexCount2[i];
+      if (matchBound->edgeCount1[i] < matchBound->edgeCount2[i])
+         matchBound->commonEdges += matchBound->edgeCount1[i];
+      else
+         matchBound->commonEdges += matchBound->edgeCount2[i];
+   }
+}
+
+
+//******************************************************************************
+// NAME: MatchBoundCost
+//
+// INPUTS: (MatchBound *matchBound) - label counts set by InitMatchBound for
+//                                    the mapping being extended
+//         (Graph *g1)
+//         (Graph *g2) - graphs being matched
+//         (ULONG v1) - vertex in g1 being mapped
+//         (ULONG v2) - vertex in g2 being mapped to, or VERTEX_DELETED
+//         (ULONG *mapped1) - mapping of vertices in g1 to vertices in g2
+//         (ULONG *mapped2) - mapping of vertices in g2 to vertices in g1
+//
+// RETURN: (double) - lower bound on the cost of completing the mapping
+//                    extended by v1 -> v2
+//
+// PURPOSE: Bound the cost still to come once v1 -> v2 is added to the
+// mapping.  Each unmapped vertex of g1 is deleted or mapped, and each
+// unmapped vertex of g2 is mapped to or inserted, so at most
+// min(vertexCount1,vertexCount2) of them per label match at no cost, and
+// at least max(numVertices1,numVertices2) operations remain.  Likewise,
+// each edge of g1 not yet costed is either deleted or matched to an edge
+// of g2 not yet costed, and only those with equal labels can match at no
+// cost.  Edges of g2 inserted with their vertices may cost nothing, so
+// they are not counted.  The counts are restored before returning.
+//******************************************************************************
+
+double MatchBoundCost(MatchBound *matchBound, Graph *g1, Graph *g2,
+                      ULONG v1, ULONG v2, ULONG *mapped1, ULONG *mapped2)
+{
+   ULONG e;
+   ULONG label;
+   ULONG otherVertex;
+   Edge *edge;
+   ULONG numVertices1 = matchBound->numVertices1 - 1;
+   ULONG numVertices2 = matchBound->numVertices2;
+   ULONG numEdges1 = matchBound->numEdges1;
+   ULONG commonVertices = matchBound->commonVertices;
+   ULONG commonEdges = matchBound->commonEdges;
+   ULONG *vertexCount1 = matchBound->vertexCount1;
+   ULONG *vertexCount2 = matchBound->vertexCount2;
+   ULONG *edgeCount1 = matchBound->edgeCount1;
+   ULONG *edgeCount2 = matchBound->edgeCount2;
+   ULONG numVertexOperations;
+
+   // remove v1 (and v2) from unmapped vertices
+   label = matchBound->vertexLabels1[v1];
+   if (vertexCount1[label] <= vertexCount2[label])
+      commonVertices--;
+   vertexCount1[label]--;
+   if (v2 != VERTEX_DELETED)
+   {
+      numVertices2--;
+      label = matchBound->vertexLabels2[v2];
+      if (vertexCount2[label] <= vertexCount1[label])
+         commonVertices--;
+      vertexCount2[label]--;
+   }
+
+   // remove edges of v1 costed by this mapping; when v1 is deleted, these
+   // are its edges not already costed by deleting the other vertex, and
+   // otherwise its edges to other mapped vertices
+   for (e = 0; e < g1->vertices[v1].numEdges; e++)
+   {
+      edge = & g1->edges[g1->vertices[v1].edges[e]];
+      otherVertex = (edge->vertex1 == v1) ? edge->vertex2 : edge->vertex1;
+      if (((v2 == VERTEX_DELETED) &&
+           ((otherVertex == v1) || (mapped1[otherVertex] != VERTEX_DELETED))) ||
+          ((v2 != VERTEX_DELETED) &&
+           ((otherVertex == v1) ||
+            ((mapped1[otherVertex] != VERTEX_UNMAPPED) &&
+             (mapped1[otherVertex] != VERTEX_DELETED)))))
+      {
+         label = matchBound->edgeLabels1[g1->vertices[v1].edges[e]];
+         if (edgeCount1[label] <= edgeCount2[label])
+            commonEdges--;
+         edgeCount1[label]--;
+         numEdges1--;
+      }
+   }
+   // remove edges of v2 to other mapped vertices
+   if (v2 != VERTEX_DELETED)
+      for (e = 0; e < g2->vertices[v2].numEdges; e++)
+      {
+         edge = & g2->edges[g2->vertices[v2].edges[e]];
+         otherVertex = (edge->vertex1 == v2) ? edge->vertex2 : edge->vertex1;
+         if ((otherVertex == v2) || (mapped2[otherVertex] != VERTEX_UNMAPPED))
+         {
+            label = matchBound->edgeLabels2[g2->vertices[v2].edges[e]];
+            if (edgeCount2[label] <= edgeCount1[label])
+               commonEdges--;
+            edgeCount2[label]--;
+         }
+      }
+
+   if (numVertices1 > numVertices2)
+      numVertexOperations = numVertices1 - commonVertices;
+   else
+      numVertexOperations = numVertices2 - commonVertices;
+
+   // restore counts
+   vertexCount1[matchBound->vertexLabels1[v1]]++;
+   if (v2 != VERTEX_DELETED)
+   {
+      vertexCount2[matchBound->vertexLabels2[v2]]++;
+      for (e = 0; e < g2->vertices[v2].numEdges; e++)
+      {
+         edge = & g2->edges[g2->vertices[v2].edges[e]];
+         otherVertex = (edge->vertex1 == v2) ? edge->vertex2 : edge->vertex1;
+         if ((otherVertex == v2) || (mapped2[otherVertex] != VERTEX_UNMAPPED))
+            edgeCount2[matchBound->edgeLabels2[g2->vertices[v2].edges[e]]]++;
+      }
+   }
+   for (e = 0; e < g1->vertices[v1].numEdges; e++)
+   {
+      edge = & g1->edges[g1->vertices[v1].edges[e]];
+      otherVertex = (edge->vertex1 == v1) ? edge->vertex2 : edge->vertex1;
+      if (((v2 == VERTEX_DELETED) &&
+           ((otherVertex == v1) || (mapped1[otherVertex] != VERTEX_DELETED))) ||
+          ((v2 != VERTEX_DELETED) &&
+           ((otherVertex == v1) ||
+            ((mapped1[otherVertex] != VERTEX_UNMAPPED) &&
+             (mapped1[otherVertex] != VERTEX_DELETED)))))
+         edgeCount1[matchBound->edgeLabels1[g1->vertices[v1].edges[e]]]++;
+   }
+
+   return (MIN_VERTEX_MATCH_COST * numVertexOperations) +
+          (MIN_EDGE_MATCH_COST * (numEdges1 - commonEdges));
+}
+
+
+//******************************************************************************
+// NAME: FreeMatchBound
+//
+// INPUTS: (MatchBound *matchBound)
+//
+// RETURN: (void)
+//
+// PURPOSE: Free memory used by match bound label counts.
+//******************************************************************************
+
+void FreeMatchBound(MatchBound *matchBound)
+{
+   if (matchBound != NULL)
+   {
+      free(matchBound->labels);
+      free(matchBound->vertexLabels1);
+      free(matchBound->vertexLabels2);
+      free(matchBound->edgeLabels1);
+      free(matchBound->edgeLabels2);
+      free(matchBound->vertexCount1);
+      free(matchBound->vertexCount2);
+      free(matchBound->edgeCount1);
+      free(matchBound->edgeCount2);
+      free(matchBound);
+   }
+}
+
+
+//******************************************************************************
+// NAME: MixHash
+//
+// INPUTS: (ULONG x) - value to be mixed
+//
+// RETURN: (ULONG) - well-mixed hash of x
+//
+// PURPOSE: Scramble the bits of a value (splitmix64 finalizer), so that
+// sums of mixed values can be used as order-independent hashes.
+//******************************************************************************
+
+ULONG MixHash(ULONG x)
+{
+   x ^= (x >> 33);
+   x *= 0xff51afd7ed558ccdUL;
+   x ^= (x >> 33);
+   x *= 0xc4ceb9fe1a85ec53UL;
+   x ^= (x >> 33);
+   return x;
+}
+
+
+//******************************************************************************
+// NAME: GraphHash
+//
+// INPUTS: (Graph *graph) - graph to hash
+//
+// RETURN: (ULONG) - isomorphism-invariant hash of graph (never zero)
+//
+// PURPOSE: Compute a hash of the graph that is the same for all graphs
+// that match with cost zero, i.e., are isomorphic with the same vertex
+// labels, edge labels and edge directions.  Vertices start out colored by
+// their label and are then recolored GRAPH_HASH_ROUNDS times by combining
+// each vertex's color with the labels, directions and colors of its
+// neighbors (Weisfeiler-Lehman refinement).  Different hashes mean the
+// graphs cannot match exactly; equal hashes still need a GraphMatch.
+//******************************************************************************
+
+ULONG GraphHash(Graph *graph)
+{
+   ULONG v;
+   ULONG e;
+   ULONG round;
+   ULONG nv = graph->numVertices;
+   ULONG *colors;
+   ULONG *newColors;
+   ULONG *tmpColors;
+   Edge *edge;
+   ULONG hash;
+
+   colors = (ULONG *) malloc(sizeof(ULONG) * (nv + 1));
+   newColors = (ULONG *) malloc(sizeof(ULONG) * (nv + 1));
+   if ((colors == NULL) || (newColors == NULL))
+      OutOfMemoryError("GraphHash:colors");
+
+   for (v = 0; v < nv; v++)
+      colors[v] = MixHash(graph->vertices[v].label + 1);
+
+   for (round = 0; round < GRAPH_HASH_ROUNDS; round++)
+   {
+      for (v = 0; v < nv; v++)
+         newColors[v] = MixHash(colors[v]);
+      // each edge contributes (label, direction, neighbor color) to both
+      // of its vertices; contributions are summed so order does not matter
+      for (e = 0; e < graph->numEdges; e++)
+      {
+         edge = & graph->edges[e];
+         hash = MixHash((edge->label + 1) * 4);
+         if (edge->vertex1 == edge->vertex2)
+            newColors[edge->vertex1] += MixHash(hash + 3);
+         else if (edge->directed)
+         {
+            newColors[edge->vertex1] +=
+               MixHash((hash + 1) ^ colors[edge->vertex2]);
+            newColors[edge->vertex2] +=
+               MixHash((hash + 2) ^ colors[edge->vertex1]);
+         }
+         else
+         {
+            newColors[edge->vertex1] += MixHash(hash ^ colors[edge->vertex2]);
+            newColors[edge->vertex2] += MixHash(hash ^ colors[edge->vertex1]);
+         }
+      }
+      tmpColors = colors;
+      colors = newColors;
+      newColors = tmpColors;
+   }
+
+   hash = MixHash(nv) ^ MixHash(graph->numEdges + nv);
+   for (v = 0; v < nv; v++)
+      hash += MixHash(colors[v]);
+
+   free(colors);
+   free(newColors);
+
+   if (hash == 0)
+      hash = 1;
+   return hash;
+}
+
+
+//******************************************************************************
+// NAME: GetGraphFingerprint
+//
+// INPUTS: (Graph *graph) - graph whose fingerprint is wanted
+//
+// RETURN: (GraphFingerprint *) - fingerprint of graph
+//
+// PURPOSE: Return the graph's fingerprint, computing and caching it on
+// first use.  The hash is left to GraphFingerprintHash, since only exact
+// matches need it.  Graphs are usually matched by the thread that built
+// them; a graph shared between threads must have its fingerprint computed
+// before it is shared.
+//******************************************************************************
+
+GraphFingerprint *GetGraphFingerprint(Graph *graph)
+{
+   GraphFingerprint *fingerprint;
+   ULONG nv = graph->numVertices;
+   ULONG ne = graph->numEdges;
+   ULONG i;
+
+   if (graph->fingerprint == NULL)
+   {
+      // one allocation holds the fingerprint followed by its arrays
+      fingerprint = (GraphFingerprint *)
+         malloc(sizeof(GraphFingerprint) + (sizeof(ULONG) * ((3 * nv) + ne)));
+      if (fingerprint == NULL)
+         OutOfMemoryError("GetGraphFingerprint:fingerprint");
+      fingerprint->hash = 0;
+      fingerprint->vertexLabels = (ULONG *) (fingerprint + 1);
+      fingerprint->edgeLabels = fingerprint->vertexLabels + nv;
+      fingerprint->degrees = fingerprint->edgeLabels + ne;
+      fingerprint->orderedVertices = fingerprint->degrees + nv;
+      for (i = 0; i < nv; i++)
+         fingerprint->vertexLabels[i] = graph->vertices[i].label;
+      for (i = 0; i < ne; i++)
+         fingerprint->edgeLabels[i] = graph->edges[i].label;
+      qsort(fingerprint->vertexLabels, nv, sizeof(ULONG), CompareULONGs);
+      qsort(fingerprint->edgeLabels, ne, sizeof(ULONG), CompareULONGs);
+      OrderVerticesByDegree(graph, fingerprint->orderedVertices,
+                            fingerprint->degrees);
+      graph->fingerprint = fingerprint;
+   }
+   return graph->fingerprint;
+}
+
+
+//******************************************************************************
+// NAME: GraphFingerprintHash
+//
+// INPUTS: (Graph *graph) - graph to hash
+//
+// RETURN: (ULONG) - GraphHash of graph
+//
+// PURPOSE: Return the isomorphism-invariant hash of the graph, computing
+// and caching it in the graph's fingerprint on first use.
+//******************************************************************************
+
+ULONG GraphFingerprintHash(Graph *graph)
+{
+   GraphFingerprint *fingerprint = GetGraphFingerprint(graph);
+
+   if (fingerprint->hash == 0)
+      fingerprint->hash = GraphHash(graph);
+   return fingerprint->hash;
+}
+
+
+//******************************************************************************
+// NAME: SameGraphFingerprint
+//
+// INPUTS: (Graph *g1)
+//         (Graph *g2) - graphs to compare
+//
+// RETURN: (BOOLEAN) - FALSE if g1 and g2 cannot be isomorphic
+//
+// PURPOSE: Compare the fingerprints of two graphs: numbers of vertices and
+// edges, vertex and edge labels, degrees, and finally hashes.  Graphs that
+// match with cost zero always have the same fingerprint.
+//******************************************************************************
+
+BOOLEAN SameGraphFingerprint(Graph *g1, Graph *g2)
+{
+   GraphFingerprint *fingerprint1;
+   GraphFingerprint *fingerprint2;
+   ULONG i;
+
+   if ((g1->numVertices != g2->numVertices) ||
+       (g1->numEdges != g2->numEdges))
+      return FALSE;
+   fingerprint1 = GetGraphFingerprint(g1);
+   fingerprint2 = GetGraphFingerprint(g2);
+   for (i = 0; i < g1->numVertices; i++)
+      if ((fingerprint1->vertexLabels[i] != fingerprint2->vertexLabels[i]) ||
+          (fingerprint1->degrees[i] != fingerprint2->degrees[i]))
+         return FALSE;
+   for (i = 0; i < g1->numEdges; i++)
+      if (fingerprint1->edgeLabels[i] != fingerprint2->edgeLabels[i])
+         return FALSE;
+   if (GraphFingerprintHash(g1) != GraphFingerprintHash(g2))
+      return FALSE;
+   return TRUE;
+}
+
+
+//******************************************************************************
+// NAME: FingerprintMatchCost
+//
+// INPUTS: (Graph *g1)
+//         (Graph *g2) - graphs to be matched, in the order passed to
+//                       InexactGraphMatch
+//
+// RETURN: (double) - lower bound on cost of InexactGraphMatch(g1, g2)
+//
+// PURPOSE: Bound the match cost from the graphs' label counts alone, as
+// MatchBoundCost does for the empty mapping: every vertex beyond the
+// label-wise overlap of the two graphs' vertices, and every edge of g1
+// beyond the label-wise overlap of the graphs' edges, costs at least one
+// transformation.
+//******************************************************************************
+
+double FingerprintMatchCost(Graph *g1, Graph *g2)
+{
+   GraphFingerprint *fingerprint1 = GetGraphFingerprint(g1);
+   GraphFingerprint *fingerprint2 = GetGraphFingerprint(g2);
+   ULONG numVertices;
+   ULONG commonVertices;
+   ULONG commonEdges;
+
+   numVertices = g1->numVertices;
+   if (g2->numVertices > numVertices)
+      numVertices = g2->numVertices;
+   commonVertices =
+      NumCommonULONGs(fingerprint1->vertexLabels, g1->numVertices,
+                      fingerprint2->vertexLabels, g2->numVertices);
+   commonEdges =
+      NumCommonULONGs(fingerprint1->edgeLabels, g1->numEdges,
+                      fingerprint2->edgeLabels, g2->numEdges);
+   return (MIN_VERTEX_MATCH_COST * (numVertices - commonVertices)) +
+          (MIN_EDGE_MATCH_COST * (g1->numEdges - commonEdges));
+}
+
+
+//******************************************************************************
+// NAME: FreeGraphFingerprint
+//
+// INPUTS: (Graph *graph) - graph whose fingerprint is no longer valid
+//
+// RETURN: (void)
+//
+// PURPOSE: Free the graph's cached fingerprint, if any, so that it is
+// computed again when next needed.
+//******************************************************************************
+
+void FreeGraphFingerprint(Graph *graph)
+{
+   free(graph->fingerprint);
+   graph->fingerprint = NULL;
+}
+
+
 //---------------------------------------------------------------------------
 // Match Node Heap Functions
 //---------------------------------------------------------------------------
@@ -560,37 +1808,25 @@ MatchHeap *AllocateMatchHeap(ULONG size)
 
 
 //******************************************************************************
-// NAME: AllocateNewMapping
+// NAME: MatchHeapNodeBefore
 //
-// INPUTS: (ULONG depth) - depth (vertices mapped) of new node in search space
-//         (VertexMap *mapping) - partial mapping to be augmented
-//         (ULONG v1)
-//         (ULONG v2) - node's mapping includes v1 -> v2
+// INPUTS: (MatchHeapNode *node1)
+//         (MatchHeapNode *node2) - match nodes to compare
 //
-// RETURN:  (VertexMap *) - newly-allocated vertex mapping
+// RETURN: (BOOLEAN) - TRUE if node1 should come out of the heap before node2
 //
-// PURPOSE: Allocate a new vertex mapping as a copy of the given mapping
-// appended with the new map v1 -> v2.
+// PURPOSE: Order match nodes by increasing bound, and for nodes with the
+// same bound, by decreasing depth.  Remaining ties go to the node created
+// first, so the order does not depend on the layout of the heap.
 //******************************************************************************
 
-VertexMap *AllocateNewMapping(ULONG depth, VertexMap *mapping,
-                ULONG v1, ULONG v2)
+static BOOLEAN MatchHeapNodeBefore(MatchHeapNode *node1, MatchHeapNode *node2)
 {
-   VertexMap *newMapping;
-   ULONG i;
-
-   newMapping = (VertexMap *) malloc(sizeof(VertexMap) * depth);
-   if (newMapping == NULL)
-      OutOfMemoryError("AllocateNewMapping: newMapping");
-   for (i = 0; i < (depth - 1); i++) 
-   {
-      newMapping[i].v1 = mapping[i].v1;
-      newMapping[i].v2 = mapping[i].v2;
-   }
-   newMapping[depth-1].v1 = v1;
-   newMapping[depth-1].v2 = v2;
-
-   return newMapping;
+   if (node1->bound != node2->bound)
+      return (node1->bound < node2->bound);
+   if (node1->depth != node2->depth)
+      return (node1->depth > node2->depth);
+   return (node1->map < node2->map);
 }
 
 
@@ -620,16 +1856,14 @@ BOOLEAN MatchHeapEmpty(MatchHeap *heap)
 //
 // RETURN:  (void)
 //
-// PURPOSE: Insert given node into given heap, maintaining increasing
-// order by cost, and for nodes with the same cost, in decreasing order
-// by depth.
+// PURPOSE: Insert given node into given heap, maintaining the order of
+// MatchHeapNodeBefore.
 //******************************************************************************
 
 void InsertMatchHeapNode(MatchHeapNode *node, MatchHeap *heap)
 {
    ULONG i;
    ULONG parent;
-   MatchHeapNode *node2;
    BOOLEAN done;
 
    heap->numNodes++;
@@ -648,22 +1882,16 @@ void InsertMatchHeapNode(MatchHeapNode *node, MatchHeap *heap)
    while ((i > 0) && (! done)) 
    {
       parent = HeapParent(i);
-      node2 = & heap->nodes[parent];
-      if ((node->cost < node2->cost) ||
-          ((node->cost == node2->cost) && (node->depth > node2->depth))) 
+      if (MatchHeapNodeBefore(node, & heap->nodes[parent]))
       {
-         heap->nodes[i].cost = heap->nodes[parent].cost;
-         heap->nodes[i].depth = heap->nodes[parent].depth;
-         heap->nodes[i].mapping = heap->nodes[parent].mapping;
+         heap->nodes[i] = heap->nodes[parent];
          i = parent;
       } 
       else 
          done = TRUE;
    }
    // store new node
-   heap->nodes[i].cost = node->cost;
-   heap->nodes[i].depth = node->depth;
-   heap->nodes[i].mapping = node->mapping;
+   heap->nodes[i] = *node;
 }
 
 
@@ -682,18 +1910,11 @@ void InsertMatchHeapNode(MatchHeapNode *node, MatchHeap *heap)
 
 void ExtractMatchHeapNode(MatchHeap *heap, MatchHeapNode *node)
 {
-   ULONG i;
-
    // copy best node to input storage node
-   node->cost = heap->nodes[0].cost;
-   node->depth = heap->nodes[0].depth;
-   node->mapping = heap->nodes[0].mapping;
+   *node = heap->nodes[0];
 
    // copy last node in heap array to first
-   i = heap->numNodes - 1;
-   heap->nodes[0].cost = heap->nodes[i].cost;
-   heap->nodes[0].depth = heap->nodes[i].depth;
-   heap->nodes[0].mapping = heap->nodes[i].mapping;
+   heap->nodes[0] = heap->nodes[heap->numNodes - 1];
    heap->numNodes--;
  
    HeapifyMatchHeap(heap);
@@ -708,9 +1929,8 @@ void ExtractMatchHeapNode(MatchHeap *heap, MatchHeapNode *node)
 // RETURN:  (void)
 //
 // PURPOSE: Restores the heap property of the heap starting at the root
-// node.  The heap property is that parent nodes have less cost than their
-// children, and if the cost is the same, then parents have greater or
-// equal depth than their children.
+// node.  The heap property is that no child node comes before its parent
+// according to MatchHeapNodeBefore.
 //******************************************************************************
 
 void HeapifyMatchHeap(MatchHeap *heap)
@@ -719,59 +1939,29 @@ void HeapifyMatchHeap(MatchHeap *heap)
    ULONG best;
    ULONG leftChild;
    ULONG rightChild;
-   MatchHeapNode *parentNode;
-   MatchHeapNode *bestNode;
-   MatchHeapNode *leftNode;
-   MatchHeapNode *rightNode;
-   ULONG tmpDepth;
-   double tmpCost;
-   VertexMap *tmpMapping;
+   MatchHeapNode tmpNode;
 
    parent = 0;
    best = 1;
    while (parent != best) 
    {
-      parentNode = & heap->nodes[parent];
       leftChild = HeapLeftChild(parent);
       rightChild = HeapRightChild(parent);
       best = parent;
-      bestNode = parentNode;
       // check if left child better than parent
-      if (leftChild < heap->numNodes) 
-      {
-         leftNode = & heap->nodes[leftChild];
-         if ((leftNode->cost < parentNode->cost) ||
-             ((leftNode->cost == parentNode->cost) &&
-              (leftNode->depth > parentNode->depth))) 
-         {
-            best = leftChild;
-            bestNode = leftNode;
-         }
-      }
+      if ((leftChild < heap->numNodes) &&
+          MatchHeapNodeBefore(& heap->nodes[leftChild], & heap->nodes[best]))
+         best = leftChild;
       // check if right child better than best so far
-      if (rightChild < heap->numNodes) 
-      {
-         rightNode = & heap->nodes[rightChild];
-         if ((rightNode->cost < bestNode->cost) ||
-             ((rightNode->cost == bestNode->cost) &&
-              (rightNode->depth > bestNode->depth))) 
-         {
-            best = rightChild;
-            bestNode = rightNode;
-         }
-      }
+      if ((rightChild < heap->numNodes) &&
+          MatchHeapNodeBefore(& heap->nodes[rightChild], & heap->nodes[best]))
+         best = rightChild;
       // if child better than parent, then swap
       if (parent != best) 
       {
-         tmpCost = parentNode->cost;
-         tmpDepth = parentNode->depth;
-         tmpMapping = parentNode->mapping;
-         parentNode->cost = bestNode->cost;
-         parentNode->depth = bestNode->depth;
-         parentNode->mapping = bestNode->mapping;
-         bestNode->cost = tmpCost;
-         bestNode->depth = tmpDepth;
-         bestNode->mapping = tmpMapping;
+         tmpNode = heap->nodes[parent];
+         heap->nodes[parent] = heap->nodes[best];
+         heap->nodes[best] = tmpNode;
          parent = best;
          best = 0; // something other than parent so while loop continues
       }
@@ -779,35 +1969,6 @@ void HeapifyMatchHeap(MatchHeap *heap)
 }
 
 
-//******************************************************************************
-// NAME: MergeMatchHeaps
-//
-// INPUTS: (MatchHeap *heap1) - match node list to be inserted from
-//         (MatchHeap *heap2) - match node list to be inserted into
-//
-// RETURN:  (void)
-//
-// PURPOSE: Insert the match nodes of heap1 into heap2 while maintaining
-// the order of heap2.  Ordering is by increasing cost, or if costs are
-// equal, by decreasing depth.  The nodes of heap2 are removed, but the
-// memory remains allocated.
-//******************************************************************************
-
-void MergeMatchHeaps(MatchHeap *heap1, MatchHeap *heap2)
-{
-   ULONG i;
-   MatchHeapNode *node;
-
-   for (i = 0; i < heap1->numNodes; i++) 
-   {
-      node = & heap1->nodes[i];
-      InsertMatchHeapNode(node, heap2);
-      node->mapping = NULL;
-   }
-   heap1->numNodes = 0;
-}
-
-
 //******************************************************************************
 // NAME: CompressMatchHeap
 //
@@ -819,50 +1980,39 @@ void MergeMatchHeaps(MatchHeap *heap1, MatchHeap *heap2)
 // PURPOSE: Compress match node heap for the beginning of greedy
 // search within the InexactGraphMatch function.  The first n nodes
 // are left on the heap.  If there are more nodes on the heap, then
-// the nodes with unique costs remain on the heap, and the rest are
-// freed.  Note that the heap is assumed to already be in increasing
-// order by cost, and for nodes having the same cost, in decreasing
-// order by depth.
+// the nodes with unique bounds remain on the heap, and the rest are
+// dropped.  The heap is sorted in place, and the sorted nodes kept
+// form a valid heap.
 //******************************************************************************
 
 void CompressMatchHeap(MatchHeap *heap, ULONG n)
 {
-   MatchHeap *newHeap;
-   MatchHeapNode node1;
-   MatchHeapNode node2;
-
-   node1.cost = 0;
-   node2.cost = 0;
-
-   newHeap = AllocateMatchHeap(n);
+   ULONG numNodes = heap->numNodes;
+   ULONG i;
+   ULONG numKept;
+   MatchHeapNode node;
 
-   // keep best n nodes
-   while ((n > 0) && (! MatchHeapEmpty(heap))) 
+   // sort nodes; each node extracted goes to the slot freed at the end,
+   // leaving the best node last
+   while (heap->numNodes > 1)
    {
-      ExtractMatchHeapNode(heap, & node1);
-      InsertMatchHeapNode(& node1, newHeap);
-      n--;
+      ExtractMatchHeapNode(heap, & node);
+      heap->nodes[heap->numNodes] = node;
    }
-
-   // keep remaining nodes with unique costs
-   while (! MatchHeapEmpty(heap)) 
+   for (i = 0; i < (numNodes / 2); i++)
    {
-      ExtractMatchHeapNode(heap, & node2);
-      if (node1.cost == node2.cost)
-         free(node2.mapping);
-      else 
-      {
-         InsertMatchHeapNode(& node2, newHeap);
-         node1.cost = node2.cost;
-      }
+      node = heap->nodes[i];
+      heap->nodes[i] = heap->nodes[numNodes - 1 - i];
+      heap->nodes[numNodes - 1 - i] = node;
    }
 
-   // free old heap and install new one in its place
-   free(heap->nodes);
-   heap->nodes = newHeap->nodes;
-   heap->size = newHeap->size;
-   heap->numNodes = newHeap->numNodes;
-   free(newHeap);
+   // keep best n nodes, and remaining nodes with unique bounds
+   numKept = 0;
+   for (i = 0; i < numNodes; i++)
+      if ((numKept < n) ||
+          (heap->nodes[i].bound != heap->nodes[numKept - 1].bound))
+         heap->nodes[numKept++] = heap->nodes[i];
+   heap->numNodes = numKept;
 }
 
 
@@ -870,28 +2020,32 @@ void CompressMatchHeap(MatchHeap *heap, ULONG n)
 // NAME: PrintMatchHeapNode
 //
 // INPUTS: (MatchHeapNode *node) - match node to print
+//         (MatchContext *context) - match context holding node's mapping
 //
 // RETURN: (void)
 //
 // PURPOSE: Print match node.
 //******************************************************************************
 
-void PrintMatchHeapNode(MatchHeapNode *node)
+void PrintMatchHeapNode(MatchHeapNode *node, MatchContext *context)
 {
-   ULONG i;
-   printf("MatchHeapNode: depth = %lu, cost = %f, mapping =",
-           node->depth, node->cost);
+   ULONG map;
+
+   printf("MatchHeapNode: depth = %lu, cost = %f, bound = %f, mapping =",
+           node->depth, node->cost, node->bound);
    if (node->depth > 0) 
    {
       printf("\n");
-      for (i = 0; i < node->depth; i++) 
+      // mapping printed from last vertex map back to first
+      for (map = node->map; map != NO_MATCH_MAP;
+           map = context->maps[map].parent)
       {
-         printf("            %lu -> ", node->mapping[i].v1);
-         if (node->mapping[i].v2 == VERTEX_UNMAPPED)
+         printf("            %lu -> ", context->maps[map].v1);
+         if (context->maps[map].v2 == VERTEX_UNMAPPED)
             printf("unmapped\n");
-         else if (node->mapping[i].v2 == VERTEX_DELETED)
+         else if (context->maps[map].v2 == VERTEX_DELETED)
             printf("deleted\n");
-         else printf("%lu\n", node->mapping[i].v2);
+         else printf("%lu\n", context->maps[map].v2);
       }
    } 
    else 
@@ -903,13 +2057,14 @@ void PrintMatchHeapNode(MatchHeapNode *node)
 // NAME: PrintMatchHeap
 //
 // INPUTS: (MatchHeap *heap) - match node heap to print
+//         (MatchContext *context) - match context holding nodes' mappings
 //
 // RETURN: (void)
 //
 // PURPOSE: Print match node list.
 //******************************************************************************
 
-void PrintMatchHeap(MatchHeap *heap)
+void PrintMatchHeap(MatchHeap *heap, MatchContext *context)
 {
    ULONG i;
    MatchHeapNode *node;
@@ -919,7 +2074,7 @@ void PrintMatchHeap(MatchHeap *heap)
    {
       node = & heap->nodes[i];
       printf("(%lu) ", i);
-      PrintMatchHeapNode(node);
+      PrintMatchHeapNode(node, context);
    }
 }
 
@@ -931,16 +2086,12 @@ void PrintMatchHeap(MatchHeap *heap)
 //
 // RETURN: (void)
 //
-// PURPOSE: Free mappings of match nodes still in heap and reset heap to
-// have zero nodes.
+// PURPOSE: Reset heap to have zero nodes.  The mappings of the nodes are
+// held by the match context, so nothing is freed.
 //******************************************************************************
 
 void ClearMatchHeap(MatchHeap *heap)
 {
-   ULONG i;
-
-   for (i = 0; i < heap->numNodes; i++)
-      free(heap->nodes[i].mapping);
    heap->numNodes = 0;
 }
 
@@ -957,7 +2108,6 @@ void ClearMatchHeap(MatchHeap *heap)
 
 void FreeMatchHeap(MatchHeap *heap)
 {
-   ClearMatchHeap(heap);
    free(heap->nodes);
    free(heap);
 }
@@ -51,6 +51,8 @@ void ReadInputFile(Parameters *parameters)
    info.vertexOffset = (parameters->posGraph == NULL) ? 0 : parameters->posGraph->numVertices;
    
    info.xp_graph = TRUE;
+   info.plain_graph = FALSE;
+   info.numThreads = parameters->numThreads;
    
    GP_read_graph(&info, parameters->inputFileName);
   
@@ -61,16 +63,23 @@ void ReadInputFile(Parameters *parameters)
    
    parameters->posGraphVertexListSize = info.posGraphVertexListSize;
    parameters->posGraphEdgeListSize = info.posGraphEdgeListSize;
+   if (parameters->posGraph != NULL)
+      IndexVertexLabels(parameters->posGraph);
+   IndexPosExamples(parameters);
    
 	
-   // GUI coloring
-   if (parameters->posGraph == NULL)
-      parameters->originalPosGraph = NULL;
-   else
-      parameters->originalPosGraph = CopyGraph(parameters->posGraph);
-   parameters->originalLabelList = AllocateLabelList();
-   for (index=0; index != parameters->labelList->numLabels; index++)
-      StoreLabel(&(parameters->labelList->labels[index]), parameters->originalLabelList);
+   // GUI coloring; the copy of the input graph is colored for, and
+   // only read by, dot output
+   parameters->originalPosGraph = NULL;
+   parameters->originalLabelList = NULL;
+   if (parameters->dotToFile)
+   {
+      if (parameters->posGraph != NULL)
+         parameters->originalPosGraph = CopyGraph(parameters->posGraph);
+      parameters->originalLabelList = AllocateLabelList();
+      for (index=0; index != parameters->labelList->numLabels; index++)
+         StoreLabel(&(parameters->labelList->labels[index]), parameters->originalLabelList);
+   }
 }
 
 
@@ -98,6 +107,48 @@ ULONG *AddVertexIndex(ULONG *vertexIndices, ULONG n, ULONG index)
 }
 
 
+//******************************************************************************
+// NAME: IndexPosExamples
+//
+// INPUTS: (Parameters *parameters)
+//
+// RETURN: (void)
+//
+// PURPOSE: Compute the positive example number of each vertex of the
+// positive graph from the examples' starting vertex indices, so that the
+// example containing an instance is found without searching the indices.
+// Must be called again whenever the positive graph is replaced.
+//******************************************************************************
+
+void IndexPosExamples(Parameters *parameters)
+{
+   ULONG v;
+   ULONG egNo;
+
+   // parameters used
+   Graph *posGraph            = parameters->posGraph;
+   ULONG numPosEgs            = parameters->numPosEgs;
+   ULONG *posEgsVertexIndices = parameters->posEgsVertexIndices;
+
+   free(parameters->posVertexExamples);
+   parameters->posVertexExamples = NULL;
+   if ((posGraph == NULL) || (posGraph->numVertices == 0))
+      return;
+
+   parameters->posVertexExamples =
+      (ULONG *) malloc(sizeof(ULONG) * posGraph->numVertices);
+   if (parameters->posVertexExamples == NULL)
+      OutOfMemoryError("IndexPosExamples:posVertexExamples");
+   egNo = 1;
+   for (v = 0; v < posGraph->numVertices; v++)
+   {
+      while ((egNo < numPosEgs) && (v >= posEgsVertexIndices[egNo]))
+         egNo++;
+      parameters->posVertexExamples[v] = egNo;
+   }
+}
+
+
 //******************************************************************************
 // NAME: ReadPredefinedSubsFile
 //
@@ -134,6 +185,8 @@ void ReadPredefinedSubsFile(Parameters *parameters)
    info.vertexOffset = 0;
    
    info.xp_graph = FALSE;
+   info.plain_graph = FALSE;
+   info.numThreads = 1;
    
    GP_read_graph(&info, parameters->psInputFileName);
   
@@ -182,7 +235,6 @@ void AddVertex(Graph *graph, ULONG labelIndex, ULONG *vertexListSize,
    graph->vertices[numVertices].numEdges = 0;
    graph->vertices[numVertices].edges = NULL;
    graph->vertices[numVertices].map = VERTEX_UNMAPPED;
-   graph->vertices[numVertices].used = FALSE;
    graph->vertices[numVertices].sourceVertex = sourceVertex;
    graph->vertices[numVertices].sourceExample = 0;   // will set later...
 
@@ -192,6 +244,9 @@ void AddVertex(Graph *graph, ULONG labelIndex, ULONG *vertexListSize,
    graph->vertices[numVertices].anomalousValue = 2.0;
 
    graph->numVertices++;
+   FreeGraphFingerprint(graph);
+   FreeVertexLabelIndex(graph);
+   FreeEdgeTypeIndex(graph);
 }
 
 
@@ -236,7 +291,6 @@ void AddEdge(Graph *graph, ULONG sourceVertexIndex, ULONG targetVertexIndex,
    graph->edges[graph->numEdges].vertex2 = targetVertexIndex;
    graph->edges[graph->numEdges].label = labelIndex;
    graph->edges[graph->numEdges].directed = directed;
-   graph->edges[graph->numEdges].used = FALSE;
    graph->edges[graph->numEdges].spansIncrement = spansIncrement;
    graph->edges[graph->numEdges].validPath = TRUE;
    //
@@ -257,6 +311,7 @@ void AddEdge(Graph *graph, ULONG sourceVertexIndex, ULONG targetVertexIndex,
    graph->edges[graph->numEdges].anomalousValue = 2.0;
 
    graph->numEdges++;
+   FreeGraphFingerprint(graph);
 }
 
 
@@ -284,7 +339,6 @@ void StoreEdge(Edge *overlapEdges, ULONG edgeIndex,
    overlapEdges[edgeIndex].vertex2 = v2;
    overlapEdges[edgeIndex].label = label;
    overlapEdges[edgeIndex].directed = directed;
-   overlapEdges[edgeIndex].used = FALSE;
    overlapEdges[edgeIndex].spansIncrement = spansIncrement;
 }
 
@@ -329,6 +383,7 @@ void AddEdgeToVertices(Graph *graph, ULONG edgeIndex)
       vertex->edges = edgeIndices;
       vertex->numEdges++;
    }
+   FreeEdgeTypeIndex(graph);
 }
 
 
@@ -356,6 +411,9 @@ Graph *AllocateGraph(ULONG v, ULONG e)
    graph->numEdges = e;
    graph->vertices = NULL;
    graph->edges = NULL;
+   graph->fingerprint = NULL;
+   graph->labelIndex = NULL;
+   graph->edgeIndex = NULL;
    if (v > 0) 
    {
       graph->vertices = (Vertex *) malloc(sizeof(Vertex) * v);
@@ -402,7 +460,6 @@ Graph *CopyGraph(Graph *g)
    {
       gCopy->vertices[v].label = g->vertices[v].label;
       gCopy->vertices[v].map = g->vertices[v].map;
-      gCopy->vertices[v].used = g->vertices[v].used;
       numEdges = g->vertices[v].numEdges;
       gCopy->vertices[v].numEdges = numEdges;
       gCopy->vertices[v].edges = NULL;
@@ -429,7 +486,6 @@ Graph *CopyGraph(Graph *g)
       gCopy->edges[e].vertex2 = g->edges[e].vertex2;
       gCopy->edges[e].label = g->edges[e].label;
       gCopy->edges[e].directed = g->edges[e].directed;
-      gCopy->edges[e].used = g->edges[e].used;
       gCopy->edges[e].sourceVertex1 = g->edges[e].sourceVertex1;
       gCopy->edges[e].sourceVertex2 = g->edges[e].sourceVertex2;
       gCopy->edges[e].sourceExample = g->edges[e].sourceExample;
@@ -464,11 +520,403 @@ void FreeGraph(Graph *graph)
          free(graph->vertices[v].edges);
       free(graph->edges);
       free(graph->vertices);
+      FreeGraphFingerprint(graph);
+      FreeVertexLabelIndex(graph);
+      FreeEdgeTypeIndex(graph);
       free(graph);
    }
 }
 
 
+//******************************************************************************
+// NAME: IndexVertexLabels
+//
+// INPUTS: (Graph *graph) - graph to index
+//
+// RETURN: (void)
+//
+// PURPOSE: Builds the graph's label index, grouping its vertices by label,
+// so that the vertices with a given label can be found without scanning
+// the graph.  Called when the positive graph is read or compressed, so
+// that the index exists before it is shared between threads.
+//******************************************************************************
+
+void IndexVertexLabels(Graph *graph)
+{
+   VertexLabelIndex *labelIndex;
+   ULONG numLabels;
+   ULONG label;
+   ULONG v;
+
+   FreeVertexLabelIndex(graph);
+   numLabels = 0;
+   for (v = 0; v < graph->numVertices; v++)
+      if (graph->vertices[v].label >= numLabels)
+         numLabels = graph->vertices[v].label + 1;
+
+   labelIndex = (VertexLabelIndex *)
+      malloc(sizeof(VertexLabelIndex) +
+             sizeof(ULONG) * (numLabels + 1 + graph->numVertices));
+   if (labelIndex == NULL)
+      OutOfMemoryError("IndexVertexLabels:labelIndex");
+   labelIndex->numLabels = numLabels;
+   labelIndex->start = (ULONG *) (labelIndex + 1);
+   labelIndex->vertices = labelIndex->start + numLabels + 1;
+
+   // count vertices with each label, then fill in each label's range
+   for (label = 0; label <= numLabels; label++)
+      labelIndex->start[label] = 0;
+   for (v = 0; v < graph->numVertices; v++)
+      labelIndex->start[graph->vertices[v].label + 1]++;
+   for (label = 0; label < numLabels; label++)
+      labelIndex->start[label + 1] += labelIndex->start[label];
+   for (v = 0; v < graph->numVertices; v++)
+   {
+      label = graph->vertices[v].label;
+      labelIndex->vertices[labelIndex->start[label]++] = v;
+   }
+   // each start now holds the next label's start
+   for (label = numLabels; label > 0; label--)
+      labelIndex->start[label] = labelIndex->start[label - 1];
+   labelIndex->start[0] = 0;
+
+   graph->labelIndex = labelIndex;
+}
+
+
+//******************************************************************************
+// NAME: VerticesWithLabel
+//
+// INPUTS: (Graph *graph) - graph to search
+//         (ULONG label) - label index to look for
+//         (ULONG *numVertices) - set to number of vertices with label
+//
+// RETURN: (ULONG *) - indices of vertices with label, in increasing order
+//
+// PURPOSE: Looks up the vertices of the graph having the given label,
+// building the graph's label index if not already built.  The returned
+// array belongs to the index and must not be freed.
+//******************************************************************************
+
+ULONG *VerticesWithLabel(Graph *graph, ULONG label, ULONG *numVertices)
+{
+   VertexLabelIndex *labelIndex;
+
+   if (graph->labelIndex == NULL)
+      IndexVertexLabels(graph);
+   labelIndex = graph->labelIndex;
+   if (label >= labelIndex->numLabels)
+   {
+      *numVertices = 0;
+      return labelIndex->vertices;
+   }
+   *numVertices = labelIndex->start[label + 1] - labelIndex->start[label];
+   return & labelIndex->vertices[labelIndex->start[label]];
+}
+
+
+//******************************************************************************
+// NAME: FreeVertexLabelIndex
+//
+// INPUTS: (Graph *graph) - graph whose label index is freed
+//
+// RETURN: (void)
+//
+// PURPOSE: Frees the graph's label index, if any, so that it is rebuilt
+// when next needed.  Called whenever the graph's vertices or their labels
+// change.
+//******************************************************************************
+
+void FreeVertexLabelIndex(Graph *graph)
+{
+   free(graph->labelIndex);
+   graph->labelIndex = NULL;
+}
+
+
+//******************************************************************************
+// NAME: CompareIncidentEdges
+//
+// INPUTS: (const void *p1)
+//         (const void *p2) - IncidentEdges to compare
+//
+// RETURN: (int) - negative, zero or positive as p1 is before, same as or
+//                 after p2
+//
+// PURPOSE: qsort comparison ordering incident edges by type, and then by
+// position in the vertex's edge list.
+//******************************************************************************
+
+static int CompareIncidentEdges(const void *p1, const void *p2)
+{
+   const IncidentEdge *edge1 = (const IncidentEdge *) p1;
+   const IncidentEdge *edge2 = (const IncidentEdge *) p2;
+
+   if (edge1->label != edge2->label)
+      return (edge1->label < edge2->label) ? -1 : 1;
+   if (edge1->directed != edge2->directed)
+      return (edge1->directed < edge2->directed) ? -1 : 1;
+   if (edge1->source != edge2->source)
+      return (edge1->source < edge2->source) ? -1 : 1;
+   if (edge1->otherLabel != edge2->otherLabel)
+      return (edge1->otherLabel < edge2->otherLabel) ? -1 : 1;
+   if (edge1->position != edge2->position)
+      return (edge1->position < edge2->position) ? -1 : 1;
+   return 0;
+}
+
+
+//******************************************************************************
+// NAME: IndexEdgeTypes
+//
+// INPUTS: (Graph *graph) - graph to index
+//
+// RETURN: (void)
+//
+// PURPOSE: Builds the graph's edge type index, sorting the edges of each
+// vertex by label, direction and label of the other vertex, so that the
+// edges of a vertex able to match a given edge are found without checking
+// each edge.
+//******************************************************************************
+
+void IndexEdgeTypes(Graph *graph)
+{
+   EdgeTypeIndex *edgeIndex;
+   IncidentEdge *incidentEdge;
+   Vertex *vertex;
+   Edge *edge;
+   ULONG numIncidentEdges;
+   ULONG v, e;
+
+   FreeEdgeTypeIndex(graph);
+   numIncidentEdges = 0;
+   for (v = 0; v < graph->numVertices; v++)
+      numIncidentEdges += graph->vertices[v].numEdges;
+
+   edgeIndex = (EdgeTypeIndex *)
+      malloc(sizeof(EdgeTypeIndex) +
+             sizeof(IncidentEdge) * numIncidentEdges +
+             sizeof(ULONG) * (graph->numVertices + 1));
+   if (edgeIndex == NULL)
+      OutOfMemoryError("IndexEdgeTypes:edgeIndex");
+   edgeIndex->edges = (IncidentEdge *) (edgeIndex + 1);
+   edgeIndex->start = (ULONG *) (edgeIndex->edges + numIncidentEdges);
+
+   numIncidentEdges = 0;
+   for (v = 0; v < graph->numVertices; v++)
+   {
+      vertex = & graph->vertices[v];
+      edgeIndex->start[v] = numIncidentEdges;
+      for (e = 0; e < vertex->numEdges; e++)
+      {
+         edge = & graph->edges[vertex->edges[e]];
+         incidentEdge = & edgeIndex->edges[numIncidentEdges++];
+         incidentEdge->label = edge->label;
+         incidentEdge->directed = edge->directed;
+         incidentEdge->source = (edge->directed && (edge->vertex1 == v));
+         if (edge->vertex1 == v)
+            incidentEdge->otherLabel = graph->vertices[edge->vertex2].label;
+         else
+            incidentEdge->otherLabel = graph->vertices[edge->vertex1].label;
+         incidentEdge->position = e;
+      }
+      qsort(& edgeIndex->edges[edgeIndex->start[v]], vertex->numEdges,
+            sizeof(IncidentEdge), CompareIncidentEdges);
+   }
+   edgeIndex->start[graph->numVertices] = numIncidentEdges;
+
+   graph->edgeIndex = edgeIndex;
+}
+
+
+//******************************************************************************
+// NAME: EdgesOfType
+//
+// INPUTS: (Graph *graph) - graph to search
+//         (ULONG v) - vertex whose edges are searched
+//         (ULONG label) - edge label
+//         (BOOLEAN directed) - TRUE if edge directed
+//         (BOOLEAN source) - TRUE if directed edge leaves v (must be FALSE
+//                            for undirected edges)
+//         (ULONG otherLabel) - label of edge's other vertex
+//         (ULONG *numEdges) - set to number of edges of this type
+//
+// RETURN: (IncidentEdge *) - edges of v of this type, in the order of v's
+//                            edge list
+//
+// PURPOSE: Looks up the edges of a vertex having the given type, building
+// the graph's edge type index if not already built.  The returned array
+// belongs to the index and must not be freed.
+//******************************************************************************
+
+IncidentEdge *EdgesOfType(Graph *graph, ULONG v, ULONG label,
+                          BOOLEAN directed, BOOLEAN source, ULONG otherLabel,
+                          ULONG *numEdges)
+{
+   IncidentEdge *edges;
+   IncidentEdge key;
+   ULONG low, high, mid;
+   ULONG first;
+
+   if (graph->edgeIndex == NULL)
+      IndexEdgeTypes(graph);
+   edges = graph->edgeIndex->edges;
+   key.label = label;
+   key.directed = directed;
+   key.source = source;
+   key.otherLabel = otherLabel;
+   key.position = 0;
+
+   // find first edge of v not before the type
+   low = graph->edgeIndex->start[v];
+   high = graph->edgeIndex->start[v + 1];
+   while (low < high)
+   {
+      mid = (low + high) / 2;
+      if (CompareIncidentEdges(& edges[mid], & key) < 0)
+         low = mid + 1;
+      else
+         high = mid;
+   }
+   first = low;
+
+   // count edges of the type
+   high = graph->edgeIndex->start[v + 1];
+   while ((low < high) &&
+          (edges[low].label == label) && (edges[low].directed == directed) &&
+          (edges[low].source == source) && (edges[low].otherLabel == otherLabel))
+      low++;
+   *numEdges = low - first;
+   return & edges[first];
+}
+
+
+//******************************************************************************
+// NAME: FreeEdgeTypeIndex
+//
+// INPUTS: (Graph *graph) - graph whose edge type index is freed
+//
+// RETURN: (void)
+//
+// PURPOSE: Frees the graph's edge type index, if any, so that it is rebuilt
+// when next needed.  Called whenever the graph's vertices, edges or labels
+// change.
+//******************************************************************************
+
+void FreeEdgeTypeIndex(Graph *graph)
+{
+   free(graph->edgeIndex);
+   graph->edgeIndex = NULL;
+}
+
+
+//******************************************************************************
+// NAME:    AllocateWorkspace
+//
+// INPUTS:  (void)
+//
+// RETURN:  (Workspace *) - empty workspace
+//
+// PURPOSE: Allocate a workspace for marking graph vertices and edges; its
+// arrays are sized by NewWorkspaceEpoch.
+//******************************************************************************
+
+Workspace *AllocateWorkspace(void)
+{
+   Workspace *workspace;
+
+   workspace = (Workspace *) malloc(sizeof(Workspace));
+   if (workspace == NULL)
+      OutOfMemoryError("AllocateWorkspace:workspace");
+   workspace->epoch = 0;
+   workspace->vertexListSize = 0;
+   workspace->edgeListSize = 0;
+   workspace->vertexMark = NULL;
+   workspace->edgeMark = NULL;
+   workspace->vertexMap = NULL;
+   workspace->exampleSetSize = 0;
+   workspace->exampleSet = NULL;
+   return workspace;
+}
+
+
+//******************************************************************************
+// NAME:    NewWorkspaceEpoch
+//
+// INPUTS:  (Workspace *workspace) - workspace to be cleared
+//          (Graph *graph) - graph to be marked using workspace
+//
+// RETURN:  void
+//
+// PURPOSE: Clear all marks in the workspace by starting a new epoch, making
+// sure there is room for marks on every vertex and edge of the graph.  The
+// stamps are only rewritten when the epoch counter wraps around.
+//******************************************************************************
+
+void NewWorkspaceEpoch(Workspace *workspace, Graph *graph)
+{
+   ULONG i;
+
+   if (graph->numVertices > workspace->vertexListSize)
+   {
+      workspace->vertexMark = (EPOCH *)
+         realloc(workspace->vertexMark, sizeof(EPOCH) * graph->numVertices);
+      if (workspace->vertexMark == NULL)
+         OutOfMemoryError("NewWorkspaceEpoch:vertexMark");
+      workspace->vertexMap = (ULONG *)
+         realloc(workspace->vertexMap, sizeof(ULONG) * graph->numVertices);
+      if (workspace->vertexMap == NULL)
+         OutOfMemoryError("NewWorkspaceEpoch:vertexMap");
+      for (i = workspace->vertexListSize; i < graph->numVertices; i++)
+         workspace->vertexMark[i] = 0;
+      workspace->vertexListSize = graph->numVertices;
+   }
+   if (graph->numEdges > workspace->edgeListSize)
+   {
+      workspace->edgeMark = (EPOCH *)
+         realloc(workspace->edgeMark, sizeof(EPOCH) * graph->numEdges);
+      if (workspace->edgeMark == NULL)
+         OutOfMemoryError("NewWorkspaceEpoch:edgeMark");
+      for (i = workspace->edgeListSize; i < graph->numEdges; i++)
+         workspace->edgeMark[i] = 0;
+      workspace->edgeListSize = graph->numEdges;
+   }
+   if (workspace->epoch == MAX_EPOCH)
+   {
+      // stamps of old epochs could be mistaken for new ones, so clear them
+      for (i = 0; i < workspace->vertexListSize; i++)
+         workspace->vertexMark[i] = 0;
+      for (i = 0; i < workspace->edgeListSize; i++)
+         workspace->edgeMark[i] = 0;
+      workspace->epoch = 0;
+   }
+   workspace->epoch++;
+}
+
+
+//******************************************************************************
+// NAME:    FreeWorkspace
+//
+// INPUTS:  (Workspace *workspace) - workspace to be freed
+//
+// RETURN:  void
+//
+// PURPOSE: Free memory used by workspace.
+//******************************************************************************
+
+void FreeWorkspace(Workspace *workspace)
+{
+   if (workspace != NULL)
+   {
+      free(workspace->vertexMark);
+      free(workspace->edgeMark);
+      free(workspace->vertexMap);
+      free(workspace->exampleSet);
+      free(workspace);
+   }
+}
+
+
 //******************************************************************************
 // NAME:    PrintGraph
 //
@@ -785,293 +1233,32 @@ void WriteAnomGraphToFile(Graph *graph, LabelList *labelList,
 
 Graph *ReadGraph(char *filename, LabelList *labelList, BOOLEAN directed)
 {
-   Graph *graph;
-   FILE *graphFile;
-   ULONG lineNo;             // Line number counter for graph file
-   char token[TOKEN_LEN];
-   ULONG vertexListSize = 0; // Size of currently-allocated vertex array
-   ULONG edgeListSize = 0;   // Size of currently-allocated edge array
-   ULONG vertexOffset = 0;   // Dummy argument to ReadVertex and ReadEdge
-
-   // Allocate graph
-   graph = AllocateGraph(0,0);
-
-   // Open graph file
-   graphFile = fopen(filename,"r");
-   if (graphFile == NULL)
-   {
-      fprintf(stderr, "Unable to open graph file %s.\n", filename);
-      exit(1);
-   }
-
-   // Parse graph file
-   lineNo = 1;
-   while (ReadToken(token, graphFile, &lineNo) != 0)
-   {
-      if (strcmp(token, "v") == 0)         // read vertex
-         ReadVertex(graph, graphFile, labelList, &vertexListSize, &lineNo,
-                    vertexOffset);
-
-      else if (strcmp(token, "e") == 0)    // read 'e' edge
-         ReadEdge(graph, graphFile, labelList, &edgeListSize, &lineNo, directed,
-                  vertexOffset);
-
-      else if (strcmp(token, "u") == 0)    // read undirected edge
-         ReadEdge(graph, graphFile, labelList, &edgeListSize, &lineNo, FALSE,
-                  vertexOffset);
-
-      else if (strcmp(token, "d") == 0)    // read directed edge
-         ReadEdge(graph, graphFile, labelList, &edgeListSize, &lineNo, TRUE,
-                  vertexOffset);
-
-      else
-      {
-         fclose(graphFile);
-         FreeGraph(graph);
-         fprintf(stderr, "Unknown token %s in line %lu of graph file %s.\n",
-                 token, lineNo, filename);
-         exit(1);
-      }
-   }
-   fclose(graphFile);
-
-   //***** trim vertex, edge and label lists
-
-   return graph;
-}
-
-
-//---------------------------------------------------------------------------
-// NAME:    ReadLabel
-//
-// INPUTS:  (FILE *fp) - file pointer from which label is read
-//          (LabelList *labelList) - list of vertex and edge labels
-//          (ULONG *pLineNo) - pointer to line counter in calling function
-//
-// RETURN:  (ULONG) - index of read label in global label list.
-//
-// PURPOSE: Reads a label (string or numeric) from the given file and
-// stores the label in the given label list if not already there.
-// Returns the label's index in the label list.
-//---------------------------------------------------------------------------
-
-ULONG ReadLabel(FILE *fp, LabelList *labelList, ULONG *pLineNo)
-{
-   char token[TOKEN_LEN];
-   char *endptr;
-   Label label;
-
-   ReadToken(token, fp, pLineNo);
-   label.labelType = NUMERIC_LABEL;
-   label.labelValue.numericLabel = strtod(token, &endptr);
-   if (*endptr != '\0')
-   {
-      label.labelType = STRING_LABEL;
-      label.labelValue.stringLabel = token;
-   }
-   return StoreLabel(&label, labelList);
-}
-
-
-//---------------------------------------------------------------------------
-// NAME:    ReadInteger
-//
-// INPUTS:  (FILE *fp) - file pointer from which number is read
-//          (ULONG *pLineNo) - pointer to line counter in calling function
-//
-// RETURN:  (ULONG) - integer read
-//
-// PURPOSE: Read an unsigned long integer from the given file.
-//---------------------------------------------------------------------------
-
-ULONG ReadInteger(FILE *fp, ULONG *pLineNo)
-{
-   ULONG i;
-   char token[TOKEN_LEN];
-   char *endptr;
-
-   ReadToken(token, fp, pLineNo);
-   i = strtoul(token, &endptr, 10);
-   if (*endptr != '\0')
-   {
-      fprintf(stderr, "Error: expecting integer in line %lu.\n",
-              *pLineNo);
-      exit(1);
-   }
-   return i;
-}
-
-
-//---------------------------------------------------------------------------
-// NAME:    ReadToken
-//
-// INPUTS:  (char *token) - string into which token is copied
-//          (FILE *fp) - file pointer from which token is read
-//          (ULONG *pLineNo) - pointer to line counter in calling function
-//
-// RETURN:  (int) - length of token read
-//
-// PURPOSE: Read the next token from the given file.  A token is
-// defined as a string of non-whitespace characters, where whitespace
-// includes spaces, tabs, newlines, comments, and EOF.
-//---------------------------------------------------------------------------
-
-int ReadToken(char *token, FILE *fp, ULONG *pLineNo)
-{
-   char ch;
-   int i = 0;
-
-   // skip whitespace and comments
-   ch = fgetc(fp);
-   while ((ch == SPACE) || (ch == TAB) || (ch == CARRIAGERETURN) ||
-    (ch == NEWLINE) || (ch == COMMENT))
-   {
-      if (ch == NEWLINE)
-         (*pLineNo)++;
-      if (ch == COMMENT)
-      {
-         while ((ch != NEWLINE) && (ch != (char)EOF))  // skip to end of line
-            ch = fgetc(fp);
-         if (ch == NEWLINE)
-            (*pLineNo)++;
-      }
-      if (ch != (char)EOF)
-         ch = fgetc(fp);
-   }
-
-   // read token
-   if (ch == DOUBLEQUOTE)
-   { // read until reaching another double quote
-      do
-      {
-         token[i++] = ch;
-         ch = fgetc(fp);
-      } while ((ch != (char)EOF) && (ch != DOUBLEQUOTE));
-      if (ch == DOUBLEQUOTE)
-         token[i++] = ch;
-      ch = fgetc(fp);
-   }
-   else
-   { // read until reaching whitespace
-      while ((ch != (char)EOF) && (ch != SPACE) && (ch != TAB) &&
-             (ch != CARRIAGERETURN) && (ch != NEWLINE) && (ch != COMMENT))
-      {
-         token[i++] = ch;
-         ch = fgetc(fp);
-      }
-   }
-   token[i] = '\0';
-
-   // if token ended by NEWLINE, increment lineNo
-   if (ch == NEWLINE)
-      (*pLineNo)++;
-
-   // if token ended by comment, go ahead and skip comment
-   if (ch == COMMENT)
-   {
-      while ((ch != NEWLINE) && (ch != (char)EOF))
-         ch = fgetc(fp);
-      if (ch == NEWLINE)
-         (*pLineNo)++;
-   }
-
-   return i;
-}
-
-
-//---------------------------------------------------------------------------
-// NAME:    ReadVertex
-//
-// INPUTS:  (Graph *graph) - pointer to graph being constructed
-//          (FILE *fp) - pointer to graph file stream
-//          (LabelList *labelList) - list of vertex and edge labels
-//          (ULONG *vertexListSize) - pointer to size of graph's allocated
-//                                    vertex array
-//          (ULONG *pLineNo) - pointer to line counter in calling function
-//          (ULONG vertexOffset) - offset to add to vertex numbers
-//
-// RETURN:  (void)
-//
-// PURPOSE: Read and check the vertex number and label, store label in
-// given label list, and add vertex to graph.  A non-zero vertexOffset
-// indicates this vertex is part of a graph beyond the first.
-//--------------------------------------------------------------------------
-
-void ReadVertex(Graph *graph, FILE *fp, LabelList *labelList,
-                ULONG *vertexListSize, ULONG *pLineNo, ULONG vertexOffset)
-{
-   ULONG vertexID;
-   ULONG labelIndex;
-
-   // read and check vertex number
-   vertexID = ReadInteger(fp, pLineNo) + vertexOffset;
-   if (vertexID != (graph->numVertices + 1))
-   {
-      fprintf(stderr, "Error: invalid vertex number at line %lu.\n",
-              *pLineNo);
-      exit(1);
-   }
-   // read label
-   labelIndex = ReadLabel(fp, labelList, pLineNo);
-
-   AddVertex(graph, labelIndex, vertexListSize, 0);
-}
-
+   Graph_Info info;
 
-//---------------------------------------------------------------------------
-// NAME:    ReadEdge
-//
-// INPUTS:  (Graph *graph) - pointer to graph being constructed
-//          (FILE *fp) - pointer to graph file stream
-//          (LabelList *labelList) - list of vertex and edge labels
-//          (ULONG *edgeListSize) - pointer to size of graph's allocated
-//                                  edge array
-//          (ULONG *pLineNo) - pointer to line counter in calling function
-//          (BOOLEAN directed) - TRUE if edge is directed
-//          (ULONG vertexOffset) - offset to add to vertex numbers
-//
-// RETURN:  (void)
-//
-// PURPOSE: Read and check the vertex numbers and label, store label in
-// given label list, and add edge to graph.  A non-zero vertexOffset
-// indicates the edge's vertices are part of a graph beyond the first.
-//---------------------------------------------------------------------------
+   info.graph = AllocateGraph(0,0);
+   info.labelList = labelList;
+   info.preSubs = NULL;
+   info.numPreSubs = 0;
+   info.numPosEgs = 0;
+   info.posEgsVertexIndices = NULL;
+   info.directed = directed;
+   info.posGraphVertexListSize = 0;
+   info.posGraphEdgeListSize = 0;
+   info.vertexOffset = 0;
+   info.xp_graph = TRUE;
+   info.plain_graph = TRUE;
+   info.numThreads = 1;
 
-void ReadEdge(Graph *graph, FILE *fp, LabelList *labelList,
-              ULONG *edgeListSize, ULONG *pLineNo, BOOLEAN directed,
-              ULONG vertexOffset)
-{
-   ULONG sourceVertexID;
-   ULONG targetVertexID;
-   ULONG sourceVertexIndex;
-   ULONG targetVertexIndex;
-   ULONG labelIndex;
-
-   // read and check vertex numbers
-   sourceVertexID = ReadInteger(fp, pLineNo) + vertexOffset;
-   if (sourceVertexID > graph->numVertices)
-   {
-      fprintf(stderr,
-              "Error: reference to undefined vertex number at line %lu.\n",
-              *pLineNo);
-      exit(1);
-   }
-   targetVertexID = ReadInteger(fp, pLineNo) + vertexOffset;
-   if (targetVertexID > graph->numVertices)
+   // Parse graph file
+   if (GP_read_graph(&info, filename) != 0)
    {
-      fprintf(stderr,
-              "Error: reference to undefined vertex number at line %lu.\n",
-              *pLineNo);
+      FreeGraph(info.graph);
       exit(1);
    }
-   sourceVertexIndex = sourceVertexID - 1;
-   targetVertexIndex = targetVertexID - 1;
 
-   // read and store label
-   labelIndex = ReadLabel(fp, labelList, pLineNo);
+   //***** trim vertex, edge and label lists
 
-   AddEdge(graph, sourceVertexIndex, targetVertexIndex, directed,
-           labelIndex, edgeListSize, FALSE);
+   return info.graph;
 }
 
 
@@ -88,7 +88,6 @@ ULONG StoreLabel(Label *label, LabelList *labelList)
          default:
             break;  // error
       }
-      labelList->labels[labelList->numLabels].used = FALSE;
       labelList->numLabels++;
    }
    return labelIndex;
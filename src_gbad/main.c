@@ -358,6 +358,9 @@ Parameters *GetParameters(int argc, char *argv[])
    parameters->limit = 0;
    parameters->numBestSubs = 3;
    parameters->beamWidth = 4;
+   parameters->numThreads = 1;
+   parameters->maxMemory = 0;
+   parameters->sampleFraction = 1.0;
    parameters->valueBased = FALSE;
    parameters->prune = FALSE;
    strcpy(parameters->outFileName, "none");
@@ -508,6 +511,30 @@ Parameters *GetParameters(int argc, char *argv[])
          strcpy(parameters->psInputFileName, argv[i]);
          parameters->predefinedSubs = TRUE;
       }
+      else if (strcmp(argv[i], "-maxmem") == 0) 
+      {
+         i++;
+         sscanf(argv[i], "%lu", &ulongArg);
+         if (ulongArg == 0) 
+         {
+            fprintf(stderr, "%s: maxmem must be greater than zero\n",
+                    argv[0]);
+            exit(1);
+         }
+         parameters->maxMemory = ulongArg * 1024 * 1024;
+      }
+      else if (strcmp(argv[i], "-threads") == 0) 
+      {
+         i++;
+         sscanf(argv[i], "%lu", &ulongArg);
+         if (ulongArg == 0) 
+         {
+            fprintf(stderr, "%s: threads must be greater than zero\n",
+                    argv[0]);
+            exit(1);
+         }
+         parameters->numThreads = ulongArg;
+      }
       else if (strcmp(argv[i], "-threshold") == 0) 
       {
          i++;
@@ -678,12 +705,20 @@ Parameters *GetParameters(int argc, char *argv[])
    strcpy(parameters->inputFileName, argv[argc - 1]);
    parameters->labelList = AllocateLabelList();
    parameters->posGraph = NULL;
+   parameters->posGraphVertexListSize = 0;
+   parameters->posGraphEdgeListSize = 0;
+   parameters->posGraphStats = NULL;
+   parameters->workspace = AllocateWorkspace();
+   parameters->matchContext = AllocateMatchContext();
    parameters->numPosEgs = 0;
    parameters->posEgsVertexIndices = NULL;
+   parameters->posVertexExamples = NULL;
 
    ReadInputFile(parameters);
    if (parameters->evalMethod == EVAL_MDL)
    {
+      // fill log2Factorial table up to the largest graph in one pass
+      Log2Factorial(parameters->posGraph->numVertices, parameters);
       parameters->posGraphDL = MDL(parameters->posGraph,
                                   parameters->labelList->numLabels, parameters);
    }
@@ -811,6 +846,11 @@ void PrintParameters(Parameters *parameters)
       PrintBoolean(parameters->optimize);
    }
    printf("  Threshold...................... %lf\n", parameters->threshold);
+   if (parameters->numThreads > 1)
+      printf("  Threads........................ %lu\n", parameters->numThreads);
+   if (parameters->maxMemory > 0)
+      printf("  Max memory (MB)................ %lu\n",
+             parameters->maxMemory / (1024 * 1024));
    printf("  Value-based queue.............. ");
    PrintBoolean(parameters->valueBased);
 ////////////////////////////////// WFE //////////////////////////////////////
@@ -840,8 +880,15 @@ void PrintParameters(Parameters *parameters)
 void FreeParameters(Parameters *parameters)
 {
    FreeGraph(parameters->posGraph);
+   FreeGraphStats(parameters->posGraphStats);
+   FreeWorkspace(parameters->workspace);
+   FreeMatchContext(parameters->matchContext);
    FreeLabelList(parameters->labelList);
+   FreeGraph(parameters->originalPosGraph);
+   if (parameters->originalLabelList != NULL)
+      FreeLabelList(parameters->originalLabelList);
    free(parameters->posEgsVertexIndices);
+   free(parameters->posVertexExamples);
    free(parameters->log2Factorial);
    free(parameters);
 }
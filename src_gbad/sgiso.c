@@ -36,73 +36,197 @@
 //******************************************************************************
 
 InstanceList *FindInstances(Graph *g1, Graph *g2, Parameters *parameters)
+{
+   InstanceList *instanceList;
+   ULONG *edgeOrder;
+   ULONG numEdges;
+   ULONG i;
+
+   edgeOrder = (ULONG *) malloc(sizeof(ULONG) * (g1->numEdges + 1));
+   if (edgeOrder == NULL)
+      OutOfMemoryError("FindInstances:edgeOrder");
+   numEdges = PatternEdgeOrder(g1, edgeOrder);
+
+   instanceList = FindSingleVertexInstances(g2, & g1->vertices[0], parameters);
+   for (i = 0; ((i < numEdges) && (instanceList->head != NULL)); i++)
+   {
+      if ((parameters->numThreads > 1) && (instanceList->numNodes > 1))
+         instanceList = ExtendInstancesInParallel(instanceList, g1,
+                                                  & g1->edges[edgeOrder[i]],
+                                                  g2, parameters);
+      else
+         instanceList = ExtendInstancesByEdge(instanceList, g1,
+                                              & g1->edges[edgeOrder[i]], g2,
+                                              parameters);
+   }
+   free(edgeOrder);
+
+   // filter instances not matching g1
+   // filter overlapping instances if appropriate
+   instanceList = FilterInstances(g1, instanceList, g2, parameters);
+
+   return instanceList;
+}
+
+
+//******************************************************************************
+// NAME: PatternEdgeOrder
+//
+// INPUTS: (Graph *g1) - graph whose instances are to be found
+//         (ULONG *edgeOrder) - set to edges of g1 in order of extension
+//
+// RETURN: (ULONG) - number of edges in edgeOrder
+//
+// PURPOSE: Determines the order in which FindInstances extends instances
+// by the edges of g1.  Starting from vertex 0, each reached vertex is
+// visited in turn, lowest index first, and its edges not yet visited are
+// added in the order of its edge list.  Edges not reachable from vertex 0
+// are left out.
+//******************************************************************************
+
+ULONG PatternEdgeOrder(Graph *g1, ULONG *edgeOrder)
 {
    ULONG v;
    ULONG v1;
    ULONG e1;
    Vertex *vertex1;
    Edge *edge1;
-   InstanceList *instanceList;
    BOOLEAN *reached;
-   BOOLEAN noMatches;
-   BOOLEAN found;
+   BOOLEAN *visited;
+   BOOLEAN *edgeVisited;
+   ULONG numEdges;
 
-   reached = (BOOLEAN *) malloc(sizeof(BOOLEAN) * g1->numVertices);
+   reached = (BOOLEAN *) malloc(sizeof(BOOLEAN) * (2 * g1->numVertices +
+                                                   g1->numEdges));
    if (reached == NULL)
-      OutOfMemoryError("FindInstances:reached");
+      OutOfMemoryError("PatternEdgeOrder:reached");
+   visited = reached + g1->numVertices;
+   edgeVisited = visited + g1->numVertices;
    for (v1 = 0; v1 < g1->numVertices; v1++)
+   {
       reached[v1] = FALSE;
+      visited[v1] = FALSE;
+   }
+   for (e1 = 0; e1 < g1->numEdges; e1++)
+      edgeVisited[e1] = FALSE;
+
+   numEdges = 0;
    v1 = 0; // first vertex in g1
    reached[v1] = TRUE;
    vertex1 = & g1->vertices[v1];
-   instanceList = FindSingleVertexInstances(g2, vertex1, parameters);
-   noMatches = FALSE;
-   if (instanceList->head == NULL) // no matches to vertex1 found in g2
-      noMatches = TRUE;
-   while ((vertex1 != NULL) && (! noMatches)) 
+   while (vertex1 != NULL) 
    {
-      vertex1->used = TRUE;
-      // extend by each unmarked edge involving vertex v1
-      for (e1 = 0; ((e1 < vertex1->numEdges) && (! noMatches)); e1++) 
+      visited[v1] = TRUE;
+      // extend by each unvisited edge involving vertex v1
+      for (e1 = 0; e1 < vertex1->numEdges; e1++) 
       {
-         edge1 = & g1->edges[g1->vertices[v1].edges[e1]];
-         if (! edge1->used) 
+         edge1 = & g1->edges[vertex1->edges[e1]];
+         if (! edgeVisited[vertex1->edges[e1]]) 
          {
             reached[edge1->vertex1] = TRUE;
             reached[edge1->vertex2] = TRUE;
-            instanceList =
-               ExtendInstancesByEdge(instanceList, g1, edge1, g2, parameters);
-            if (instanceList->head == NULL)
-               noMatches = TRUE;
-            edge1->used = TRUE;
+            edgeOrder[numEdges++] = vertex1->edges[e1];
+            edgeVisited[vertex1->edges[e1]] = TRUE;
          }
       }
-      // find next un-used, reached vertex
+      // find next unvisited, reached vertex
       vertex1 = NULL;
-      found = FALSE;
-      for (v = 0; ((v < g1->numVertices) && (! found)); v++) 
+      for (v = 0; ((v < g1->numVertices) && (vertex1 == NULL)); v++) 
       {
-         if ((! g1->vertices[v].used) && (reached[v])) 
+         if ((! visited[v]) && (reached[v])) 
          {
             v1 = v;
             vertex1 = & g1->vertices[v1];
-            found = TRUE;
          }
       }
    }
    free(reached);
+   return numEdges;
+}
 
-   // set used flags to FALSE
-   for (v1 = 0; v1 < g1->numVertices; v1++)
-      g1->vertices[v1].used = FALSE;
-   for (e1 = 0; e1 < g1->numEdges; e1++)
-      g1->edges[e1].used = FALSE;
 
-   // filter instances not matching g1
-   // filter overlapping instances if appropriate
-   instanceList = FilterInstances(g1, instanceList, g2, parameters);
+//******************************************************************************
+// NAME: ExtendInstancesInParallel
+//
+// INPUTS: (InstanceList *instanceList) - instances to extend by one edge
+//         (Graph *g1) - graph whose instances we are looking for
+//         (Edge *edge1) - edge in g1 by which to extend each instance
+//         (Graph *g2) - graph containing instances
+//         (Parameters *parameters)
+//
+// RETURN: (InstanceList *) - new instance list with extended instances
+//
+// PURPOSE: Same as ExtendInstancesByEdge, but with the instances split
+// into chunks (see SplitInstanceList) that parameters->numThreads worker
+// threads extend independently.  The chunks' extensions are then merged
+// by MergeInstanceChunks, so the resulting list is the same as when
+// extending serially.  The given instance list is de-allocated.
+//******************************************************************************
 
-   return instanceList;
+InstanceList *ExtendInstancesInParallel(InstanceList *instanceList,
+                                        Graph *g1, Edge *edge1, Graph *g2,
+                                        Parameters *parameters)
+{
+   InstanceSearchQueue queue;
+   InstanceList *newInstanceList;
+   ULONG numThreads = parameters->numThreads;
+
+   queue.chunks = SplitInstanceList(instanceList, numThreads,
+                                    & queue.numChunks);
+   FreeInstanceList(instanceList);
+   queue.g1 = g1;
+   queue.edge1 = edge1;
+   queue.g2 = g2;
+   queue.nextChunk = 0;
+   queue.parameters = parameters;
+   // build g2's edge type index now, so that workers only read it
+   if (g2->edgeIndex == NULL)
+      IndexEdgeTypes(g2);
+
+   if (numThreads > queue.numChunks)
+      numThreads = queue.numChunks;
+   pthread_mutex_init(& queue.mutex, NULL);
+   RunWorkerThreads(InstanceSearchWorker, & queue, numThreads,
+                    "ExtendInstancesInParallel");
+   pthread_mutex_destroy(& queue.mutex);
+
+   newInstanceList = MergeInstanceChunks(queue.chunks, queue.numChunks);
+   free(queue.chunks);
+   return newInstanceList;
+}
+
+
+//******************************************************************************
+// NAME: InstanceSearchWorker
+//
+// INPUTS: (void *arg) - InstanceSearchQueue shared by workers
+//
+// RETURN: (void *) - NULL
+//
+// PURPOSE: Thread function taking chunks of instances from the queue until
+// none are left, extending each chunk by the queue's edge.
+//******************************************************************************
+
+void *InstanceSearchWorker(void *arg)
+{
+   InstanceSearchQueue *queue = (InstanceSearchQueue *) arg;
+   ULONG c;
+
+   while (TRUE)
+   {
+      pthread_mutex_lock(& queue->mutex);
+      c = queue->nextChunk;
+      if (c < queue->numChunks)
+         queue->nextChunk++;
+      pthread_mutex_unlock(& queue->mutex);
+      if (c >= queue->numChunks)
+         break;
+
+      queue->chunks[c] = ExtendInstancesByEdge(queue->chunks[c], queue->g1,
+                                               queue->edge1, queue->g2,
+                                               queue->parameters);
+   }
+   return NULL;
 }
 
 
@@ -123,21 +247,21 @@ InstanceList *FindInstances(Graph *g1, Graph *g2, Parameters *parameters)
 InstanceList *FindSingleVertexInstances(Graph *graph, Vertex *vertex,
                                         Parameters *parameters)
 {
-   ULONG v;
+   ULONG *vertices;
+   ULONG numVertices;
+   ULONG i;
    InstanceList *instanceList;
    Instance *instance;
 
    instanceList = AllocateInstanceList();
-   for (v = 0; v < graph->numVertices; v++) 
+   vertices = VerticesWithLabel(graph, vertex->label, & numVertices);
+   for (i = 0; i < numVertices; i++) 
    {
-      if (graph->vertices[v].label == vertex->label) 
-      {
-         // ***** do inexact label matches here? (instance->minMatchCost too)
-         instance = AllocateInstance(1, 0);
-         instance->vertices[0] = v;
-         instance->minMatchCost = 0.0;
-         InstanceListInsert(instance, instanceList, FALSE);
-      }
+      // ***** do inexact label matches here? (instance->minMatchCost too)
+      instance = AllocateInstance(1, 0);
+      instance->vertices[0] = vertices[i];
+      instance->minMatchCost = 0.0;
+      InstanceListInsert(instance, instanceList, FALSE);
    }
    return instanceList;
 }
@@ -158,6 +282,9 @@ InstanceList *FindSingleVertexInstances(Graph *graph, Vertex *vertex,
 // edge from graph g2 that matches the attributes of the given edge in
 // graph g1.  Returns a new (possibly empty) instance list containing
 // the extended instances.  The given instance list is de-allocated.
+// Matching edges are looked up in g2's edge type index rather than by
+// calling EdgesMatch on every edge of the instance's vertices.  Nothing in
+// g2 is written, so several threads may extend instances in the same graph.
 //******************************************************************************
 
 InstanceList *ExtendInstancesByEdge(InstanceList *instanceList,
@@ -167,42 +294,62 @@ InstanceList *ExtendInstancesByEdge(InstanceList *instanceList,
    InstanceList *newInstanceList;
    InstanceListNode *instanceListNode;
    Instance *instance;
-   Instance *newInstance;
    ULONG v2;
    ULONG e2;
-   Edge *edge2;
+   ULONG hash;
    Vertex *vertex2;
+   IncidentEdge *edges1 = NULL;
+   IncidentEdge *edges2 = NULL;
+   ULONG numEdges1, numEdges2;
+   ULONG i1, i2;
+   ULONG label11 = g1->vertices[edge1->vertex1].label;
+   ULONG label12 = g1->vertices[edge1->vertex2].label;
 
    newInstanceList = AllocateInstanceList();
+   IndexInstanceList(newInstanceList, INSTANCE_HASH_SIZE);
    // extend each instance
    instanceListNode = instanceList->head;
    while (instanceListNode != NULL) 
    {
       instance = instanceListNode->instance;
-      MarkInstanceEdges(instance, g2, TRUE);
+      hash = InstanceHash(instance);
       // consider extending from each vertex in instance
       for (v2 = 0; v2 < instance->numVertices; v2++) 
       {
          vertex2 = & g2->vertices[instance->vertices[v2]];
-         for (e2 = 0; e2 < vertex2->numEdges; e2++) 
+         // the edges of vertex2 matching edge1 (see EdgesMatch) are of
+         // one type if vertex2 matches edge1's first vertex, and another
+         // if it matches the second; visit both in edge list order
+         numEdges1 = 0;
+         numEdges2 = 0;
+         if (vertex2->label == label11)
+            edges1 = EdgesOfType(g2, instance->vertices[v2], edge1->label,
+                                 edge1->directed, edge1->directed, label12,
+                                 & numEdges1);
+         if ((vertex2->label == label12) &&
+             (edge1->directed || (label11 != label12)))
+            edges2 = EdgesOfType(g2, instance->vertices[v2], edge1->label,
+                                 edge1->directed, FALSE, label11,
+                                 & numEdges2);
+         i1 = 0;
+         i2 = 0;
+         while ((i1 < numEdges1) || (i2 < numEdges2)) 
          {
-            edge2 = & g2->edges[vertex2->edges[e2]];
-            if ((! edge2->used) &&
-                (EdgesMatch(g1, edge1, g2, edge2, parameters))) 
+            if ((i2 == numEdges2) ||
+                ((i1 < numEdges1) &&
+                 (edges1[i1].position < edges2[i2].position)))
+               e2 = edges1[i1++].position;
+            else
+               e2 = edges2[i2++].position;
+            if (! InstanceContainsEdge(instance, vertex2->edges[e2])) 
             {
                // add new instance to list
-               newInstance =
-                  //
-                  // GBAD-P:  Added instance parameter.
-                  //
-                  CreateExtendedInstance(instance, instance->vertices[v2],
-                                         vertex2->edges[e2], g2, FALSE);
-                  //
-               InstanceListInsert(newInstance, newInstanceList, TRUE);
+               InsertExtendedInstance(instance, hash, instance->vertices[v2],
+                                      vertex2->edges[e2], g2,
+                                      newInstanceList, FALSE);
             }
          }
       }
-      MarkInstanceEdges(instance, g2, FALSE);
       instanceListNode = instanceListNode->next;
    }
    FreeInstanceList(instanceList);
@@ -278,13 +425,17 @@ InstanceList *FilterInstances(Graph *subGraph, InstanceList *instanceList,
    InstanceListNode *instanceListNode;
    Instance *instance;
    InstanceList *newInstanceList;
-   Graph *instanceGraph;
-   double thresholdLimit;
+   double *matchCosts;
    double matchCost;
+   ULONG i;
 
    newInstanceList = AllocateInstanceList();
    if (instanceList != NULL) 
    {
+      // match candidates in parallel if possible; overlap is checked below
+      matchCosts = InstanceMatchCosts(subGraph, instanceList, NULL, graph,
+                                      parameters);
+      i = 0;
       instanceListNode = instanceList->head;
       while (instanceListNode != NULL) 
       {
@@ -294,22 +445,202 @@ InstanceList *FilterInstances(Graph *subGraph, InstanceList *instanceList,
             if (parameters->allowInstanceOverlap ||
                 (! InstanceListOverlap(instance, newInstanceList))) 
             {
-               thresholdLimit = parameters->threshold *
-                                (instance->numVertices + instance->numEdges);
-               instanceGraph = InstanceToGraph(instance, graph);
-               if (GraphMatch(subGraph, instanceGraph, parameters->labelList,
-                              thresholdLimit, & matchCost, NULL)) 
+               if (matchCosts != NULL)
+                  matchCost = matchCosts[i];
+               else
+                  matchCost = InstanceMatchCost(subGraph, instance, graph,
+                                                parameters,
+                                                parameters->matchContext);
+               if (matchCost != MAX_DOUBLE)
                {
                   if (matchCost < instance->minMatchCost)
                      instance->minMatchCost = matchCost;
                   InstanceListInsert(instance, newInstanceList, FALSE);
                }
-               FreeGraph(instanceGraph);
             }
+            i++;
          }
          instanceListNode = instanceListNode->next;
       }
+      free(matchCosts);
    }
    FreeInstanceList(instanceList);
    return newInstanceList;
 }
+
+
+//******************************************************************************
+// NAME: InstanceMatchCost
+//
+// INPUTS: (Graph *subGraph) - graph instance must match
+//         (Instance *instance) - candidate instance
+//         (Graph *graph) - graph containing instance
+//         (Parameters *parameters)
+//         (MatchContext *context) - match context to use
+//
+// RETURN: (double) - cost of matching instance to subGraph, or MAX_DOUBLE
+//                    if the cost exceeds the threshold
+//
+// PURPOSE: Matches an instance against subGraph within the threshold
+// allowed for the instance's size.
+//******************************************************************************
+
+double InstanceMatchCost(Graph *subGraph, Instance *instance, Graph *graph,
+                         Parameters *parameters, MatchContext *context)
+{
+   Graph *instanceGraph;
+   double thresholdLimit;
+   double matchCost;
+
+   thresholdLimit = parameters->threshold *
+                    (instance->numVertices + instance->numEdges);
+   instanceGraph = InstanceToMatchGraph(instance, graph, context);
+   if (GraphMatch(subGraph, instanceGraph, parameters->labelList,
+                  thresholdLimit, & matchCost, NULL, context))
+      return matchCost;
+   return MAX_DOUBLE;
+}
+
+
+//******************************************************************************
+// NAME: InstanceMatchCosts
+//
+// INPUTS: (Graph *subGraph) - graph instances must match
+//         (InstanceList *instanceList) - candidate instances
+//         (InstanceList *excludedInstances) - candidates overlapping these
+//                                             are not matched (NULL if none)
+//         (Graph *graph) - graph containing instances
+//         (Parameters *parameters)
+//
+// RETURN: (double *) - match cost of each non-NULL candidate, in list order,
+//                      or NULL if candidates are to be matched serially
+//
+// PURPOSE: Matches the candidate instances against subGraph using
+// parameters->numThreads worker threads.  Candidates that do not match, or
+// that overlap excludedInstances, get a cost of MAX_DOUBLE.  Nothing shared
+// is written by the workers, so the caller inserts the matches afterwards
+// in list order, exactly as if it had matched them itself.  Returns NULL
+// when there is only one thread or too few candidates to be worth it.
+//******************************************************************************
+
+double *InstanceMatchCosts(Graph *subGraph, InstanceList *instanceList,
+                           InstanceList *excludedInstances, Graph *graph,
+                           Parameters *parameters)
+{
+   InstanceMatchQueue queue;
+   InstanceListNode *instanceListNode;
+   pthread_t *threads;
+   ULONG numThreads = parameters->numThreads;
+   ULONG numInstances;
+   ULONG i, t;
+
+   if ((numThreads <= 1) || (instanceList == NULL))
+      return NULL;
+   numInstances = 0;
+   instanceListNode = instanceList->head;
+   while (instanceListNode != NULL)
+   {
+      if (instanceListNode->instance != NULL)
+         numInstances++;
+      instanceListNode = instanceListNode->next;
+   }
+   if (numInstances <= INSTANCE_MATCH_CHUNK)
+      return NULL;
+
+   queue.subGraph = subGraph;
+   queue.graph = graph;
+   queue.numInstances = numInstances;
+   queue.excludedInstances = excludedInstances;
+   queue.nextInstance = 0;
+   queue.parameters = parameters;
+   queue.instances = (Instance **) malloc(sizeof(Instance *) * numInstances);
+   if (queue.instances == NULL)
+      OutOfMemoryError("InstanceMatchCosts:queue.instances");
+   queue.matchCosts = (double *) malloc(sizeof(double) * numInstances);
+   if (queue.matchCosts == NULL)
+      OutOfMemoryError("InstanceMatchCosts:queue.matchCosts");
+   i = 0;
+   instanceListNode = instanceList->head;
+   while (instanceListNode != NULL)
+   {
+      if (instanceListNode->instance != NULL)
+         queue.instances[i++] = instanceListNode->instance;
+      instanceListNode = instanceListNode->next;
+   }
+
+   // compute subGraph's fingerprint and the excluded instances' vertex
+   // set now, so that workers only read them
+   GetGraphFingerprint(subGraph);
+   GraphFingerprintHash(subGraph);
+   if ((excludedInstances != NULL) && (excludedInstances->vertexSet == NULL))
+      IndexInstanceVertices(excludedInstances, VERTEX_SET_SIZE);
+
+   t = (numInstances + INSTANCE_MATCH_CHUNK - 1) / INSTANCE_MATCH_CHUNK;
+   if (numThreads > t)
+      numThreads = t;
+   threads = (pthread_t *) malloc(sizeof(pthread_t) * numThreads);
+   if (threads == NULL)
+      OutOfMemoryError("InstanceMatchCosts:threads");
+   pthread_mutex_init(& queue.mutex, NULL);
+   for (t = 0; t < numThreads; t++)
+      if (pthread_create(& threads[t], NULL, InstanceMatchWorker, & queue) != 0)
+      {
+         fprintf(stderr, "InstanceMatchCosts: unable to create thread\n");
+         exit(1);
+      }
+   for (t = 0; t < numThreads; t++)
+      pthread_join(threads[t], NULL);
+   pthread_mutex_destroy(& queue.mutex);
+   free(threads);
+   free(queue.instances);
+   return queue.matchCosts;
+}
+
+
+//******************************************************************************
+// NAME: InstanceMatchWorker
+//
+// INPUTS: (void *arg) - InstanceMatchQueue shared by workers
+//
+// RETURN: (void *) - NULL
+//
+// PURPOSE: Thread function matching chunks of candidates from the queue
+// until none are left, using its own match context.
+//******************************************************************************
+
+void *InstanceMatchWorker(void *arg)
+{
+   InstanceMatchQueue *queue = (InstanceMatchQueue *) arg;
+   MatchContext *context;
+   Instance *instance;
+   ULONG first, last;
+   ULONG i;
+
+   context = AllocateMatchContext();
+   while (TRUE)
+   {
+      pthread_mutex_lock(& queue->mutex);
+      first = queue->nextInstance;
+      last = first + INSTANCE_MATCH_CHUNK;
+      if (last > queue->numInstances)
+         last = queue->numInstances;
+      queue->nextInstance = last;
+      pthread_mutex_unlock(& queue->mutex);
+      if (first >= last)
+         break;
+
+      for (i = first; i < last; i++)
+      {
+         instance = queue->instances[i];
+         if ((queue->excludedInstances != NULL) &&
+             InstanceListOverlap(instance, queue->excludedInstances))
+            queue->matchCosts[i] = MAX_DOUBLE;
+         else
+            queue->matchCosts[i] =
+               InstanceMatchCost(queue->subGraph, instance, queue->graph,
+                                 queue->parameters, context);
+      }
+   }
+   FreeMatchContext(context);
+   return NULL;
+}
@@ -129,10 +129,11 @@ void SubListInsert(Substructure *sub, SubList *subList, ULONG max,
    subIndex = subList->head;
    while ((subIndex != NULL) && (subIndex->sub->value >= sub->value))
    {
-      if (subIndex->sub->value == sub->value)
+      if ((subIndex->sub->value == sub->value) &&
+          (SubHash(subIndex->sub) == SubHash(sub)))
       {
          if (GraphMatch(subIndex->sub->definition, sub->definition,
-             labelList, 0.0, NULL, NULL))
+             labelList, 0.0, NULL, NULL, NULL))
          {
             FreeSubListNode(newSubListNode);
             return;
@@ -201,6 +202,381 @@ void SubListInsert(Substructure *sub, SubList *subList, ULONG max,
 }
 
 
+//******************************************************************************
+// NAME: AllocateSubBeam
+//
+// INPUTS: (ULONG max) - maximum number of substructures or different
+//                       substructure values kept in beam;
+//                       max = 0 means max = infinity
+//         (BOOLEAN valueBased) - TRUE if beam limited by different
+//                                values; otherwise, limited by
+//                                different substructures
+//
+// RETURN: (SubBeam *) - newly-allocated substructure beam
+//
+// PURPOSE: Allocate and return an empty beam to hold the best
+// substructures, with the same limits as SubListInsert.
+//******************************************************************************
+
+SubBeam *AllocateSubBeam(ULONG max, BOOLEAN valueBased)
+{
+   SubBeam *beam;
+   ULONG i;
+
+   beam = (SubBeam *) malloc(sizeof(SubBeam));
+   if (beam == NULL)
+      OutOfMemoryError("AllocateSubBeam:beam");
+   beam->max = max;
+   beam->valueBased = valueBased;
+   beam->size = LIST_SIZE_INC;
+   beam->numEntries = 0;
+   beam->heap = (SubBeamEntry **) malloc(sizeof(SubBeamEntry *) * beam->size);
+   if (beam->heap == NULL)
+      OutOfMemoryError("AllocateSubBeam:beam->heap");
+   beam->numInserts = 0;
+   beam->numValues = 0;
+   beam->values = NULL;
+   beam->valueCounts = NULL;
+   if (valueBased && (max > 0))
+   {
+      // one extra for a new value about to push out the lowest one
+      beam->values = (double *) malloc(sizeof(double) * (max + 1));
+      beam->valueCounts = (ULONG *) malloc(sizeof(ULONG) * (max + 1));
+      if ((beam->values == NULL) || (beam->valueCounts == NULL))
+         OutOfMemoryError("AllocateSubBeam:beam->values");
+   }
+   beam->numBuckets = SUB_BEAM_HASH_SIZE;
+   beam->buckets = (SubBeamEntry **)
+                   malloc(sizeof(SubBeamEntry *) * beam->numBuckets);
+   if (beam->buckets == NULL)
+      OutOfMemoryError("AllocateSubBeam:beam->buckets");
+   for (i = 0; i < beam->numBuckets; i++)
+      beam->buckets[i] = NULL;
+   beam->bestValue = 0.0;
+   return beam;
+}
+
+
+//******************************************************************************
+// NAME: SubBeamEntryWorse
+//
+// INPUTS: (SubBeamEntry *entry1)
+//         (SubBeamEntry *entry2) - beam entries to compare
+//
+// RETURN: (BOOLEAN) - TRUE if entry1 would be dropped from the beam
+//                     before entry2
+//
+// PURPOSE: Order beam entries by increasing value, and for entries with
+// the same value, by decreasing insertion order.  This is the reverse of
+// the order in which SubListInsert keeps a list, where a substructure goes
+// after those of equal value already there.
+//******************************************************************************
+
+static BOOLEAN SubBeamEntryWorse(SubBeamEntry *entry1, SubBeamEntry *entry2)
+{
+   if (entry1->sub->value != entry2->sub->value)
+      return (entry1->sub->value < entry2->sub->value);
+   return (entry1->order > entry2->order);
+}
+
+
+//******************************************************************************
+// NAME: IndexSubBeam
+//
+// INPUTS: (SubBeam *beam) - beam to be indexed
+//         (ULONG numBuckets) - number of buckets in new index
+//
+// RETURN: (void)
+//
+// PURPOSE: Rebuild the hash index of the entries in the beam with the
+// given number of buckets.
+//******************************************************************************
+
+void IndexSubBeam(SubBeam *beam, ULONG numBuckets)
+{
+   ULONG i;
+   ULONG bucket;
+   SubBeamEntry *entry;
+
+   free(beam->buckets);
+   beam->buckets = (SubBeamEntry **) malloc(sizeof(SubBeamEntry *) * numBuckets);
+   if (beam->buckets == NULL)
+      OutOfMemoryError("IndexSubBeam:beam->buckets");
+   beam->numBuckets = numBuckets;
+   for (i = 0; i < numBuckets; i++)
+      beam->buckets[i] = NULL;
+   for (i = 0; i < beam->numEntries; i++)
+   {
+      entry = beam->heap[i];
+      bucket = entry->hash % numBuckets;
+      entry->nextInBucket = beam->buckets[bucket];
+      beam->buckets[bucket] = entry;
+   }
+}
+
+
+//******************************************************************************
+// NAME: RemoveWorstSubBeamEntry
+//
+// INPUTS: (SubBeam *beam) - non-empty beam
+//
+// RETURN: (void)
+//
+// PURPOSE: Remove the worst entry from the top of the beam's heap and from
+// its hash index, and destroy its substructure.  The different values of
+// a value-based beam are left for the caller to update.
+//******************************************************************************
+
+void RemoveWorstSubBeamEntry(SubBeam *beam)
+{
+   SubBeamEntry *worst;
+   SubBeamEntry *last;
+   SubBeamEntry **bucketEntry;
+   ULONG parent;
+   ULONG child;
+   BOOLEAN done;
+
+   worst = beam->heap[0];
+   bucketEntry = & beam->buckets[worst->hash % beam->numBuckets];
+   while (*bucketEntry != worst)
+      bucketEntry = & (*bucketEntry)->nextInBucket;
+   *bucketEntry = worst->nextInBucket;
+   FreeSub(worst->sub);
+   free(worst);
+
+   // move last entry down from the top to its place
+   beam->numEntries--;
+   if (beam->numEntries == 0)
+      return;
+   last = beam->heap[beam->numEntries];
+   parent = 0;
+   done = FALSE;
+   while (! done)
+   {
+      child = HeapLeftChild(parent);
+      if (child >= beam->numEntries)
+         done = TRUE;
+      else
+      {
+         if ((child + 1 < beam->numEntries) &&
+             SubBeamEntryWorse(beam->heap[child + 1], beam->heap[child]))
+            child++;
+         if (SubBeamEntryWorse(beam->heap[child], last))
+         {
+            beam->heap[parent] = beam->heap[child];
+            parent = child;
+         }
+         else
+            done = TRUE;
+      }
+   }
+   beam->heap[parent] = last;
+}
+
+
+//******************************************************************************
+// NAME: SubBeamInsert
+//
+// INPUTS: (Substructure *sub) - substructure to be inserted
+//         (SubBeam *beam) - beam to be inserted in to
+//         (LabelList *labelList) - needed for checking sub equality
+//
+// RETURN: (void)
+//
+// PURPOSE: Inserts sub into beam, if not already there, keeping the same
+// substructures SubListInsert would keep on a list with the beam's
+// limits.  A sub that could not stay in a full beam is rejected before
+// looking for duplicates; otherwise, duplicates are looked up in the hash
+// index.  If sub is not inserted, then it is destroyed.
+//******************************************************************************
+
+void SubBeamInsert(Substructure *sub, SubBeam *beam, LabelList *labelList)
+{
+   SubBeamEntry *entry;
+   ULONG hash;
+   ULONG bucket;
+   ULONG i;
+   ULONG parent;
+   double value = sub->value;
+   double lowestValue;
+   BOOLEAN done;
+
+   // reject sub if it would fall off a full beam
+   if ((beam->max > 0) && (beam->numEntries > 0))
+   {
+      if ((! beam->valueBased) && (beam->numEntries >= beam->max) &&
+          (value <= beam->heap[0]->sub->value))
+      {
+         FreeSub(sub);
+         return;
+      }
+      if ((beam->valueBased) && (beam->numValues >= beam->max) &&
+          (value < beam->values[beam->numValues - 1]))
+      {
+         FreeSub(sub);
+         return;
+      }
+   }
+
+   // if sub already in beam, destroy and exit
+   hash = SubHash(sub);
+   entry = beam->buckets[hash % beam->numBuckets];
+   while (entry != NULL)
+   {
+      if ((entry->hash == hash) &&
+          (entry->sub->value == value) &&
+          GraphMatch(entry->sub->definition, sub->definition,
+                     labelList, 0.0, NULL, NULL, NULL))
+      {
+         FreeSub(sub);
+         return;
+      }
+      entry = entry->nextInBucket;
+   }
+
+   // sub is unique, so add it to the heap and the index
+   entry = (SubBeamEntry *) malloc(sizeof(SubBeamEntry));
+   if (entry == NULL)
+      OutOfMemoryError("SubBeamInsert:entry");
+   entry->sub = sub;
+   entry->order = beam->numInserts;
+   entry->hash = hash;
+   beam->numInserts++;
+   if ((beam->numEntries == 0) || (value > beam->bestValue))
+      beam->bestValue = value;
+   if (beam->numEntries == beam->size)
+   {
+      beam->size = 2 * beam->size;
+      beam->heap = (SubBeamEntry **)
+                   realloc(beam->heap, sizeof(SubBeamEntry *) * beam->size);
+      if (beam->heap == NULL)
+         OutOfMemoryError("SubBeamInsert:beam->heap");
+   }
+   i = beam->numEntries;
+   beam->numEntries++;
+   done = FALSE;
+   while ((i > 0) && (! done))
+   {
+      parent = HeapParent(i);
+      if (SubBeamEntryWorse(entry, beam->heap[parent]))
+      {
+         beam->heap[i] = beam->heap[parent];
+         i = parent;
+      }
+      else
+         done = TRUE;
+   }
+   beam->heap[i] = entry;
+   if (beam->numEntries > (2 * beam->numBuckets))
+      IndexSubBeam(beam, 2 * beam->numBuckets);
+   else
+   {
+      bucket = hash % beam->numBuckets;
+      entry->nextInBucket = beam->buckets[bucket];
+      beam->buckets[bucket] = entry;
+   }
+
+   // check maximums
+   if (beam->max == 0)
+      return;
+   if (! beam->valueBased)
+   {
+      if (beam->numEntries > beam->max)
+         RemoveWorstSubBeamEntry(beam);
+      return;
+   }
+   // count sub's value among the different values, in decreasing order
+   i = 0;
+   while ((i < beam->numValues) && (beam->values[i] > value))
+      i++;
+   if ((i < beam->numValues) && (beam->values[i] == value))
+   {
+      beam->valueCounts[i]++;
+      return;
+   }
+   memmove(& beam->values[i + 1], & beam->values[i],
+           sizeof(double) * (beam->numValues - i));
+   memmove(& beam->valueCounts[i + 1], & beam->valueCounts[i],
+           sizeof(ULONG) * (beam->numValues - i));
+   beam->values[i] = value;
+   beam->valueCounts[i] = 1;
+   beam->numValues++;
+   if (beam->numValues > beam->max)
+   {
+      // too many different values, so drop all subs with the lowest one
+      beam->numValues--;
+      lowestValue = beam->values[beam->numValues];
+      for (i = 0; i < beam->valueCounts[beam->numValues]; i++)
+      {
+         if (beam->heap[0]->sub->value == lowestValue)
+            RemoveWorstSubBeamEntry(beam);
+      }
+   }
+}
+
+
+//******************************************************************************
+// NAME: CompareSubBeamEntries
+//
+// INPUTS: (const void *p1)
+//         (const void *p2) - pointers to beam entries to compare
+//
+// RETURN: (int) - negative if entry p1 comes first on a list
+//
+// PURPOSE: qsort comparison ordering beam entries from best to worst.
+//******************************************************************************
+
+static int CompareSubBeamEntries(const void *p1, const void *p2)
+{
+   SubBeamEntry *entry1 = *((SubBeamEntry **) p1);
+   SubBeamEntry *entry2 = *((SubBeamEntry **) p2);
+
+   if (SubBeamEntryWorse(entry2, entry1))
+      return -1;
+   if (SubBeamEntryWorse(entry1, entry2))
+      return 1;
+   return 0;
+}
+
+
+//******************************************************************************
+// NAME: SubBeamToList
+//
+// INPUTS: (SubBeam *beam) - beam of substructures
+//
+// RETURN: (SubList *) - substructures of beam
+//
+// PURPOSE: Return the substructures of the beam on a list, in the order
+// SubListInsert would have kept them, and free the beam.
+//******************************************************************************
+
+SubList *SubBeamToList(SubBeam *beam)
+{
+   SubList *subList;
+   SubListNode *subListNode;
+   ULONG i;
+
+   subList = AllocateSubList();
+   qsort(beam->heap, beam->numEntries, sizeof(SubBeamEntry *),
+         CompareSubBeamEntries);
+   i = beam->numEntries;
+   while (i > 0)
+   {
+      i--;
+      subListNode = AllocateSubListNode(beam->heap[i]->sub);
+      subListNode->next = subList->head;
+      subList->head = subListNode;
+      free(beam->heap[i]);
+   }
+   free(beam->heap);
+   free(beam->values);
+   free(beam->valueCounts);
+   free(beam->buckets);
+   free(beam);
+   return subList;
+}
+
+
 //******************************************************************************
 // NAME: MemberOfSubList
 //
@@ -211,7 +587,8 @@ void SubListInsert(Substructure *sub, SubList *subList, ULONG max,
 // RETURN: (BOOLEAN)
 //
 // PURPOSE: Check if the given substructure's definition graph exactly
-// matches a definition of a substructure on the subList.
+// matches a definition of a substructure on the subList.  Only
+// substructures with the same definition hash are actually matched.
 //******************************************************************************
 
 BOOLEAN MemberOfSubList(Substructure *sub, SubList *subList,
@@ -225,8 +602,9 @@ BOOLEAN MemberOfSubList(Substructure *sub, SubList *subList,
       subListNode = subList->head;
       while ((subListNode != NULL) && (! found)) 
       {
-         if (GraphMatch(sub->definition, subListNode->sub->definition,
-                        labelList, 0.0, NULL, NULL))
+         if ((SubHash(subListNode->sub) == SubHash(sub)) &&
+             GraphMatch(sub->definition, subListNode->sub->definition,
+                        labelList, 0.0, NULL, NULL, NULL))
             found = TRUE;
          subListNode = subListNode->next;
       }
@@ -330,11 +708,31 @@ Substructure *AllocateSub()
    sub->value = -1.0;
    sub->parentInstances = NULL;
    sub->numParentInstances = 0;
+   sub->instanceScale = 1.0;
 
    return sub;
 }
 
 
+//******************************************************************************
+// NAME: SubHash
+//
+// INPUTS: (Substructure *sub)
+//
+// RETURN: (ULONG) - hash of substructure's definition
+//
+// PURPOSE: Return the isomorphism-invariant hash of the substructure's
+// definition, which is cached in the definition's fingerprint.
+// Substructures whose hashes differ can never be an exact match of each
+// other.
+//******************************************************************************
+
+ULONG SubHash(Substructure *sub)
+{
+   return GraphFingerprintHash(sub->definition);
+}
+
+
 //******************************************************************************
 // NAME: FreeSub
 //
@@ -382,11 +780,16 @@ void PrintSub(Substructure *sub, Parameters *parameters)
       if (outputLevel > 2) 
       {
          printf("\n                  pos instances = %lu",sub->numInstances);
+         if (sub->instanceScale > 1.0)
+            printf(" (sampled, 1 in %.2f)", sub->instanceScale);
          printf(", examples = %lu\n",sub->numExamples);
       } 
       else 
       {
-         printf(", instances = %lu\n", sub->numInstances);
+         printf(", instances = %lu", sub->numInstances);
+         if (sub->instanceScale > 1.0)
+            printf(" (sampled, 1 in %.2f)", sub->instanceScale);
+         printf("\n");
       }
       // print subgraph
       if (sub->definition != NULL) 
@@ -407,22 +810,21 @@ void PrintSub(Substructure *sub, Parameters *parameters)
 // NAME: PrintNewBestSub
 //
 // INPUTS: (Substructure *sub) - possibly new best substructure
-//         (SubList *subList) - list of best substructures
+//         (SubBeam *beam) - beam of best substructures
 //         (Parameters *parameters)
 //
 // RETURN: (void)
 //
-// PURPOSE: If sub is better than the best substructure on subList, then
+// PURPOSE: If sub is better than the best substructure in beam, then
 // print it.  This should be called only if outputLevel > 3.
 //******************************************************************************
 
-void PrintNewBestSub(Substructure *sub, SubList *subList,
+void PrintNewBestSub(Substructure *sub, SubBeam *beam,
                      Parameters *parameters)
 {
    ULONG outputLevel = parameters->outputLevel;
 
-   if ((subList->head == NULL) ||
-       (sub->value > subList->head->sub->value)) 
+   if ((beam->numEntries == 0) || (sub->value > beam->bestValue)) 
    {
       parameters->outputLevel = 1; // turn off instance printing
       printf("\nNew best ");
@@ -565,6 +967,8 @@ InstanceListNode *AllocateInstanceListNode(Instance *instance)
    instanceListNode->instance = instance;
    instance->refCount++;
    instanceListNode->next = NULL;
+   instanceListNode->hash = 0;
+   instanceListNode->nextInBucket = NULL;
    return instanceListNode;
 }
 
@@ -609,6 +1013,12 @@ InstanceList *AllocateInstanceList(void)
    if (instanceList == NULL)
       OutOfMemoryError("AllocateInstanceList:instanceList");
    instanceList->head = NULL;
+   instanceList->numNodes = 0;
+   instanceList->numBuckets = 0;
+   instanceList->buckets = NULL;
+   instanceList->vertexSetSize = 0;
+   instanceList->numSetVertices = 0;
+   instanceList->vertexSet = NULL;
    return instanceList;
 }
 
@@ -637,52 +1047,137 @@ void FreeInstanceList(InstanceList *instanceList)
          instanceListNode = instanceListNode->next;
          FreeInstanceListNode(instanceListNode2);
       }
+      free(instanceList->buckets);
+      free(instanceList->vertexSet);
       free(instanceList);
    }
 }
 
 
+//******************************************************************************
+// NAME: InstanceBytes
+//
+// INPUTS: (ULONG numVertices) - number of vertices in instance
+//         (ULONG numEdges) - number of edges in instance
+//
+// RETURN: (ULONG) - estimated bytes held by such an instance on a list
+//
+// PURPOSE: Estimate the memory taken by an instance with the given number
+// of vertices and edges, including its mapping and list node; used by
+// memory-bounded discovery (-maxmem).
+//******************************************************************************
+
+ULONG InstanceBytes(ULONG numVertices, ULONG numEdges)
+{
+   return sizeof(Instance) + sizeof(InstanceListNode) +
+          (numVertices * (sizeof(ULONG) + sizeof(VertexMap))) +
+          (numEdges * sizeof(ULONG));
+}
+
+
+//******************************************************************************
+// NAME: InstanceListBytes
+//
+// INPUTS: (InstanceList *instanceList)
+//
+// RETURN: (ULONG) - estimated bytes held by instance list
+//
+// PURPOSE: Estimate the memory taken by an instance list, its instances and
+// its indexes.  Instances shared with other lists are counted on each.
+//******************************************************************************
+
+ULONG InstanceListBytes(InstanceList *instanceList)
+{
+   InstanceListNode *instanceListNode;
+   Instance *instance;
+   ULONG bytes = 0;
+
+   if (instanceList != NULL)
+   {
+      bytes = sizeof(InstanceList) +
+              (instanceList->numBuckets * sizeof(InstanceListNode *)) +
+              (instanceList->vertexSetSize * sizeof(ULONG));
+      instanceListNode = instanceList->head;
+      while (instanceListNode != NULL)
+      {
+         instance = instanceListNode->instance;
+         bytes += InstanceBytes(instance->numVertices, instance->numEdges);
+         instanceListNode = instanceListNode->next;
+      }
+   }
+   return bytes;
+}
+
+
 //******************************************************************************
 // NAME: MarkInstanceVertices
 //
-// INPUTS: (Instance *instance) - instance whose vertices to set
-//         (Graph *graph) - graph containing instance
-//         (BOOLEAN value) - value to set edge's used flag
+// INPUTS: (Instance *instance) - instance whose vertices to mark
+//         (Workspace *workspace) - marks on graph containing instance
 //
 // RETURN: (void)
 //
-// PURPOSE: Set the used flag to the given value for each vertex in
-// instance.
+// PURPOSE: Mark each vertex in instance in the workspace's current epoch.
 //******************************************************************************
 
-void MarkInstanceVertices(Instance *instance, Graph *graph, BOOLEAN value)
+void MarkInstanceVertices(Instance *instance, Workspace *workspace)
 {
    ULONG v;
 
    for (v = 0; v < instance->numVertices; v++)
-      graph->vertices[instance->vertices[v]].used = value;
+      MARK_VERTEX(workspace, instance->vertices[v]);
 }
 
 
 //******************************************************************************
 // NAME: MarkInstanceEdges
 //
-// INPUTS: (Instance *instance) - instance whose edges to set
-//         (Graph *graph) - graph containing instance
-//         (BOOLEAN value) - value to set edge's used flag
+// INPUTS: (Instance *instance) - instance whose edges to mark
+//         (Workspace *workspace) - marks on graph containing instance
 //
 // RETURN: (void)
 //
-// PURPOSE: Set the used flag to the given value for each edge in
-// instance.
+// PURPOSE: Mark each edge in instance in the workspace's current epoch.
 //******************************************************************************
 
-void MarkInstanceEdges(Instance *instance, Graph *graph, BOOLEAN value)
+void MarkInstanceEdges(Instance *instance, Workspace *workspace)
 {
    ULONG e;
 
    for (e = 0; e < instance->numEdges; e++)
-      graph->edges[instance->edges[e]].used = value;
+      MARK_EDGE(workspace, instance->edges[e]);
+}
+
+
+//******************************************************************************
+// NAME: InstanceContainsEdge
+//
+// INPUTS: (Instance *instance)
+//         (ULONG edgeIndex) - index of edge in graph containing instance
+//
+// RETURN: (BOOLEAN) - TRUE if edge is one of instance's edges
+//
+// PURPOSE: Check for an edge in the instance by binary search on its
+// ordered edges array, without marking the graph.
+//******************************************************************************
+
+BOOLEAN InstanceContainsEdge(Instance *instance, ULONG edgeIndex)
+{
+   ULONG low = 0;
+   ULONG high = instance->numEdges;
+   ULONG middle;
+
+   while (low < high)
+   {
+      middle = low + ((high - low) / 2);
+      if (instance->edges[middle] == edgeIndex)
+         return TRUE;
+      if (instance->edges[middle] < edgeIndex)
+         low = middle + 1;
+      else
+         high = middle;
+   }
+   return FALSE;
 }
 
 
@@ -770,7 +1265,7 @@ void PrintPosInstanceList(Substructure *sub, Parameters *parameters)
    // parameters used
    Graph *posGraph = parameters->posGraph;
    ULONG numPosEgs = parameters->numPosEgs;
-   ULONG *posEgsVertexIndices = parameters->posEgsVertexIndices;
+   ULONG *posVertexExamples = parameters->posVertexExamples;
    LabelList *labelList = parameters->labelList;
 
    if (sub->instances != NULL) 
@@ -783,7 +1278,7 @@ void PrintPosInstanceList(Substructure *sub, Parameters *parameters)
          if (numPosEgs > 1) 
          {
             posEgNo = InstanceExampleNumber(instanceListNode->instance,
-                                            posEgsVertexIndices, numPosEgs);
+                                            posVertexExamples);
             printf(" in positive example %lu:\n", posEgNo);
          } 
          else 
@@ -800,26 +1295,18 @@ void PrintPosInstanceList(Substructure *sub, Parameters *parameters)
 // NAME: InstanceExampleNumber
 //
 // INPUTS: (Instance *instance) - instance to look for
-//         (ULONG *egsVertexIndices) - vertex indices of graph's examples
-//         (ULONG numEgs) - number of graph examples
+//         (ULONG *vertexExamples) - example number of each graph vertex
+//                                   (see IndexPosExamples)
 //
 // RETURN: (ULONG) - example number containing instance
 //
 // PURPOSE: Return which example contains the given instance.
 //******************************************************************************
 
-ULONG InstanceExampleNumber(Instance *instance, ULONG *egsVertexIndices,
-                            ULONG numEgs)
+ULONG InstanceExampleNumber(Instance *instance, ULONG *vertexExamples)
 {
-   ULONG instanceVertexIndex;
-   ULONG egNo;
-
-   instanceVertexIndex = instance->vertices[0];
-   egNo = 1;
-   while ((egNo < numEgs) && (instanceVertexIndex >= egsVertexIndices[egNo]))
-      egNo++;
-
-   return egNo;
+   // can check any instance vertex, so use the first
+   return vertexExamples[instance->vertices[0]];
 }
 
 
@@ -864,23 +1351,184 @@ ULONG CountInstances(InstanceList *instanceList)
 // PURPOSE: Insert given instance on to given instance list.  If
 // unique=TRUE, then instance must not already exist on list, and if
 // so, it is deallocated.  If unique=FALSE, then instance is merely
-// inserted at the head of the instance list.
+// inserted at the head of the instance list.  The first unique insert
+// builds a hash index over the list, which is then kept up to date by
+// all later inserts, so that the uniqueness check only has to compare
+// instances that hash to the same bucket.  The list's vertex set, if
+// built, is likewise kept up to date.
 //******************************************************************************
 
 void InstanceListInsert(Instance *instance, InstanceList *instanceList,
                         BOOLEAN unique)
+{
+   ULONG hash = 0;
+
+   if (unique && (instanceList->buckets == NULL))
+      IndexInstanceList(instanceList, INSTANCE_HASH_SIZE);
+
+   if ((instanceList->buckets != NULL) && (instance != NULL))
+      hash = InstanceHash(instance);
+   if (unique && MemberOfInstanceIndex(instance, hash, instanceList))
+      FreeInstance(instance);
+   else
+      InstanceListInsertHashed(instance, hash, instanceList);
+}
+
+
+//******************************************************************************
+// NAME: InstanceListInsertHashed
+//
+// INPUTS: (Instance *instance) - instance to insert
+//         (ULONG hash) - InstanceHash of instance, if list is indexed
+//         (InstanceList *instanceList) - list to insert into
+//
+// RETURN: (void)
+//
+// PURPOSE: Insert given instance at the head of the given instance list,
+// and into its hash index and vertex set, if built, without checking if
+// it is already there.
+//******************************************************************************
+
+void InstanceListInsertHashed(Instance *instance, ULONG hash,
+                              InstanceList *instanceList)
 {
    InstanceListNode *instanceListNode;
+   ULONG bucket;
+   ULONG v;
 
-   if ((! unique) ||
-       (unique && (! MemberOfInstanceList(instance, instanceList)))) 
+   instanceListNode = AllocateInstanceListNode(instance);
+   instanceListNode->next = instanceList->head;
+   instanceListNode->hash = hash;
+   instanceList->head = instanceListNode;
+   instanceList->numNodes++;
+   if (instanceList->buckets != NULL)
    {
-      instanceListNode = AllocateInstanceListNode(instance);
-      instanceListNode->next = instanceList->head;
-      instanceList->head = instanceListNode;
-   } 
-   else 
-      FreeInstance(instance);
+      // grow index when average bucket holds more than two instances
+      if (instanceList->numNodes > (2 * instanceList->numBuckets))
+         IndexInstanceList(instanceList, 2 * instanceList->numBuckets);
+      else
+      {
+         bucket = hash % instanceList->numBuckets;
+         instanceListNode->nextInBucket = instanceList->buckets[bucket];
+         instanceList->buckets[bucket] = instanceListNode;
+      }
+   }
+   if ((instanceList->vertexSet != NULL) && (instance != NULL))
+      for (v = 0; v < instance->numVertices; v++)
+         AddVertexToSet(instanceList, instance->vertices[v]);
+}
+
+
+//******************************************************************************
+// NAME: SplitInstanceList
+//
+// INPUTS: (InstanceList *instanceList) - instances to be split
+//         (ULONG numThreads) - number of worker threads
+//         (ULONG *numChunks) - returns number of chunks
+//
+// RETURN: (InstanceList **) - newly-allocated array of chunks
+//
+// PURPOSE: Split the instances into up to EXTEND_CHUNKS_PER_THREAD chunks
+// of about the same size per worker thread, for the workers to extend
+// independently.  Each chunk is a new list holding consecutive instances,
+// in list order; the given instance list is left as is.
+//******************************************************************************
+
+InstanceList **SplitInstanceList(InstanceList *instanceList, ULONG numThreads,
+                                 ULONG *numChunks)
+{
+   InstanceListNode *instanceListNode;
+   InstanceList **chunks;
+   Instance **instances;
+   ULONG numInstances;
+   ULONG chunkSize;
+   ULONG c, i;
+
+   numInstances = instanceList->numNodes;
+   instances = (Instance **) malloc(sizeof(Instance *) * (numInstances + 1));
+   if (instances == NULL)
+      OutOfMemoryError("SplitInstanceList:instances");
+   i = 0;
+   instanceListNode = instanceList->head;
+   while (instanceListNode != NULL)
+   {
+      instances[i++] = instanceListNode->instance;
+      instanceListNode = instanceListNode->next;
+   }
+   *numChunks = numThreads * EXTEND_CHUNKS_PER_THREAD;
+   if (*numChunks > numInstances)
+      *numChunks = numInstances;
+   chunkSize = (numInstances + *numChunks - 1) / *numChunks;
+   *numChunks = (numInstances + chunkSize - 1) / chunkSize;
+   chunks = (InstanceList **) malloc(sizeof(InstanceList *) * (*numChunks));
+   if (chunks == NULL)
+      OutOfMemoryError("SplitInstanceList:chunks");
+   for (c = 0; c < *numChunks; c++)
+   {
+      chunks[c] = AllocateInstanceList();
+      i = (c + 1) * chunkSize;
+      if (i > numInstances)
+         i = numInstances;
+      while (i > c * chunkSize)
+      {
+         i--;
+         InstanceListInsert(instances[i], chunks[c], FALSE);
+      }
+   }
+   free(instances);
+   return chunks;
+}
+
+
+//******************************************************************************
+// NAME: MergeInstanceChunks
+//
+// INPUTS: (InstanceList **chunks) - extensions of each chunk of instances
+//         (ULONG numChunks) - number of chunks
+//
+// RETURN: (InstanceList *) - new instance list with all extensions
+//
+// PURPOSE: Merge the extensions that worker threads found for the chunks
+// made by SplitInstanceList into one list, in the order they would have
+// been created serially.  Each chunk's list holds its extensions in
+// reverse order of creation, and is inserted into the new list in
+// creation order, dropping those already found from an earlier chunk, so
+// the resulting list is the same as when extending serially.  The chunks'
+// lists are de-allocated, but not the array.
+//******************************************************************************
+
+InstanceList *MergeInstanceChunks(InstanceList **chunks, ULONG numChunks)
+{
+   InstanceListNode *instanceListNode;
+   InstanceList *newInstanceList;
+   Instance **instances = NULL;
+   ULONG numInstances;
+   ULONG c, i;
+
+   newInstanceList = AllocateInstanceList();
+   for (c = 0; c < numChunks; c++)
+   {
+      numInstances = chunks[c]->numNodes;
+      instances = (Instance **)
+         realloc(instances, sizeof(Instance *) * (numInstances + 1));
+      if (instances == NULL)
+         OutOfMemoryError("MergeInstanceChunks:instances");
+      i = 0;
+      instanceListNode = chunks[c]->head;
+      while (instanceListNode != NULL)
+      {
+         instances[i++] = instanceListNode->instance;
+         instanceListNode = instanceListNode->next;
+      }
+      while (i > 0)
+      {
+         i--;
+         InstanceListInsert(instances[i], newInstanceList, TRUE);
+      }
+      FreeInstanceList(chunks[c]);
+   }
+   free(instances);
+   return newInstanceList;
 }
 
 
@@ -893,7 +1541,8 @@ void InstanceListInsert(Instance *instance, InstanceList *instanceList,
 // RETURN: (BOOLEAN)
 //
 // PURPOSE: Check if the given instance exactly matches an instance
-// already on the given instance list.
+// already on the given instance list.  If the list has a hash index,
+// then only the instances in the matching bucket are compared.
 //******************************************************************************
 
 BOOLEAN MemberOfInstanceList(Instance *instance, InstanceList *instanceList)
@@ -903,17 +1552,221 @@ BOOLEAN MemberOfInstanceList(Instance *instance, InstanceList *instanceList)
 
    if (instanceList != NULL) 
    {
-      instanceListNode = instanceList->head;
-      while ((instanceListNode != NULL) && (! found)) 
+      if (instanceList->buckets != NULL)
+         found = MemberOfInstanceIndex(instance, InstanceHash(instance),
+                                       instanceList);
+      else
       {
-         if (InstanceMatch(instance, instanceListNode->instance))
-            found = TRUE;
-         instanceListNode = instanceListNode->next;
+         instanceListNode = instanceList->head;
+         while ((instanceListNode != NULL) && (! found)) 
+         {
+            if (InstanceMatch(instance, instanceListNode->instance))
+               found = TRUE;
+            instanceListNode = instanceListNode->next;
+         }
       }
    }
    return found;
 }
 
+
+//******************************************************************************
+// NAME: MemberOfInstanceIndex
+//
+// INPUTS: (Instance *instance)
+//         (ULONG hash) - InstanceHash of instance
+//         (InstanceList *instanceList) - list with hash index
+//
+// RETURN: (BOOLEAN)
+//
+// PURPOSE: Check if the given instance exactly matches an instance in
+// its bucket of the list's hash index.
+//******************************************************************************
+
+BOOLEAN MemberOfInstanceIndex(Instance *instance, ULONG hash,
+                              InstanceList *instanceList)
+{
+   InstanceListNode *instanceListNode;
+
+   instanceListNode = instanceList->buckets[hash % instanceList->numBuckets];
+   while (instanceListNode != NULL)
+   {
+      if ((instanceListNode->hash == hash) &&
+          InstanceMatch(instance, instanceListNode->instance))
+         return TRUE;
+      instanceListNode = instanceListNode->nextInBucket;
+   }
+   return FALSE;
+}
+
+
+//******************************************************************************
+// NAME: InstanceHash
+//
+// INPUTS: (Instance *instance)
+//
+// RETURN: (ULONG) - hash value of instance
+//
+// PURPOSE: Compute a hash value from the instance's edge and vertex
+// indices.  Instances that are equal according to InstanceMatch always
+// have the same hash value.  The hash is a sum of mixed indices, so
+// the hash of an extended instance follows from the hash of the instance
+// it extends (see ExtendedInstanceHash).
+//******************************************************************************
+
+ULONG InstanceHash(Instance *instance)
+{
+   ULONG i;
+   ULONG hash = 0;
+
+   for (i = 0; i < instance->numEdges; i++)
+      hash += MixHash(2 * instance->edges[i]);
+   for (i = 0; i < instance->numVertices; i++)
+      hash += MixHash((2 * instance->vertices[i]) + 1);
+
+   return hash;
+}
+
+
+//******************************************************************************
+// NAME: ExtendedInstanceHash
+//
+// INPUTS: (ULONG hash) - InstanceHash of an instance
+//         (ULONG e) - edge added to instance
+//         (ULONG v) - vertex added to instance, or VERTEX_UNMAPPED if
+//                     the edge adds no vertex
+//
+// RETURN: (ULONG) - InstanceHash of extended instance
+//
+// PURPOSE: Compute the hash of an instance extended by one edge, and
+// possibly one vertex, from the hash of the instance.
+//******************************************************************************
+
+ULONG ExtendedInstanceHash(ULONG hash, ULONG e, ULONG v)
+{
+   hash += MixHash(2 * e);
+   if (v != VERTEX_UNMAPPED)
+      hash += MixHash((2 * v) + 1);
+   return hash;
+}
+
+
+//******************************************************************************
+// NAME: ExtensionOnInstanceList
+//
+// INPUTS: (Instance *instance) - instance being extended
+//         (ULONG e) - edge added to instance
+//         (ULONG v) - vertex added to instance, or VERTEX_UNMAPPED
+//         (ULONG hash) - ExtendedInstanceHash of extended instance
+//         (InstanceList *instanceList) - list with hash index
+//
+// RETURN: (BOOLEAN) - TRUE if extended instance already on list
+//
+// PURPOSE: Check if the instance extended by edge e, and vertex v if
+// mapped, is on the list, without creating the extended instance.  An
+// instance on the list is the extension if it has exactly the elements
+// of the instance plus the added ones.  NOTE: instance vertices and edges
+// arrays are assumed to be in increasing order.
+//******************************************************************************
+
+BOOLEAN ExtensionOnInstanceList(Instance *instance, ULONG e, ULONG v,
+                                ULONG hash, InstanceList *instanceList)
+{
+   InstanceListNode *instanceListNode;
+   Instance *instance2;
+   ULONG numVertices = instance->numVertices;
+   ULONG i;
+   ULONG j;
+   BOOLEAN same;
+
+   if (v != VERTEX_UNMAPPED)
+      numVertices++;
+   instanceListNode = instanceList->buckets[hash % instanceList->numBuckets];
+   while (instanceListNode != NULL)
+   {
+      instance2 = instanceListNode->instance;
+      if ((instanceListNode->hash == hash) &&
+          (instance2->numEdges == instance->numEdges + 1) &&
+          (instance2->numVertices == numVertices))
+      {
+         // compare, skipping the added edge and vertex in instance2
+         same = TRUE;
+         j = 0;
+         for (i = 0; ((i < instance2->numEdges) && same); i++)
+         {
+            if (instance2->edges[i] != e)
+            {
+               if ((j == instance->numEdges) ||
+                   (instance2->edges[i] != instance->edges[j]))
+                  same = FALSE;
+               j++;
+            }
+         }
+         if (j != instance->numEdges)
+            same = FALSE;
+         j = 0;
+         for (i = 0; ((i < instance2->numVertices) && same); i++)
+         {
+            if (instance2->vertices[i] != v)
+            {
+               if ((j == instance->numVertices) ||
+                   (instance2->vertices[i] != instance->vertices[j]))
+                  same = FALSE;
+               j++;
+            }
+         }
+         if (j != instance->numVertices)
+            same = FALSE;
+         if (same)
+            return TRUE;
+      }
+      instanceListNode = instanceListNode->nextInBucket;
+   }
+   return FALSE;
+}
+
+
+//******************************************************************************
+// NAME: IndexInstanceList
+//
+// INPUTS: (InstanceList *instanceList) - list to index
+//         (ULONG numBuckets) - number of buckets in new index
+//
+// RETURN: (void)
+//
+// PURPOSE: (Re)build the hash index of the given instance list with the
+// given number of buckets.
+//******************************************************************************
+
+void IndexInstanceList(InstanceList *instanceList, ULONG numBuckets)
+{
+   InstanceListNode *instanceListNode;
+   ULONG bucket;
+   ULONG i;
+   BOOLEAN hashed = (instanceList->buckets != NULL);
+
+   free(instanceList->buckets);
+   instanceList->buckets =
+      (InstanceListNode **) malloc(sizeof(InstanceListNode *) * numBuckets);
+   if (instanceList->buckets == NULL)
+      OutOfMemoryError("IndexInstanceList:instanceList->buckets");
+   instanceList->numBuckets = numBuckets;
+   for (i = 0; i < numBuckets; i++)
+      instanceList->buckets[i] = NULL;
+
+   instanceListNode = instanceList->head;
+   while (instanceListNode != NULL)
+   {
+      // nodes inserted since the index was first built are already hashed
+      if (! hashed)
+         instanceListNode->hash = InstanceHash(instanceListNode->instance);
+      bucket = instanceListNode->hash % numBuckets;
+      instanceListNode->nextInBucket = instanceList->buckets[bucket];
+      instanceList->buckets[bucket] = instanceListNode;
+      instanceListNode = instanceListNode->next;
+   }
+}
+
 //******************************************************************************
 // NAME: InstanceMatch
 //
@@ -996,23 +1849,25 @@ BOOLEAN InstanceOverlap(Instance *instance1, Instance *instance2)
 // RETURN: (BOOLEAN)
 //
 // PURPOSE: Check if given instance overlaps at all with any instance
-// in the given instance list.
+// in the given instance list.  The first check builds the list's vertex
+// set, after which only the instance's own vertices are looked up.
 //******************************************************************************
 
 BOOLEAN InstanceListOverlap(Instance *instance, InstanceList *instanceList)
 {
-   InstanceListNode *instanceListNode;
+   ULONG v;
+   ULONG slot;
    BOOLEAN overlap = FALSE;
 
    if (instanceList != NULL) 
    {
-      instanceListNode = instanceList->head;
-      while ((instanceListNode != NULL) && (! overlap)) 
+      if (instanceList->vertexSet == NULL)
+         IndexInstanceVertices(instanceList, VERTEX_SET_SIZE);
+      for (v = 0; ((v < instance->numVertices) && (! overlap)); v++)
       {
-         if (instanceListNode->instance != NULL)
-            if (InstanceOverlap(instance, instanceListNode->instance))
-               overlap = TRUE;
-         instanceListNode = instanceListNode->next;
+         slot = VertexSetSlot(instanceList, instance->vertices[v]);
+         if (instanceList->vertexSet[slot] == instance->vertices[v])
+            overlap = TRUE;
       }
    }
    return overlap;
@@ -1027,34 +1882,132 @@ BOOLEAN InstanceListOverlap(Instance *instance, InstanceList *instanceList)
 // RETURN: (BOOLEAN) - TRUE if any pair of instances overlap
 //
 // PURPOSE: Check if any two instances in the given list overlap.  If
-// so, return TRUE, else return FALSE.
+// so, return TRUE, else return FALSE.  Since an instance has no repeated
+// vertices, instances overlap exactly when the list's vertex set holds
+// fewer vertices than the instances do in total.
 //******************************************************************************
 
 BOOLEAN InstancesOverlap(InstanceList *instanceList)
 {
-   InstanceListNode *instanceListNode1;
-   InstanceListNode *instanceListNode2;
-   BOOLEAN overlap = FALSE;
+   InstanceListNode *instanceListNode;
+   ULONG numVertices = 0;
 
-   if (instanceList != NULL) 
+   if (instanceList == NULL) 
+      return FALSE;
+   if (instanceList->vertexSet == NULL)
+      IndexInstanceVertices(instanceList, VERTEX_SET_SIZE);
+   instanceListNode = instanceList->head;
+   while (instanceListNode != NULL) 
    {
-      instanceListNode1 = instanceList->head;
-      while ((instanceListNode1 != NULL) && (! overlap)) 
-      {
-         instanceListNode2 = instanceListNode1->next;
-         while ((instanceListNode2 != NULL) && (! overlap)) 
-         {
-            if ((instanceListNode1->instance != NULL) &&
-                (instanceListNode2->instance != NULL) &&
-                (InstanceOverlap(instanceListNode1->instance,
-               instanceListNode2->instance)))
-            overlap = TRUE;
-            instanceListNode2 = instanceListNode2->next;
-         }
-         instanceListNode1 = instanceListNode1->next;
-      }
+      if (instanceListNode->instance != NULL)
+         numVertices += instanceListNode->instance->numVertices;
+      instanceListNode = instanceListNode->next;
+   }
+   return (numVertices > instanceList->numSetVertices);
+}
+
+
+//******************************************************************************
+// NAME: IndexInstanceVertices
+//
+// INPUTS: (InstanceList *instanceList) - list to index
+//         (ULONG size) - number of slots in new vertex set (a power of 2)
+//
+// RETURN: (void)
+//
+// PURPOSE: (Re)build the set of vertices covered by the instances of the
+// given list.  Must be done before the list is checked for overlap by
+// several threads at once.
+//******************************************************************************
+
+void IndexInstanceVertices(InstanceList *instanceList, ULONG size)
+{
+   InstanceListNode *instanceListNode;
+   Instance *instance;
+   ULONG v;
+
+   // make room for every vertex without growing the set again
+   v = 0;
+   instanceListNode = instanceList->head;
+   while (instanceListNode != NULL)
+   {
+      if (instanceListNode->instance != NULL)
+         v += instanceListNode->instance->numVertices;
+      instanceListNode = instanceListNode->next;
+   }
+   while ((2 * v) > size)
+      size *= 2;
+
+   free(instanceList->vertexSet);
+   instanceList->vertexSet = (ULONG *) malloc(sizeof(ULONG) * size);
+   if (instanceList->vertexSet == NULL)
+      OutOfMemoryError("IndexInstanceVertices:instanceList->vertexSet");
+   instanceList->vertexSetSize = size;
+   instanceList->numSetVertices = 0;
+   for (v = 0; v < size; v++)
+      instanceList->vertexSet[v] = VERTEX_UNMAPPED;
+
+   instanceListNode = instanceList->head;
+   while (instanceListNode != NULL)
+   {
+      instance = instanceListNode->instance;
+      if (instance != NULL)
+         for (v = 0; v < instance->numVertices; v++)
+            AddVertexToSet(instanceList, instance->vertices[v]);
+      instanceListNode = instanceListNode->next;
+   }
+}
+
+
+//******************************************************************************
+// NAME: VertexSetSlot
+//
+// INPUTS: (InstanceList *instanceList) - list whose vertex set to search
+//         (ULONG vertex) - vertex to look for
+//
+// RETURN: (ULONG) - slot holding vertex, or empty slot where it would go
+//
+// PURPOSE: Find the vertex in the list's vertex set by linear probing.
+//******************************************************************************
+
+ULONG VertexSetSlot(InstanceList *instanceList, ULONG vertex)
+{
+   ULONG mask = instanceList->vertexSetSize - 1;
+   ULONG slot;
+
+   slot = vertex * 2654435761UL;
+   slot = (slot ^ (slot >> 16)) & mask;
+   while ((instanceList->vertexSet[slot] != VERTEX_UNMAPPED) &&
+          (instanceList->vertexSet[slot] != vertex))
+      slot = (slot + 1) & mask;
+   return slot;
+}
+
+
+//******************************************************************************
+// NAME: AddVertexToSet
+//
+// INPUTS: (InstanceList *instanceList) - list whose vertex set to add to
+//         (ULONG vertex) - vertex to add
+//
+// RETURN: (void)
+//
+// PURPOSE: Add the vertex to the list's vertex set, if not already there,
+// doubling the set when it becomes half full.
+//******************************************************************************
+
+void AddVertexToSet(InstanceList *instanceList, ULONG vertex)
+{
+   ULONG slot;
+
+   slot = VertexSetSlot(instanceList, vertex);
+   if (instanceList->vertexSet[slot] == VERTEX_UNMAPPED)
+   {
+      instanceList->vertexSet[slot] = vertex;
+      instanceList->numSetVertices++;
+      if ((2 * instanceList->numSetVertices) > instanceList->vertexSetSize)
+         IndexInstanceVertices(instanceList, 2 * instanceList->vertexSetSize);
    }
-   return overlap;
 }
 
 
@@ -1090,7 +2043,6 @@ Graph *InstanceToGraph(Instance *instance, Graph *graph)
       newGraph->vertices[i].label = vertex->label;
       newGraph->vertices[i].numEdges = 0;
       newGraph->vertices[i].edges = NULL;
-      newGraph->vertices[i].used = FALSE;
    }
 
    // convert edges
@@ -1120,7 +2072,6 @@ Graph *InstanceToGraph(Instance *instance, Graph *graph)
       newGraph->edges[i].vertex2 = v2;
       newGraph->edges[i].label = edge->label;
       newGraph->edges[i].directed = edge->directed;
-      newGraph->edges[i].used = FALSE;
       // add edge to appropriate vertices
       vertex = & newGraph->vertices[v1];
       vertex->numEdges++;
@@ -1144,6 +2095,108 @@ Graph *InstanceToGraph(Instance *instance, Graph *graph)
 }
 
 
+//******************************************************************************
+// NAME: InstanceToMatchGraph
+//
+// INPUTS: (Instance *instance) - instance to convert
+//         (Graph *graph) - graph containing instance
+//         (MatchContext *context) - match context whose instance graph is
+//                                   filled in
+//
+// RETURN: (Graph *) - graph of instance, owned by context
+//
+// PURPOSE: Same as InstanceToGraph, but fills in the instance graph kept in
+// the match context, reusing its memory, rather than allocating a new graph.
+// Used when an instance is converted only to be matched.  The graph remains
+// valid until the next call with the same context, and must not be freed.
+// NOTE: instance vertices array is assumed to be in increasing order.
+//******************************************************************************
+
+Graph *InstanceToMatchGraph(Instance *instance, Graph *graph,
+                            MatchContext *context)
+{
+   Graph *newGraph;
+   Vertex *vertex;
+   Edge *edge;
+   ULONG numVertices = instance->numVertices;
+   ULONG numEdges = instance->numEdges;
+   ULONG i;
+   ULONG v1, v2;
+   ULONG offset;
+
+   newGraph = context->instanceGraph;
+   if (numVertices > context->instanceVertexListSize)
+   {
+      newGraph->vertices = (Vertex *)
+         realloc(newGraph->vertices, sizeof(Vertex) * numVertices);
+      if (newGraph->vertices == NULL)
+         OutOfMemoryError("InstanceToMatchGraph:newGraph->vertices");
+      context->instanceVertexListSize = numVertices;
+   }
+   if (numEdges > context->instanceEdgeListSize)
+   {
+      newGraph->edges = (Edge *)
+         realloc(newGraph->edges, sizeof(Edge) * numEdges);
+      if (newGraph->edges == NULL)
+         OutOfMemoryError("InstanceToMatchGraph:newGraph->edges");
+      // each edge appears in at most two edge lists
+      context->instanceEdgeLists = (ULONG *)
+         realloc(context->instanceEdgeLists, sizeof(ULONG) * 2 * numEdges);
+      if (context->instanceEdgeLists == NULL)
+         OutOfMemoryError("InstanceToMatchGraph:instanceEdgeLists");
+      context->instanceEdgeListSize = numEdges;
+   }
+   FreeGraphFingerprint(newGraph);
+   newGraph->numVertices = numVertices;
+   newGraph->numEdges = numEdges;
+
+   // convert vertices
+   for (i = 0; i < numVertices; i++)
+   {
+      vertex = & graph->vertices[instance->vertices[i]];
+      newGraph->vertices[i].label = vertex->label;
+      newGraph->vertices[i].numEdges = 0;
+   }
+
+   // convert edges, counting the edges of each vertex
+   for (i = 0; i < numEdges; i++)
+   {
+      edge = & graph->edges[instance->edges[i]];
+      v1 = FindULONG(instance->vertices, numVertices, edge->vertex1);
+      v2 = FindULONG(instance->vertices, numVertices, edge->vertex2);
+      newGraph->edges[i].vertex1 = v1;
+      newGraph->edges[i].vertex2 = v2;
+      newGraph->edges[i].label = edge->label;
+      newGraph->edges[i].directed = edge->directed;
+      newGraph->vertices[v1].numEdges++;
+      if (v1 != v2)
+         newGraph->vertices[v2].numEdges++;
+   }
+
+   // fill in edge lists, in the same order as InstanceToGraph
+   offset = 0;
+   for (i = 0; i < numVertices; i++)
+   {
+      newGraph->vertices[i].edges = & context->instanceEdgeLists[offset];
+      offset += newGraph->vertices[i].numEdges;
+      newGraph->vertices[i].numEdges = 0;
+   }
+   for (i = 0; i < numEdges; i++)
+   {
+      v1 = newGraph->edges[i].vertex1;
+      v2 = newGraph->edges[i].vertex2;
+      vertex = & newGraph->vertices[v1];
+      vertex->edges[vertex->numEdges++] = i;
+      if (v1 != v2)
+      {
+         vertex = & newGraph->vertices[v2];
+         vertex->edges[vertex->numEdges++] = i;
+      }
+   }
+   return newGraph;
+}
+
+
 //******************************************************************************
 // NAME: InstanceContainsVertex
 //
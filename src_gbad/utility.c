@@ -68,7 +68,164 @@ Substructure *CopySub(Substructure *sub)
    newSub->posIncrementValue = sub->posIncrementValue;
    newSub->value = sub->value;
    newSub->numInstances = sub->numInstances;
+   newSub->numExamples = sub->numExamples;
    newSub->instances = NULL;
+   newSub->numParentInstances = 0;
+   newSub->parentInstances = NULL;
+   newSub->instanceScale = sub->instanceScale;
 
    return(newSub);
 }
+
+
+//******************************************************************************
+// NAME: CompareULONGs
+//
+// INPUTS: (const void *p1)
+//         (const void *p2) - ULONGs to compare
+//
+// RETURN: (int) - negative, zero or positive as p1 is less than, equal to
+//                 or greater than p2
+//
+// PURPOSE: qsort comparison for ULONG arrays.
+//******************************************************************************
+
+int CompareULONGs(const void *p1, const void *p2)
+{
+   ULONG u1 = *((const ULONG *) p1);
+   ULONG u2 = *((const ULONG *) p2);
+
+   if (u1 != u2)
+      return (u1 < u2) ? -1 : 1;
+   return 0;
+}
+
+
+//******************************************************************************
+// NAME: SortUnique
+//
+// INPUTS: (ULONG *array) - values to sort
+//         (ULONG n) - number of values
+//
+// RETURN: (ULONG) - number of unique values left at start of array
+//
+// PURPOSE: Sort the array and remove duplicate values.
+//******************************************************************************
+
+ULONG SortUnique(ULONG *array, ULONG n)
+{
+   ULONG i;
+   ULONG numUnique = 0;
+
+   if (n > 1)
+      qsort(array, n, sizeof(ULONG), CompareULONGs);
+   for (i = 0; i < n; i++)
+      if ((numUnique == 0) || (array[i] != array[numUnique - 1]))
+         array[numUnique++] = array[i];
+   return numUnique;
+}
+
+
+//******************************************************************************
+// NAME: FindULONG
+//
+// INPUTS: (ULONG *array) - sorted values without duplicates
+//         (ULONG n) - number of values
+//         (ULONG value) - value to find
+//
+// RETURN: (ULONG) - index of value in array, or n if not found
+//
+// PURPOSE: Binary search for a value in a sorted array.
+//******************************************************************************
+
+ULONG FindULONG(ULONG *array, ULONG n, ULONG value)
+{
+   ULONG low = 0;
+   ULONG high = n;
+   ULONG middle;
+
+   while (low < high)
+   {
+      middle = low + ((high - low) / 2);
+      if (array[middle] == value)
+         return middle;
+      if (array[middle] < value)
+         low = middle + 1;
+      else
+         high = middle;
+   }
+   return n;
+}
+
+
+//******************************************************************************
+// NAME: NumCommonULONGs
+//
+// INPUTS: (ULONG *array1)
+//         (ULONG n1)
+//         (ULONG *array2)
+//         (ULONG n2) - sorted values and their numbers
+//
+// RETURN: (ULONG) - number of values the two arrays have in common,
+//                   counting repeated values as often as in both arrays
+//
+// PURPOSE: Size of the intersection of two sorted multisets.
+//******************************************************************************
+
+ULONG NumCommonULONGs(ULONG *array1, ULONG n1, ULONG *array2, ULONG n2)
+{
+   ULONG i = 0;
+   ULONG j = 0;
+   ULONG numCommon = 0;
+
+   while ((i < n1) && (j < n2))
+   {
+      if (array1[i] < array2[j])
+         i++;
+      else if (array1[i] > array2[j])
+         j++;
+      else
+      {
+         numCommon++;
+         i++;
+         j++;
+      }
+   }
+   return numCommon;
+}
+
+
+//******************************************************************************
+// NAME: RunWorkerThreads
+//
+// INPUTS: (void *(*worker)(void *)) - thread function
+//         (void *queue) - work queue shared by the threads
+//         (ULONG numThreads) - number of threads
+//         (char *context) - caller, for the error message
+//
+// RETURN: (void)
+//
+// PURPOSE: Run numThreads threads of the worker function on the queue,
+// and wait for all of them to finish.  Exits if a thread cannot be
+// created.
+//******************************************************************************
+
+void RunWorkerThreads(void *(*worker)(void *), void *queue, ULONG numThreads,
+                      char *context)
+{
+   pthread_t *threads;
+   ULONG t;
+
+   threads = (pthread_t *) malloc(sizeof(pthread_t) * numThreads);
+   if (threads == NULL)
+      OutOfMemoryError("RunWorkerThreads:threads");
+   for (t = 0; t < numThreads; t++)
+      if (pthread_create(& threads[t], NULL, worker, queue) != 0)
+      {
+         fprintf(stderr, "%s: unable to create thread\n", context);
+         exit(1);
+      }
+   for (t = 0; t < numThreads; t++)
+      pthread_join(threads[t], NULL);
+   free(threads);
+}